@@ -13,8 +13,15 @@
 
 #include <alsa/asoundlib.h>
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef struct tsig_cfg tsig_cfg_t;
+typedef struct tsig_coherent tsig_coherent_t;
+typedef struct tsig_governor tsig_governor_t;
+typedef struct tsig_jitter tsig_jitter_t;
 typedef struct tsig_log tsig_log_t;
+typedef struct tsig_profile tsig_profile_t;
 
 /** ALSA output context. */
 typedef struct tsig_alsa {
@@ -30,9 +37,19 @@ typedef struct tsig_alsa {
 
   snd_pcm_uframes_t start_threshold; /** Start threshold. */
   snd_pcm_uframes_t avail_min;       /** Fill threshold. */
+  bool has_tstamp;                   /** Whether positions are timestamped. */
+
+  bool is_tsched;                /** Whether scheduled by timer. */
+  snd_pcm_uframes_t fill_target; /** Fill level to top up to by timer. */
+  snd_pcm_uframes_t watermark;   /** Fill level to wake up at by timer. */
+  int64_t watermark_calm;        /** Monotonic time to lower watermark in ns. */
 
   tsig_audio_format_t audio_format; /** Sample format ID. */
   unsigned timeout;                 /** User timeout in seconds. */
+  tsig_jitter_t *jitter;            /** Edge timing measurement context. */
+  tsig_coherent_t *coherent;        /** Phase-coherent timing context. */
+  tsig_profile_t *profile;          /** Pipeline stage profiling context. */
+  tsig_governor_t *governor;        /** Adaptive output quality context. */
   tsig_log_t *log;                  /** Logging context. */
 } tsig_alsa_t;
 
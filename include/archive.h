@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * archive.h: Header for minute-frame archive facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "station.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of an archive header in bytes. */
+#define TSIG_ARCHIVE_HEADER_SIZE 32
+
+/** Maximum number of days in an archive. */
+#define TSIG_ARCHIVE_DAYS_MAX 36525
+
+/** Maximum number of distinct per-second symbols in an archive. */
+#define TSIG_ARCHIVE_SYMBOLS_MAX 256
+
+typedef struct tsig_log tsig_log_t;
+
+/** Memory-mapped minute-frame archive. */
+typedef struct tsig_archive {
+  const uint8_t *map; /** Mapped archive file. */
+  size_t size;        /** Size of mapped archive file. */
+
+  tsig_station_id_t station; /** Time station ID. */
+  int16_t dut1;              /** DUT1 value in milliseconds. */
+  int64_t timestamp;         /** Station time at start of first minute. */
+  uint32_t minutes;          /** Minute count. */
+
+  uint8_t symbol_bits;    /** Size of a symbol code in bits. */
+  uint16_t symbol_count;  /** Distinct symbol count. */
+  uint16_t record_size;   /** Size of a minute record in bytes. */
+  const uint8_t *records; /** Minute records. */
+
+  /** Per-tick transmit level flags for a second, indexed by symbol code. */
+  uint32_t symbols[TSIG_ARCHIVE_SYMBOLS_MAX];
+
+  tsig_log_t *log; /** Logging context. */
+} tsig_archive_t;
+
+int tsig_archive_open(tsig_archive_t *archive, const char *path,
+                      tsig_station_t *station, tsig_log_t *log);
+void tsig_archive_close(tsig_archive_t *archive);
+bool tsig_archive_lookup(const tsig_archive_t *archive, int64_t timestamp,
+                         uint8_t xmit_level[], uint8_t *flags);
+int tsig_archive_write(tsig_station_t *station, const char *path,
+                       int64_t timestamp, uint32_t minutes, tsig_log_t *log);
@@ -40,6 +40,12 @@ typedef enum tsig_audio_format {
   TSIG_AUDIO_FORMAT_FLOAT64,
   TSIG_AUDIO_FORMAT_FLOAT64_LE,
   TSIG_AUDIO_FORMAT_FLOAT64_BE,
+  TSIG_AUDIO_FORMAT_S24_3,
+  TSIG_AUDIO_FORMAT_S24_3LE,
+  TSIG_AUDIO_FORMAT_S24_3BE,
+  TSIG_AUDIO_FORMAT_U24_3,
+  TSIG_AUDIO_FORMAT_U24_3LE,
+  TSIG_AUDIO_FORMAT_U24_3BE,
 } tsig_audio_format_t;
 
 /** Recognized sample rates. */
@@ -55,14 +61,51 @@ typedef enum tsig_audio_rate {
   TSIG_AUDIO_RATE_384000 = 384000,
 } tsig_audio_rate_t;
 
+/** Sample conversion kernels. */
+typedef enum tsig_audio_kernel {
+  TSIG_AUDIO_KERNEL_UNKNOWN = -1,
+  TSIG_AUDIO_KERNEL_GENERIC,     /** Any format, checked for each sample. */
+  TSIG_AUDIO_KERNEL_SPECIALIZED, /** Compiled for one specific format. */
+  TSIG_AUDIO_KERNELS,            /** Count of kernels. */
+} tsig_audio_kernel_t;
+
+/** Default sample format and rate, which a minimal build may fix. */
+#ifdef TSIG_AUDIO_FORMAT_ONLY
+#define TSIG_AUDIO_FORMAT_DEFAULT TSIG_AUDIO_FORMAT_ONLY
+#else
+#define TSIG_AUDIO_FORMAT_DEFAULT TSIG_AUDIO_FORMAT_S16
+#endif /* TSIG_AUDIO_FORMAT_ONLY */
+
+#ifdef TSIG_AUDIO_RATE_ONLY
+#define TSIG_AUDIO_RATE_DEFAULT TSIG_AUDIO_RATE_ONLY
+#else
+#define TSIG_AUDIO_RATE_DEFAULT TSIG_AUDIO_RATE_48000
+#endif /* TSIG_AUDIO_RATE_ONLY */
+
+/*
+ * Generate samples in fixed-point on CPUs with slow double-precision math,
+ * i.e. ARMv6 and older, unless the build says otherwise.
+ */
+#if !defined(TSIG_USE_FIXED_POINT) && !defined(TSIG_NO_FIXED_POINT) && \
+    defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH < 7
+#define TSIG_USE_FIXED_POINT
+#endif /* __ARM_ARCH */
+
+/** Generated sample, a 64-bit float in [-1.0, 1.0] or Q15 fixed-point. */
+#ifdef TSIG_USE_FIXED_POINT
+typedef int32_t tsig_audio_sample_t;
+#else
+typedef double tsig_audio_sample_t;
+#endif /* TSIG_USE_FIXED_POINT */
+
 /**
  * Pointer to sample generator callback function.
  *
  * @param cb_data Callback function context object.
- * @param[out] out_cb_buf Buffer to be filled with 1ch 64-bit float samples.
+ * @param[out] out_cb_buf Buffer to be filled with 1ch generated samples.
  * @param size Count of samples to be generated.
  */
-typedef void (*tsig_audio_cb_t)(void *cb_data, double out_cb_buf[],
+typedef void (*tsig_audio_cb_t)(void *cb_data, tsig_audio_sample_t out_cb_buf[],
                                 uint32_t size);
 
 tsig_audio_format_t tsig_audio_format(const char *name);
@@ -70,5 +113,19 @@ const char *tsig_audio_format_name(tsig_audio_format_t format);
 size_t tsig_audio_format_phys_width(tsig_audio_format_t format);
 tsig_audio_rate_t tsig_audio_rate(const char *name);
 void tsig_audio_fill_buffer(tsig_audio_format_t format, uint32_t channels,
-                            uint64_t size, uint8_t buf[], double cb_buf[]);
+                            uint64_t size, uint8_t buf[],
+                            tsig_audio_sample_t cb_buf[]);
+void tsig_audio_fill_buffer_f64(tsig_audio_format_t format, uint32_t channels,
+                                uint64_t size, uint8_t buf[],
+                                const double cb_buf[]);
+void tsig_audio_fill_buffer_q15(tsig_audio_format_t format, uint32_t channels,
+                                uint64_t size, uint8_t buf[],
+                                const int32_t cb_buf[]);
+bool tsig_audio_fill_buffer_kernel(tsig_audio_kernel_t kernel,
+                                   tsig_audio_format_t format,
+                                   uint32_t channels, uint64_t size,
+                                   uint8_t buf[], tsig_audio_sample_t cb_buf[]);
+tsig_audio_kernel_t tsig_audio_kernel(const char *name);
+const char *tsig_audio_kernel_name(tsig_audio_kernel_t kernel);
+void tsig_audio_set_kernel(tsig_audio_kernel_t kernel);
 bool tsig_audio_is_cpu_le(void);
@@ -29,6 +29,14 @@ typedef enum tsig_backend {
 #ifdef TSIG_HAVE_ALSA
   TSIG_BACKEND_ALSA,
 #endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  TSIG_BACKEND_PLUGIN,
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  TSIG_BACKEND_FILE,
+#endif /* TSIG_HAVE_FILE */
 } tsig_backend_t;
 
 /**
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * binlog.h: Header for binary logging facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Binary log file, header, and format string dictionary sizes in bytes. */
+#define TSIG_BINLOG_SIZE        1048576
+#define TSIG_BINLOG_HEADER_SIZE 128
+#define TSIG_BINLOG_DICT_SIZE   65536
+
+/** Maximum number of distinct format strings per run. Must be 2^n. */
+#define TSIG_BINLOG_FORMATS 512
+
+/** Maximum number of arguments per message. */
+#define TSIG_BINLOG_ARGS_MAX 16
+
+/** Maximum record size in bytes. */
+#define TSIG_BINLOG_RECORD_SIZE 512
+
+typedef struct tsig_log tsig_log_t;
+
+/** Format string seen during this run. */
+typedef struct tsig_binlog_format {
+  const char *fmt;                 /** Format string, or NULL if unused. */
+  uint16_t id;                     /** Format string ID. */
+  uint16_t arg_size;               /** Argument size, less string contents. */
+  uint8_t arg_count;               /** Argument count. */
+  char args[TSIG_BINLOG_ARGS_MAX]; /** Argument types. */
+} tsig_binlog_format_t;
+
+/** Binary log context. */
+typedef struct tsig_binlog {
+  uint8_t *map;  /** Mapped binary log file. */
+  uint8_t *dict; /** Format string dictionary within mapping. */
+  uint8_t *ring; /** Record ring within mapping. */
+
+  tsig_binlog_format_t formats[TSIG_BINLOG_FORMATS]; /** Format strings. */
+} tsig_binlog_t;
+
+int tsig_binlog_open(tsig_binlog_t *binlog, const char *path);
+void tsig_binlog_write(tsig_binlog_t *binlog, int level, const char *fmt,
+                       va_list params);
+void tsig_binlog_close(tsig_binlog_t *binlog);
+int tsig_binlog_print(const char *path, FILE *file, tsig_log_t *log);
@@ -39,6 +39,7 @@ typedef struct tsig_cfg {
   int64_t base;              /** Time base in milliseconds since epoch. */
   int32_t offset;            /** User offset in milliseconds. */
   int16_t dut1;              /** DUT1 value in milliseconds. */
+  bool coherent;             /** Whether to tie output to absolute time. */
 
   unsigned timeout; /** User timeout in seconds. */
 
@@ -49,20 +50,40 @@ typedef struct tsig_cfg {
 
 #ifdef TSIG_HAVE_ALSA
   char device[TSIG_CFG_DEVICE_SIZE]; /** ALSA device. */
+  bool tsched;                       /** Whether to schedule ALSA by timer. */
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_PLUGIN
+  char plugin[TSIG_CFG_PATH_SIZE]; /** Path to output sink plugin. */
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  char file[TSIG_CFG_PATH_SIZE]; /** Path to render raw output to. */
+  bool direct;                   /** Whether to bypass the page cache. */
+#endif /* TSIG_HAVE_FILE */
+
   tsig_audio_format_t format; /** Sample format. */
   uint32_t rate;              /** Sample rate. */
   uint16_t channels;          /** Channel count. */
   bool smooth;                /** Whether to interpolate rapid gain changes. */
   bool ultrasound;            /** Whether to allow ultrasound output. */
   bool audible;               /** Whether to make output waveform audible. */
+  bool governor;              /** Whether to adapt output quality to load. */
   /* clang-format on */
 
+  char wisdom[TSIG_CFG_PATH_SIZE];   /** Path to kernel planning wisdom. */
+  char serve[TSIG_CFG_PATH_SIZE];    /** Socket path, or "pty", to serve. */
+  char archive[TSIG_CFG_PATH_SIZE];  /** Path to minute-frame archive. */
+  uint16_t archive_days;             /** Days of minute frames to archive. */
   char log_file[TSIG_CFG_PATH_SIZE]; /** Path to log file. */
+  char binlog[TSIG_CFG_PATH_SIZE];   /** Path to binary log file. */
+  bool print_binlog;                 /** Whether to print the binary log. */
   bool syslog;                       /** Whether to log to syslog. */
   bool verbose;                      /** Whether to be verbose. */
   bool quiet;                        /** Whether to log nothing to console. */
+  bool jitter;                       /** Whether to measure edge timing. */
+  bool profile;                      /** Whether to profile pipeline stages. */
+  char recorder[TSIG_CFG_PATH_SIZE]; /** Path to flight recorder dump file. */
 } tsig_cfg_t;
 
 tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
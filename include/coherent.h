@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * coherent.h: Header for phase-coherent timing facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct tsig_log tsig_log_t;
+
+/** Phase-coherent timing context. */
+typedef struct tsig_coherent {
+  uint32_t rate;   /** Sample rate. */
+  uint64_t frames; /** Count of frames generated. */
+
+  bool has_anchor;       /** Whether a playback timing anchor was reported. */
+  uint64_t anchor_frame; /** Count of frames generated as of the anchor. */
+  int64_t anchor_time;   /** System time in ns at which anchor_frame plays. */
+
+  tsig_log_t *log; /** Logging context. */
+} tsig_coherent_t;
+
+void tsig_coherent_init(tsig_coherent_t *coherent, uint32_t rate,
+                        tsig_log_t *log);
+void tsig_coherent_advance(tsig_coherent_t *coherent, uint32_t size);
+void tsig_coherent_anchor(tsig_coherent_t *coherent, int64_t timestamp,
+                          int64_t delay);
+int64_t tsig_coherent_next(const tsig_coherent_t *coherent);
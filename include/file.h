@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * file.h: Header for raw file output facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "audio.h"
+#include "writer.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct tsig_cfg tsig_cfg_t;
+typedef struct tsig_log tsig_log_t;
+typedef struct tsig_profile tsig_profile_t;
+
+/** Raw file output context. */
+typedef struct tsig_file {
+  const char *path;     /** File path. */
+  tsig_writer_t writer; /** Asynchronous file writing context. */
+  bool is_direct;       /** Whether to bypass the page cache. */
+
+  tsig_audio_format_t audio_format; /** Sample format ID. */
+  uint32_t rate;                    /** Sample rate. */
+  uint32_t channels;                /** Channel count. */
+  uint32_t period_size;             /** Frames generated at a time. */
+  uint32_t stride;                  /** Size of one frame in bytes. */
+
+  unsigned timeout;        /** Duration to render in seconds. */
+  tsig_profile_t *profile; /** Pipeline stage profiling context. */
+  tsig_log_t *log;         /** Logging context. */
+} tsig_file_t;
+
+int tsig_file_lib_init(tsig_log_t *log);
+int tsig_file_init(tsig_file_t *file, tsig_cfg_t *cfg, tsig_log_t *log);
+int tsig_file_loop(tsig_file_t *file, tsig_audio_cb_t cb, void *cb_data);
+int tsig_file_deinit(tsig_file_t *file);
+int tsig_file_lib_deinit(tsig_log_t *log);
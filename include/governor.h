@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * governor.h: Header for adaptive output quality facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "audio.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Size of a table of one waveform period in samples. */
+#define TSIG_GOVERNOR_CACHE_SIZE 8192
+
+typedef struct tsig_log tsig_log_t;
+
+/** Output quality levels, from most to least expensive. */
+typedef enum tsig_governor_level {
+  TSIG_GOVERNOR_FULL,      /** Output as configured. */
+  TSIG_GOVERNOR_NO_SMOOTH, /** Gain smoothing off. */
+  TSIG_GOVERNOR_CACHED,    /** Sine wave from a table of one period. */
+  TSIG_GOVERNOR_SQUARE,    /** Square wave. */
+  TSIG_GOVERNOR_LEVELS,    /** Count of levels. */
+} tsig_governor_level_t;
+
+/** Adaptive output quality context. */
+typedef struct tsig_governor {
+  tsig_governor_level_t level; /** Current output quality level. */
+  uint32_t rate;               /** Sample rate. */
+
+  int64_t started; /** Monotonic time the current callback started in ns. */
+  uint32_t load;   /** Worst callback load this minute in permille. */
+  uint32_t xruns;  /** Count of xruns this minute. */
+  uint32_t calm;   /** Count of consecutive minutes with headroom. */
+
+  uint64_t transitions; /** Count of level changes. */
+  uint64_t xruns_total; /** Count of xruns. */
+
+  /** Table of one waveform period, for TSIG_GOVERNOR_CACHED. */
+  tsig_audio_sample_t cache[TSIG_GOVERNOR_CACHE_SIZE];
+
+  tsig_log_t *log; /** Logging context. */
+} tsig_governor_t;
+
+void tsig_governor_init(tsig_governor_t *governor, uint32_t rate,
+                        tsig_log_t *log);
+void tsig_governor_begin(tsig_governor_t *governor);
+void tsig_governor_end(tsig_governor_t *governor, uint32_t size);
+void tsig_governor_xrun(tsig_governor_t *governor);
+tsig_governor_level_t tsig_governor_update(tsig_governor_t *governor,
+                                           uint32_t levels);
+void tsig_governor_print(const tsig_governor_t *governor);
@@ -22,10 +22,22 @@ typedef struct tsig_iir {
   double init_y0;  /** First sample value. */
   double init_y1;  /** Second sample value. */
 
+  uint32_t delta;  /** Phase change per sample as a fraction of period. */
+  uint32_t angle;  /** Current phase as a fraction of period. */
   uint32_t sample; /** Current sample number in period. */
   double y0;       /** Current sample value. */
   double y1;       /** Next sample value. */
+
+  int32_t a_q30;       /** Filter coefficient A in Q30 fixed-point. */
+  int32_t init_y0_q30; /** First sample value in Q30 fixed-point. */
+  int32_t init_y1_q30; /** Second sample value in Q30 fixed-point. */
+  int32_t y0_q30;      /** Current sample value in Q30 fixed-point. */
+  int32_t y1_q30;      /** Next sample value in Q30 fixed-point. */
 } tsig_iir_t;
 
 void tsig_iir_init(tsig_iir_t *iir, uint32_t freq, uint32_t rate, int phase);
 double tsig_iir_next(tsig_iir_t *iir);
+int32_t tsig_iir_next_q15(tsig_iir_t *iir);
+int tsig_iir_next_square(tsig_iir_t *iir);
+uint32_t tsig_iir_next_index(tsig_iir_t *iir);
+void tsig_iir_seek(tsig_iir_t *iir, uint32_t sample);
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * jitter.h: Header for edge timing measurement facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Histogram bin width and range (lower inclusive, upper exclusive) in us. */
+#define TSIG_JITTER_BIN_USECS 250
+#define TSIG_JITTER_MIN_USECS -250000
+#define TSIG_JITTER_MAX_USECS 1000000
+#define TSIG_JITTER_BINS \
+  ((TSIG_JITTER_MAX_USECS - TSIG_JITTER_MIN_USECS) / TSIG_JITTER_BIN_USECS)
+
+/** Maximum number of edges awaiting a playback timing anchor. */
+#define TSIG_JITTER_EDGES_MAX 64
+
+typedef struct tsig_log tsig_log_t;
+
+/** Transmit level change awaiting a playback timing anchor. */
+typedef struct tsig_jitter_edge {
+  uint64_t frame;   /** Index of first frame at new level. */
+  int64_t intended; /** Intended system time in ns since epoch. */
+} tsig_jitter_edge_t;
+
+/** Edge timing measurement context. */
+typedef struct tsig_jitter {
+  uint32_t rate;   /** Sample rate. */
+  uint64_t frames; /** Count of frames generated. */
+
+  tsig_jitter_edge_t edges[TSIG_JITTER_EDGES_MAX]; /** Pending edges. */
+  uint32_t edge_count;                             /** Pending edge count. */
+  uint64_t dropped; /** Count of edges dropped while pending. */
+
+  uint64_t count; /** Count of measured edges. */
+  int64_t min;    /** Smallest error in us. */
+  int64_t max;    /** Largest error in us. */
+  double mean;    /** Mean error in us. */
+  double m2;      /** Sum of squared differences from mean error. */
+
+  uint64_t below;                  /** Count of errors below histogram. */
+  uint64_t above;                  /** Count of errors above histogram. */
+  uint32_t bins[TSIG_JITTER_BINS]; /** Histogram of errors. */
+
+  int64_t next_report; /** System time of next summary in ns since epoch. */
+  tsig_log_t *log;     /** Logging context. */
+} tsig_jitter_t;
+
+void tsig_jitter_init(tsig_jitter_t *jitter, uint32_t rate, tsig_log_t *log);
+void tsig_jitter_edge(tsig_jitter_t *jitter, uint32_t offset,
+                      int64_t timestamp);
+void tsig_jitter_advance(tsig_jitter_t *jitter, uint32_t size);
+void tsig_jitter_anchor(tsig_jitter_t *jitter, int64_t timestamp,
+                        int64_t delay);
+int64_t tsig_jitter_percentile(const tsig_jitter_t *jitter, uint32_t permille);
+void tsig_jitter_print(const tsig_jitter_t *jitter);
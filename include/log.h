@@ -14,23 +14,29 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+typedef struct tsig_binlog tsig_binlog_t;
+
 /** Status line buffer size. */
 #define TSIG_LOG_STATUS_LINE_SIZE 256
 
 /** Maximum status line count. */
 #define TSIG_LOG_STATUS_LINES 4
 
-/** printf(3)-like syslog-compatible logging macros. */
+/**
+ * printf(3)-like syslog-compatible logging macros.
+ *
+ * A binary log records messages at every log level.
+ */
 #ifdef TSIG_DEBUG
 #define tsig_log_with_level(n, ...)                            \
   do {                                                         \
-    if (log->level >= (n))                                     \
+    if (log->level >= (n) || log->binlog)                      \
       tsig_log_msg(log, (n), __FILE__, __LINE__, __VA_ARGS__); \
   } while (0)
 #else
 #define tsig_log_with_level(n, ...)                 \
   do {                                              \
-    if (log->level >= (n))                          \
+    if (log->level >= (n) || log->binlog)           \
       tsig_log_msg(log, (n), NULL, 0, __VA_ARGS__); \
   } while (0)
 #endif /* TSIG_DEBUG */
@@ -84,11 +90,12 @@
 typedef struct tsig_log {
   int level; /** Maximum log level. */
 
-  bool console;       /** Whether to emit logs to stdout/stderr. */
-  bool is_stdout_tty; /** Whether stdout is a TTY. */
-  bool is_stderr_tty; /** Whether stderr is a TTY. */
-  FILE *log_file;     /** Log file. Will emit logs to it if not NULL. */
-  bool syslog;        /** Whether to emit logs to syslog. */
+  bool console;          /** Whether to emit logs to stdout/stderr. */
+  bool is_stdout_tty;    /** Whether stdout is a TTY. */
+  bool is_stderr_tty;    /** Whether stderr is a TTY. */
+  FILE *log_file;        /** Log file. Will emit logs to it if not NULL. */
+  bool syslog;           /** Whether to emit logs to syslog. */
+  tsig_binlog_t *binlog; /** Binary log. Will record logs to it if not NULL. */
 
   bool have_status;      /** Whether status area is enabled. */
   int status_lines;      /** Status area line count. */
@@ -98,8 +105,9 @@ typedef struct tsig_log {
 } tsig_log_t;
 
 void tsig_log_init(tsig_log_t *log);
-void tsig_log_finish_init(tsig_log_t *log, char log_file[], bool syslog,
-                          bool verbose, bool quiet);
+void tsig_log_finish_init(tsig_log_t *log, char log_file[],
+                          char binlog_file[], bool syslog, bool verbose,
+                          bool quiet);
 void tsig_log_msg(tsig_log_t *log, int level, const char *src_file,
                   int src_line, const char *fmt, ...);
 void tsig_log_msg_tty(tsig_log_t *log, const char *src_file, int src_line,
@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * plan.h: Header for startup kernel planning facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "audio.h"
+
+#include <stdint.h>
+
+/** Count of frames converted at a time by each timing run. */
+#define TSIG_PLAN_FRAMES 4800
+
+/** Count of timing runs per kernel. The fastest run counts. */
+#define TSIG_PLAN_RUNS 5
+
+/** Minimum duration of each timing run in ns, well above timer resolution. */
+#define TSIG_PLAN_RUN_NSECS 2000000
+
+/** Percentage by which a kernel must beat the generic kernel to be chosen. */
+#define TSIG_PLAN_MARGIN 10
+
+/** Size of a machine identifier. */
+#define TSIG_PLAN_MACHINE_SIZE 192
+
+/** Size of a line in a wisdom file. */
+#define TSIG_PLAN_LINE_SIZE 256
+
+typedef struct tsig_log tsig_log_t;
+
+tsig_audio_kernel_t tsig_plan(tsig_audio_format_t format, uint32_t channels,
+                              const char *wisdom, tsig_log_t *log);
@@ -0,0 +1,45 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * plugin.h: Header for output sink plugin facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "audio.h"
+#include "sink.h"
+
+typedef struct tsig_cfg tsig_cfg_t;
+typedef struct tsig_coherent tsig_coherent_t;
+typedef struct tsig_jitter tsig_jitter_t;
+typedef struct tsig_log tsig_log_t;
+typedef struct tsig_profile tsig_profile_t;
+typedef struct tsig_station tsig_station_t;
+
+/** Output sink plugin context. */
+typedef struct tsig_plugin {
+  void *lib;               /** Shared object handle. */
+  const char *path;        /** Shared object path. */
+  const tsig_sink_t *sink; /** Sink descriptor. */
+  void *sink_data;         /** Sink context object. */
+
+  tsig_sink_params_t params;        /** Stream parameters. */
+  tsig_audio_format_t audio_format; /** Sample format ID. */
+  uint32_t stride;                  /** Size of one frame in bytes. */
+
+  unsigned timeout;          /** User timeout in seconds. */
+  tsig_jitter_t *jitter;     /** Edge timing measurement context. */
+  tsig_coherent_t *coherent; /** Phase-coherent timing context. */
+  tsig_profile_t *profile;   /** Pipeline stage profiling context. */
+  tsig_station_t *station;   /** Station generating the output. */
+  tsig_log_t *log;           /** Logging context. */
+} tsig_plugin_t;
+
+int tsig_plugin_lib_init(tsig_log_t *log);
+int tsig_plugin_init(tsig_plugin_t *plugin, tsig_cfg_t *cfg, tsig_log_t *log);
+int tsig_plugin_loop(tsig_plugin_t *plugin, tsig_audio_cb_t cb, void *cb_data);
+int tsig_plugin_deinit(tsig_plugin_t *plugin);
+int tsig_plugin_lib_deinit(tsig_log_t *log);
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * profile.h: Header for pipeline stage profiling facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct tsig_log tsig_log_t;
+
+/** Profiled pipeline stages. */
+typedef enum tsig_profile_stage {
+  TSIG_PROFILE_UPDATE,  /** Per-minute station encoder (update_cb). */
+  TSIG_PROFILE_SAMPLES, /** Sample loop in tsig_station_cb(). */
+  TSIG_PROFILE_FILL,    /** Sample conversion (tsig_audio_fill_buffer()). */
+  TSIG_PROFILE_WRITE,   /** Backend write and wait. */
+  TSIG_PROFILE_STAGES,  /** Count of stages. */
+} tsig_profile_stage_t;
+
+/** Profiling counters. */
+typedef enum tsig_profile_counter {
+  TSIG_PROFILE_TASK_CLOCK,   /** CPU time in ns. */
+  TSIG_PROFILE_CYCLES,       /** CPU cycles. */
+  TSIG_PROFILE_INSTRUCTIONS, /** Instructions retired. */
+  TSIG_PROFILE_CACHE_MISSES, /** Last-level cache misses. */
+  TSIG_PROFILE_COUNTERS,     /** Count of counters. */
+} tsig_profile_counter_t;
+
+/** Source of profiling counters. */
+typedef enum tsig_profile_mode {
+  TSIG_PROFILE_MODE_NONE,     /** Counters not yet opened. */
+  TSIG_PROFILE_MODE_HARDWARE, /** perf_event hardware counters. */
+  TSIG_PROFILE_MODE_SOFTWARE, /** perf_event task clock only. */
+  TSIG_PROFILE_MODE_CPUTIME,  /** CLOCK_THREAD_CPUTIME_ID only. */
+} tsig_profile_mode_t;
+
+/** Accumulated counts for a pipeline stage. */
+typedef struct tsig_profile_stat {
+  uint64_t calls;                          /** Count of measurements. */
+  uint64_t frames;                         /** Count of frames processed. */
+  uint64_t counts[TSIG_PROFILE_COUNTERS];  /** Accumulated counter deltas. */
+  uint64_t started[TSIG_PROFILE_COUNTERS]; /** Counter values at start. */
+  bool is_started;                         /** Whether a measurement began. */
+} tsig_profile_stat_t;
+
+/** Pipeline stage profiling context. */
+typedef struct tsig_profile {
+  tsig_profile_mode_t mode;       /** Source of counters. */
+  int fds[TSIG_PROFILE_COUNTERS]; /** perf_event file descriptors. */
+  uint32_t counters;              /** Count of counters in use. */
+
+  tsig_profile_stat_t stats[TSIG_PROFILE_STAGES]; /** Per-stage counts. */
+
+  int64_t next_report; /** Monotonic time of next summary in ns. */
+  tsig_log_t *log;     /** Logging context. */
+} tsig_profile_t;
+
+void tsig_profile_init(tsig_profile_t *profile, tsig_log_t *log);
+void tsig_profile_begin(tsig_profile_t *profile, tsig_profile_stage_t stage);
+void tsig_profile_end(tsig_profile_t *profile, tsig_profile_stage_t stage,
+                      uint32_t frames);
+void tsig_profile_print(const tsig_profile_t *profile);
+void tsig_profile_deinit(tsig_profile_t *profile);
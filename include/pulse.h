@@ -16,7 +16,11 @@
 #include <stdint.h>
 
 typedef struct tsig_cfg tsig_cfg_t;
+typedef struct tsig_coherent tsig_coherent_t;
+typedef struct tsig_governor tsig_governor_t;
+typedef struct tsig_jitter tsig_jitter_t;
 typedef struct tsig_log tsig_log_t;
+typedef struct tsig_profile tsig_profile_t;
 
 /** PulseAudio output context. */
 typedef struct tsig_pulse {
@@ -28,15 +32,19 @@ typedef struct tsig_pulse {
   uint32_t rate;             /** Sample rate. */
   uint8_t channels;          /** Channel count. */
 
-  tsig_audio_cb_t cb; /** Sample generator callback. */
-  void *cb_data;      /** Sample generator callback context object. */
-  double *cb_buf;     /** Sample generator callback output buffer. */
-  uint8_t *buf;       /** Client-side PulseAudio output buffer. */
-  uint32_t stride;    /** Stride (i.e. audio frame size). */
-  uint32_t size;      /** PulseAudio output buffer size. */
+  tsig_audio_cb_t cb;          /** Sample generator callback. */
+  void *cb_data;               /** Sample generator callback context object. */
+  tsig_audio_sample_t *cb_buf; /** Sample generator callback output buffer. */
+  uint8_t *buf;                /** Client-side PulseAudio output buffer. */
+  uint32_t stride;             /** Stride (i.e. audio frame size). */
+  uint32_t size;               /** PulseAudio output buffer size. */
 
   tsig_audio_format_t audio_format; /** Sample format ID. */
   unsigned timeout;                 /** User timeout in seconds. */
+  tsig_jitter_t *jitter;            /** Edge timing measurement context. */
+  tsig_coherent_t *coherent;        /** Phase-coherent timing context. */
+  tsig_profile_t *profile;          /** Pipeline stage profiling context. */
+  tsig_governor_t *governor;        /** Adaptive output quality context. */
   tsig_log_t *log;                  /** Logging context. */
 } tsig_pulse_t;
 
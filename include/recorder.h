@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * recorder.h: Header for flight recorder facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/** Flight recorder ring size in events. Must be 2^n. */
+#define TSIG_RECORDER_EVENTS 8192
+
+/** Maximum number of dumps per run. */
+#define TSIG_RECORDER_DUMPS_MAX 32
+
+/** Flight recorder event types. */
+typedef enum tsig_recorder_type {
+  TSIG_RECORDER_NONE,   /** Unused slot. */
+  TSIG_RECORDER_CLOCK,  /** Callback started. Station time, drift in ms. */
+  TSIG_RECORDER_CB,     /** Callback finished. Samples, start time in ns. */
+  TSIG_RECORDER_UPDATE, /** Minute frame updated. Station time in ms. */
+  TSIG_RECORDER_RESYNC, /** Resynced. Station time, drift in ms. */
+  TSIG_RECORDER_WRITE,  /** Frames written. Frames, backend return value. */
+  TSIG_RECORDER_XRUN,   /** Buffer xrun. Error code. */
+  TSIG_RECORDER_SIGNAL, /** Signal received. Signal number. */
+} tsig_recorder_type_t;
+
+void tsig_recorder_init(const char *path);
+int64_t tsig_recorder_event(tsig_recorder_type_t type, int64_t a, int64_t b);
+void tsig_recorder_dump(const char *reason);
+void tsig_recorder_deinit(void);
@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * server.h: Header for minute-frame server facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include "cfg.h"
+#include "station.h"
+
+#include <stdint.h>
+
+/** Configured value that selects a pseudo-TTY instead of a Unix socket. */
+#define TSIG_SERVER_PTY "pty"
+
+/** Maximum number of simultaneously connected Unix socket clients. */
+#define TSIG_SERVER_CLIENTS 8
+
+/** Size of a minute-frame record in bytes. */
+#define TSIG_SERVER_RECORD_SIZE 184
+
+typedef struct tsig_log tsig_log_t;
+
+/** Minute-frame server context. */
+typedef struct tsig_server {
+  int listen_fd;                       /** Listening Unix socket, or -1. */
+  int pty_fd;                          /** Pseudo-TTY master, or -1. */
+  int client_fds[TSIG_SERVER_CLIENTS]; /** Connected clients, or -1. */
+
+  char path[TSIG_CFG_PATH_SIZE]; /** Socket path or pseudo-TTY slave name. */
+  unsigned timeout;              /** User timeout in seconds. */
+  tsig_log_t *log;               /** Logging context. */
+} tsig_server_t;
+
+int tsig_server_init(tsig_server_t *server, tsig_cfg_t *cfg, tsig_log_t *log);
+int tsig_server_loop(tsig_server_t *server, tsig_station_t *station);
+void tsig_server_deinit(tsig_server_t *server);
+void tsig_server_pack(uint8_t record[], const tsig_station_frame_t *frame);
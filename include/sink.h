@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * sink.h: Output sink plugin interface.
+ *
+ * An output sink plugin is a shared object that exports a function named
+ * tsig_sink_entry() of type tsig_sink_entry_t. Given `--method plugin:PATH`,
+ * timesignal loads the shared object at PATH, calls tsig_sink_entry() with the
+ * interface version it was built against, and expects a sink descriptor in
+ * return, or NULL if the plugin does not implement that version.
+ *
+ * Once open, the sink is handed blocks of frames in the negotiated format.
+ * If the sink implements get_block(), frames are converted directly into the
+ * memory it lends, e.g. a DMA buffer or a shared memory ring, and nothing is
+ * copied. Otherwise, frames are converted into a buffer owned by timesignal,
+ * which remains valid only until put_block() returns.
+ *
+ * put_block() is expected to block until the sink can take another block,
+ * which is what paces output. It may also report a playback timing anchor.
+ * Signals interrupt it, so it should return -EINTR rather than retry when a
+ * blocking call fails with EINTR. If the signal doesn't stop timesignal, the
+ * interrupted block is treated as written. The same goes for get_block() if it
+ * blocks, except that it is called again for the same block.
+ *
+ * This header depends on nothing else in timesignal, and may be copied into
+ * out-of-tree projects.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/** Sink interface version, bumped whenever compatibility is broken. */
+#define TSIG_SINK_ABI_VERSION 2
+
+/** Name of the function a sink plugin exports. */
+#define TSIG_SINK_ENTRY "tsig_sink_entry"
+
+/** Stream parameters. */
+typedef struct tsig_sink_params {
+  uint32_t abi_version; /** Sink interface version in use. */
+  const char *format;   /** Sample format name as for --format, e.g. "S16". */
+  uint32_t phys_width;  /** Size of one sample in bytes. */
+  uint32_t rate;        /** Sample rate. */
+  uint32_t channels;    /** Channel count. */
+  uint32_t period_size; /** Frames per block. open() may change this. */
+} tsig_sink_params_t;
+
+/**
+ * Block of interleaved frames.
+ *
+ * station_time is the time the station transmits, i.e. the UTC instant encoded
+ * plus any user offset, at the start of the first frame. Together with a
+ * playback timing anchor, it ties each frame to the time code it carries.
+ */
+typedef struct tsig_sink_block {
+  uint8_t *buf;         /** Frames, or memory lent by get_block() for them. */
+  uint32_t size;        /** Count of frames. */
+  uint64_t frame;       /** Index of first frame since the stream started. */
+  int64_t timestamp;    /** CLOCK_MONOTONIC time in ns of block generation. */
+  int64_t station_time; /** Station time in ns since epoch of first frame. */
+} tsig_sink_block_t;
+
+/** Playback timing anchor. */
+typedef struct tsig_sink_anchor {
+  int64_t timestamp; /** CLOCK_MONOTONIC time in ns, or 0 if unknown. */
+  int64_t delay;     /** Count of frames put but not yet played by then. */
+} tsig_sink_anchor_t;
+
+/** Sink descriptor. */
+typedef struct tsig_sink {
+  /** Sink interface version the plugin implements. */
+  uint32_t abi_version;
+
+  /** Size of this structure as the plugin was built. */
+  uint32_t size;
+
+  /** Human-readable sink name. */
+  const char *name;
+
+  /**
+   * Open the sink.
+   *
+   * @param[out] out_sink_data Sink context object.
+   * @param[in,out] params Stream parameters.
+   * @return 0 upon success, negative error code upon error.
+   */
+  int (*open)(void **out_sink_data, tsig_sink_params_t *params);
+
+  /**
+   * Lend memory for the next block. Optional.
+   *
+   * @param sink_data Sink context object.
+   * @param[in,out] block Block whose buf is to be set to at least
+   *  size * channels * phys_width bytes of sink-owned memory.
+   * @return 0 upon success, negative error code upon error.
+   */
+  int (*get_block)(void *sink_data, tsig_sink_block_t *block);
+
+  /**
+   * Take a block, waiting until the sink can take another.
+   *
+   * @param sink_data Sink context object.
+   * @param block Block of frames.
+   * @param[out] out_anchor Playback timing anchor, zeroed beforehand.
+   * @return 0 upon success, negative error code upon error.
+   */
+  int (*put_block)(void *sink_data, const tsig_sink_block_t *block,
+                   tsig_sink_anchor_t *out_anchor);
+
+  /**
+   * Close the sink.
+   *
+   * @param sink_data Sink context object.
+   */
+  void (*close)(void *sink_data);
+} tsig_sink_t;
+
+/**
+ * Pointer to sink plugin entry function.
+ *
+ * @param abi_version Sink interface version timesignal was built against.
+ * @return Sink descriptor, or NULL if the version is not implemented.
+ */
+typedef const tsig_sink_t *(*tsig_sink_entry_t)(uint32_t abi_version);
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "audio.h"
+#include "governor.h"
 #include "iir.h"
 
 #include <limits.h>
@@ -16,6 +18,10 @@
 #include <stdint.h>
 
 typedef struct tsig_cfg tsig_cfg_t;
+typedef struct tsig_archive tsig_archive_t;
+typedef struct tsig_coherent tsig_coherent_t;
+typedef struct tsig_jitter tsig_jitter_t;
+typedef struct tsig_profile tsig_profile_t;
 typedef struct tsig_log tsig_log_t;
 
 /** Our internal time quantum is a "tick". */
@@ -40,6 +46,74 @@ typedef enum tsig_station_id {
   TSIG_STATION_ID_WWVB,
 } tsig_station_id_t;
 
+/** Time station compiled into a minimal single-station build, if any. */
+#if defined(TSIG_STATION_ONLY_BPC)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_BPC
+#elif defined(TSIG_STATION_ONLY_DCF77)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_DCF77
+#elif defined(TSIG_STATION_ONLY_JJY)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_JJY
+#elif defined(TSIG_STATION_ONLY_JJY60)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_JJY60
+#elif defined(TSIG_STATION_ONLY_MSF)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_MSF
+#elif defined(TSIG_STATION_ONLY_WWVB)
+#define TSIG_STATION_ONLY TSIG_STATION_ID_WWVB
+#endif /* TSIG_STATION_ONLY_* */
+
+/** Time stations compiled into this build. */
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_BPC)
+#define TSIG_HAVE_BPC
+#endif /* TSIG_STATION_ONLY_BPC */
+
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_DCF77)
+#define TSIG_HAVE_DCF77
+#endif /* TSIG_STATION_ONLY_DCF77 */
+
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_JJY)
+#define TSIG_HAVE_JJY
+#endif /* TSIG_STATION_ONLY_JJY */
+
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_JJY60)
+#define TSIG_HAVE_JJY60
+#endif /* TSIG_STATION_ONLY_JJY60 */
+
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_MSF)
+#define TSIG_HAVE_MSF
+#endif /* TSIG_STATION_ONLY_MSF */
+
+#if !defined(TSIG_STATION_ONLY) || defined(TSIG_STATION_ONLY_WWVB)
+#define TSIG_HAVE_WWVB
+#endif /* TSIG_STATION_ONLY_WWVB */
+
+/** Default time station. */
+#ifdef TSIG_STATION_ONLY
+#define TSIG_STATION_ID_DEFAULT TSIG_STATION_ONLY
+#else
+#define TSIG_STATION_ID_DEFAULT TSIG_STATION_ID_WWVB
+#endif /* TSIG_STATION_ONLY */
+
+/** Per-minute frame flags. */
+typedef enum tsig_station_flag {
+  TSIG_STATION_FLAG_DST = 1 << 0,        /** Transmitted time is summer time. */
+  TSIG_STATION_FLAG_DST_CHANGE = 1 << 1, /** Summer time change is pending. */
+  TSIG_STATION_FLAG_MORSE = 1 << 2,      /** JJY/JJY60 callsign announcement. */
+} tsig_station_flag_t;
+
+/** Encoded time station minute, as needed by an external transmitter. */
+typedef struct tsig_station_frame {
+  tsig_station_id_t station; /** Time station ID. */
+  uint8_t flags;             /** Bitfield of tsig_station_flag_t flags. */
+  int16_t dut1;              /** DUT1 value in milliseconds. */
+  uint32_t freq;             /** Actual station frequency. */
+  uint16_t xmit_low;         /** Low gain in [0-32768]. */
+  int64_t utc_timestamp;     /** System time at start of station minute. */
+  int64_t timestamp;         /** Station time at start of station minute. */
+
+  /** Bitfield of per-tick transmit level flags for the station minute. */
+  uint8_t xmit_level[TSIG_STATION_TICKS_MIN / CHAR_BIT];
+} tsig_station_frame_t;
+
 /** Time station waveform generator context. */
 typedef struct tsig_station {
   tsig_station_id_t station; /** Time station ID. */
@@ -53,6 +127,9 @@ typedef struct tsig_station {
   /** Bitfield of per-tick transmit level flags for current station minute. */
   uint8_t xmit_level[TSIG_STATION_TICKS_MIN / CHAR_BIT];
 
+  /** Bitfield of tsig_station_flag_t flags for current station minute. */
+  uint8_t flags;
+
   /** Bit readout for current station minute (20 seconds for BPC). */
   char xmit[TSIG_STATION_MESSAGE_SIZE];
 
@@ -60,25 +137,43 @@ typedef struct tsig_station {
   char meaning[TSIG_STATION_MESSAGE_SIZE];
 
   int64_t base_offset;     /** Base timestamp offset relative to system time. */
+  int64_t base_offset_ns;  /** Base timestamp offset in ns, if coherent. */
+  bool has_base_offset;    /** Whether base timestamp offset is calculated. */
   uint64_t timestamp;      /** Base timestamp of this station context. */
   uint64_t next_timestamp; /** Expected timestamp when next invoked. */
+  bool is_freerun;         /** Whether to keep time by samples alone. */
   uint64_t samples_tick;   /** Sample count per tick. */
   uint64_t samples;        /** Sample count since base timestamp. */
   uint64_t next_tick;      /** Sample count at next tick. */
   uint16_t tick;           /** Tick index within current station minute. */
   bool is_morse;           /** Whether JJY/JJY60 is announcing its callsign. */
 
-  tsig_iir_t iir; /** IIR filter sine wave generator. */
-  uint32_t freq;  /** Target waveform frequency. */
-  double gain;    /** Actual current gain in [0.0-1.0]. */
+  const tsig_archive_t *archive; /** Minute-frame archive, if any. */
+  bool is_archived;    /** Whether current station minute is from an archive. */
+  bool is_archive_gap; /** Whether minutes are missing from the archive. */
+
+  tsig_jitter_t *jitter;       /** Edge timing measurement context, if any. */
+  tsig_coherent_t *coherent;   /** Phase-coherent timing context, if any. */
+  tsig_profile_t *profile;     /** Pipeline stage profiling context, if any. */
+  tsig_governor_t *governor;   /** Adaptive output quality context, if any. */
+  tsig_governor_level_t level; /** Output quality level. */
+
+  tsig_iir_t iir;               /** IIR filter sine wave generator. */
+  uint32_t freq;                /** Target waveform frequency. */
+  tsig_audio_sample_t gain;     /** Actual current gain in [0.0-1.0]. */
+  tsig_audio_sample_t xmit_low; /** Low gain in [0.0-1.0]. */
 
   bool verbose;    /** Whether to provide verbose status updates. */
   tsig_log_t *log; /** Logging context. */
 } tsig_station_t;
 
-void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size);
+void tsig_station_cb(void *cb_data, tsig_audio_sample_t *out_cb_buf,
+                     uint32_t size);
 void tsig_station_init(tsig_station_t *station, tsig_cfg_t *cfg,
                        tsig_log_t *log);
+int64_t tsig_station_get_timestamp(tsig_station_t *station);
+void tsig_station_encode(tsig_station_t *station, int64_t timestamp,
+                         tsig_station_frame_t *frame);
 void tsig_station_set_rate(tsig_station_t *station, uint32_t rate);
 tsig_station_id_t tsig_station_id(const char *name);
 const char *tsig_station_name(tsig_station_id_t station_id);
@@ -7,5 +7,11 @@
  * Copyright © 2025 James Seo <james@equiv.tech>
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 void tsig_util_getprogname(char progname[]);
 int tsig_util_strcasecmp(const char *s1, const char *s2);
+uint16_t tsig_util_crc16_update(uint16_t crc, const uint8_t data[],
+                                size_t size);
+uint16_t tsig_util_crc16(const uint8_t data[], size_t size);
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+/**
+ * writer.h: Header for asynchronous file writing facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Count of buffers. All but the one being filled may be in flight. */
+#define TSIG_WRITER_BUFS 8
+
+/** Size of a buffer in bytes. */
+#define TSIG_WRITER_BUF_SIZE (1 << 20)
+
+/** Alignment of buffers, and of file offsets and sizes for O_DIRECT. */
+#define TSIG_WRITER_ALIGN 4096
+
+typedef struct tsig_log tsig_log_t;
+
+/** Means by which buffers are written. */
+typedef enum tsig_writer_mode {
+  TSIG_WRITER_MODE_URING,  /** io_uring. */
+  TSIG_WRITER_MODE_THREAD, /** Writer thread. */
+} tsig_writer_mode_t;
+
+/** Buffer. */
+typedef struct tsig_writer_buf {
+  uint8_t *data;   /** Aligned memory. */
+  size_t size;     /** Count of bytes to write. */
+  size_t done;     /** Count of bytes written. */
+  uint64_t offset; /** File offset. */
+  bool is_busy;    /** Whether submitted and not yet written. */
+} tsig_writer_buf_t;
+
+/** io_uring instance. */
+typedef struct tsig_writer_uring {
+  int fd;             /** io_uring file descriptor. */
+  bool is_registered; /** Whether buffers are registered. */
+
+  void *sq_ring;       /** Mapped submission queue ring. */
+  size_t sq_ring_size; /** Size of mapped submission queue ring. */
+  void *cq_ring;       /** Mapped completion queue ring, maybe sq_ring. */
+  size_t cq_ring_size; /** Size of mapped completion queue ring. */
+  void *sqes;          /** Mapped submission queue entries. */
+  size_t sqes_size;    /** Size of mapped submission queue entries. */
+
+  uint32_t *sq_tail;  /** Submission queue tail. */
+  uint32_t *sq_mask;  /** Submission queue index mask. */
+  uint32_t *sq_array; /** Submission queue entry indices. */
+  uint32_t *cq_head;  /** Completion queue head. */
+  uint32_t *cq_tail;  /** Completion queue tail. */
+  uint32_t *cq_mask;  /** Completion queue index mask. */
+  void *cqes;         /** Completion queue entries. */
+} tsig_writer_uring_t;
+
+/** Asynchronous file writing context. */
+typedef struct tsig_writer {
+  int fd;                  /** File descriptor. */
+  const char *path;        /** File path. */
+  bool is_direct;          /** Whether opened with O_DIRECT. */
+  tsig_writer_mode_t mode; /** Means by which buffers are written. */
+
+  tsig_writer_buf_t bufs[TSIG_WRITER_BUFS]; /** Buffers. */
+  uint32_t cur;                             /** Buffer being filled. */
+  uint64_t offset;                          /** File offset of cur. */
+  int err;                                  /** First write error. */
+
+  tsig_writer_uring_t uring; /** io_uring instance. */
+
+  pthread_t thread;     /** Writer thread. */
+  pthread_mutex_t lock; /** Lock for buffer state shared with the thread. */
+  pthread_cond_t cond;  /** Signaled upon any change to shared state. */
+  uint32_t next;        /** Next buffer the thread is to write. */
+  bool is_stopping;     /** Whether the thread is to exit when idle. */
+
+  tsig_log_t *log; /** Logging context. */
+} tsig_writer_t;
+
+int tsig_writer_init(tsig_writer_t *writer, const char *path, bool is_direct,
+                     tsig_log_t *log);
+void *tsig_writer_get_buf(tsig_writer_t *writer, size_t *out_size);
+int tsig_writer_put_buf(tsig_writer_t *writer, size_t size);
+int tsig_writer_write(tsig_writer_t *writer, const void *data, size_t size);
+int tsig_writer_deinit(tsig_writer_t *writer);
@@ -11,13 +11,19 @@
 
 #include "audio.h"
 #include "cfg.h"
+#include "coherent.h"
+#include "governor.h"
+#include "jitter.h"
 #include "log.h"
 #include "mapping.h"
+#include "profile.h"
+#include "recorder.h"
 
 #include <alsa/asoundlib.h>
 
 #include <dlfcn.h>
 #include <poll.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include <errno.h>
@@ -28,6 +34,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /** ALSA library shared object name. */
 static const char *alsa_lib_soname = "libasound.so.2";
@@ -39,9 +46,11 @@ static void *alsa_lib;
 /* clang-format off */
 static int (*alsa_snd_config_update_free_global)(void);
 static const char *(*alsa_snd_pcm_access_name)(const snd_pcm_access_t _access);
+static snd_pcm_sframes_t (*alsa_snd_pcm_avail)(snd_pcm_t *pcm);
 static int (*alsa_snd_pcm_close)(snd_pcm_t *pcm);
 static const char *(*alsa_snd_pcm_format_name)(const snd_pcm_format_t format);
 static int (*alsa_snd_pcm_format_physical_width)(snd_pcm_format_t format);
+static int (*alsa_snd_pcm_htimestamp)(snd_pcm_t *pcm, snd_pcm_uframes_t *avail, snd_htimestamp_t *tstamp);
 static int (*alsa_snd_pcm_hw_params)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params);
 static int (*alsa_snd_pcm_hw_params_any)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params);
 static int (*alsa_snd_pcm_hw_params_get_buffer_size)(const snd_pcm_hw_params_t *params, snd_pcm_uframes_t *val);
@@ -51,6 +60,7 @@ static int (*alsa_snd_pcm_hw_params_set_buffer_time_near)(snd_pcm_t *pcm, snd_pc
 static int (*alsa_snd_pcm_hw_params_set_channels_near)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int *val);
 static int (*alsa_snd_pcm_hw_params_set_format)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, snd_pcm_format_t val);
 static int (*alsa_snd_pcm_hw_params_set_period_time_near)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int *val, int *dir);
+static int (*alsa_snd_pcm_hw_params_set_period_wakeup)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int val);
 static int (*alsa_snd_pcm_hw_params_set_rate_near)(snd_pcm_t *pcm, snd_pcm_hw_params_t *params, unsigned int *val, int *dir);
 static size_t (*alsa_snd_pcm_hw_params_sizeof)(void);
 static int (*alsa_snd_pcm_open)(snd_pcm_t **pcm, const char *name, snd_pcm_stream_t stream, int mode);
@@ -60,12 +70,19 @@ static int (*alsa_snd_pcm_poll_descriptors_revents)(snd_pcm_t *pcm, struct pollf
 static int (*alsa_snd_pcm_prepare)(snd_pcm_t *pcm);
 static int (*alsa_snd_pcm_resume)(snd_pcm_t *pcm);
 static snd_pcm_state_t (*alsa_snd_pcm_state)(snd_pcm_t *pcm);
+static int (*alsa_snd_pcm_status)(snd_pcm_t *pcm, snd_pcm_status_t *status);
+static snd_pcm_sframes_t (*alsa_snd_pcm_status_get_delay)(const snd_pcm_status_t *obj);
+static void (*alsa_snd_pcm_status_get_htstamp)(const snd_pcm_status_t *obj, snd_htimestamp_t *ptr);
+static size_t (*alsa_snd_pcm_status_sizeof)(void);
 static int (*alsa_snd_pcm_sw_params)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params);
 static int (*alsa_snd_pcm_sw_params_current)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params);
 static int (*alsa_snd_pcm_sw_params_get_boundary)(const snd_pcm_sw_params_t *params, snd_pcm_uframes_t *val);
 static int (*alsa_snd_pcm_sw_params_set_avail_min)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
+static int (*alsa_snd_pcm_sw_params_set_period_event)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, int val);
 static int (*alsa_snd_pcm_sw_params_set_start_threshold)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
 static int (*alsa_snd_pcm_sw_params_set_stop_threshold)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_uframes_t val);
+static int (*alsa_snd_pcm_sw_params_set_tstamp_mode)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_tstamp_t val);
+static int (*alsa_snd_pcm_sw_params_set_tstamp_type)(snd_pcm_t *pcm, snd_pcm_sw_params_t *params, snd_pcm_tstamp_type_t val);
 static size_t (*alsa_snd_pcm_sw_params_sizeof)(void);
 static snd_pcm_sframes_t (*alsa_snd_pcm_writei)(snd_pcm_t *pcm, const void *buffer, snd_pcm_uframes_t size);
 static const char *(*alsa_snd_strerror)(int errnum);
@@ -82,6 +99,25 @@ static const unsigned alsa_buffer_time = 200000;
 /** Default period time in us. */
 static const unsigned alsa_period_time = 100000;
 
+/** Buffer time in us when scheduled by timer. */
+static const unsigned alsa_tsched_buffer_time = 2000000;
+
+/** Initial watermark in us when scheduled by timer. */
+static const unsigned alsa_tsched_watermark = 20000;
+
+/** Minimum watermark in us when scheduled by timer. */
+static const unsigned alsa_tsched_watermark_min = 10000;
+
+/** Time the watermark must go unthreatened before it is lowered in ns. */
+static const int64_t alsa_tsched_calm = 20000000000;
+
+/** Minimum sleep when scheduled by timer in ns. */
+static const int64_t alsa_tsched_sleep_min = 1000000;
+
+/** Time conversions. */
+static const int64_t alsa_nsecs_sec = 1000000000;
+static const int64_t alsa_usecs_sec = 1000000;
+
 /** Sample format map. */
 static const tsig_mapping_nn_t alsa_format_map[] = {
     {TSIG_AUDIO_FORMAT_S16, SND_PCM_FORMAT_S16},
@@ -108,6 +144,21 @@ static const tsig_mapping_nn_t alsa_format_map[] = {
     {TSIG_AUDIO_FORMAT_FLOAT64, SND_PCM_FORMAT_FLOAT64},
     {TSIG_AUDIO_FORMAT_FLOAT64_LE, SND_PCM_FORMAT_FLOAT64_LE},
     {TSIG_AUDIO_FORMAT_FLOAT64_BE, SND_PCM_FORMAT_FLOAT64_BE},
+    /* NOTE: There are no native-endian packed 24-bit formats. */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    {TSIG_AUDIO_FORMAT_S24_3, SND_PCM_FORMAT_S24_3LE},
+#else
+    {TSIG_AUDIO_FORMAT_S24_3, SND_PCM_FORMAT_S24_3BE},
+#endif /* __BYTE_ORDER__ */
+    {TSIG_AUDIO_FORMAT_S24_3LE, SND_PCM_FORMAT_S24_3LE},
+    {TSIG_AUDIO_FORMAT_S24_3BE, SND_PCM_FORMAT_S24_3BE},
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    {TSIG_AUDIO_FORMAT_U24_3, SND_PCM_FORMAT_U24_3LE},
+#else
+    {TSIG_AUDIO_FORMAT_U24_3, SND_PCM_FORMAT_U24_3BE},
+#endif /* __BYTE_ORDER__ */
+    {TSIG_AUDIO_FORMAT_U24_3LE, SND_PCM_FORMAT_U24_3LE},
+    {TSIG_AUDIO_FORMAT_U24_3BE, SND_PCM_FORMAT_U24_3BE},
     {0, 0},
 };
 
@@ -127,6 +178,21 @@ static snd_pcm_format_t alsa_format(const tsig_audio_format_t format) {
   return value < 0 ? SND_PCM_FORMAT_UNKNOWN : value;
 }
 
+/** Convert a time in us to a count of frames. */
+static snd_pcm_uframes_t alsa_frames(tsig_alsa_t *alsa, unsigned usecs) {
+  return (int64_t)usecs * alsa->rate / alsa_usecs_sec;
+}
+
+/** Get a CLOCK_MONOTONIC timestamp in ns. */
+static int64_t alsa_now(void) {
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return 0;
+
+  return ts.tv_sec * alsa_nsecs_sec + ts.tv_nsec;
+}
+
 /** Set hardware parameters. */
 static int alsa_set_hw_params(tsig_alsa_t *alsa, tsig_cfg_t *cfg) {
   tsig_log_t *log = alsa->log;
@@ -134,6 +200,7 @@ static int alsa_set_hw_params(tsig_alsa_t *alsa, tsig_cfg_t *cfg) {
   snd_pcm_t *pcm = alsa->pcm;
   snd_pcm_format_t format;
   snd_pcm_uframes_t size;
+  unsigned buffer_time;
   unsigned val;
   int err;
 
@@ -207,10 +274,12 @@ static int alsa_set_hw_params(tsig_alsa_t *alsa, tsig_cfg_t *cfg) {
   }
   alsa->channels = val;
 
-  val = alsa_buffer_time;
+  /* When scheduled by timer, the buffer is large, but only partly filled. */
+  buffer_time = alsa->is_tsched ? alsa_tsched_buffer_time : alsa_buffer_time;
+  val = buffer_time;
   err = alsa_snd_pcm_hw_params_set_buffer_time_near(pcm, params, &val, NULL);
   if (err < 0) {
-    tsig_log_err("Failed to set buffer time near %u: %s", alsa_buffer_time,
+    tsig_log_err("Failed to set buffer time near %u: %s", buffer_time,
                  alsa_snd_strerror(err));
     return err;
   }
@@ -235,6 +304,14 @@ static int alsa_set_hw_params(tsig_alsa_t *alsa, tsig_cfg_t *cfg) {
   }
   alsa->period_size = size;
 
+  /* Not all devices can do without period interrupts, but a timer still can. */
+  if (alsa->is_tsched) {
+    err = alsa_snd_pcm_hw_params_set_period_wakeup(pcm, params, 0);
+    if (err < 0)
+      tsig_log_note("Failed to disable period wakeups: %s",
+                    alsa_snd_strerror(err));
+  }
+
   err = alsa_snd_pcm_hw_params(pcm, params);
   if (err < 0) {
     tsig_log_err("Failed to set hw params: %s", alsa_snd_strerror(err));
@@ -262,8 +339,23 @@ static int alsa_set_sw_params(tsig_alsa_t *alsa) {
     return err;
   }
 
-  /* Start playback when the buffer contains the most possible whole periods. */
-  val = (alsa->buffer_size / alsa->period_size) * alsa->period_size;
+  /*
+   * Start playback when the buffer contains the most possible whole periods,
+   * or when scheduled by timer, when it is filled to the fill target. That is
+   * only the default buffer time's worth, since every buffered frame is output
+   * latency.
+   */
+
+  if (alsa->is_tsched) {
+    alsa->fill_target = alsa_frames(alsa, alsa_buffer_time);
+    if (alsa->fill_target > alsa->buffer_size)
+      alsa->fill_target = alsa->buffer_size;
+    alsa->watermark = alsa_frames(alsa, alsa_tsched_watermark);
+    val = alsa->fill_target;
+  } else {
+    val = (alsa->buffer_size / alsa->period_size) * alsa->period_size;
+  }
+
   err = alsa_snd_pcm_sw_params_set_start_threshold(pcm, params, val);
   if (err < 0) {
     tsig_log_err("Failed to set start threshold %lu: %s", val,
@@ -280,6 +372,30 @@ static int alsa_set_sw_params(tsig_alsa_t *alsa) {
   }
   alsa->avail_min = alsa->period_size;
 
+  /* When scheduled by timer, nothing should be woken by a period elapsing. */
+  if (alsa->is_tsched) {
+    err = alsa_snd_pcm_sw_params_set_period_event(pcm, params, 0);
+    if (err < 0) {
+      tsig_log_err("Failed to disable period events: %s",
+                   alsa_snd_strerror(err));
+      return err;
+    }
+  }
+
+  /*
+   * Timestamp the hardware position on the monotonic clock so that playback
+   * timing can be reported for edge timing measurement. This isn't essential.
+   */
+
+  err = alsa_snd_pcm_sw_params_set_tstamp_mode(pcm, params,
+                                               SND_PCM_TSTAMP_ENABLE);
+  if (!err)
+    err = alsa_snd_pcm_sw_params_set_tstamp_type(pcm, params,
+                                                 SND_PCM_TSTAMP_TYPE_MONOTONIC);
+  if (err < 0)
+    tsig_log_dbg("Failed to enable timestamps: %s", alsa_snd_strerror(err));
+  alsa->has_tstamp = !err;
+
   /*
    * Setting the stop threshold to the boundary keeps the device from stopping
    * during a buffer underrun (it loops the existing buffer contents instead).
@@ -309,14 +425,24 @@ static int alsa_set_sw_params(tsig_alsa_t *alsa) {
 }
 
 /** Attempt to recover from buffer underruns/overruns. */
-static void alsa_xrun_recover(tsig_log_t *log, snd_pcm_t *pcm, int err) {
+static void alsa_xrun_recover(tsig_alsa_t *alsa, int err) {
+  tsig_log_t *log = alsa->log;
+  snd_pcm_t *pcm = alsa->pcm;
+
+  tsig_recorder_event(TSIG_RECORDER_XRUN, err, 0);
+
+  if (alsa->governor)
+    tsig_governor_xrun(alsa->governor);
+
   /* Resume if device is suspended. */
   if (err == -ESTRPIPE) {
     tsig_log_note("Recovering from suspend");
+    tsig_recorder_dump("suspend");
     while ((err = alsa_snd_pcm_resume(pcm)) == -EAGAIN)
       sleep(1);
   } else {
     tsig_log_note("Recovering from underrun\n");
+    tsig_recorder_dump("xrun");
   }
 
   if (err < 0) {
@@ -326,25 +452,67 @@ static void alsa_xrun_recover(tsig_log_t *log, snd_pcm_t *pcm, int err) {
   }
 }
 
+/** Report playback timing for edge timing measurement and coherence. */
+static void alsa_anchor(tsig_alsa_t *alsa) {
+  snd_pcm_status_t *status;
+  snd_htimestamp_t tstamp;
+  int64_t timestamp;
+  int64_t delay;
+
+  /* snd_pcm_status_alloca(&status); */
+  status = __builtin_alloca(alsa_snd_pcm_status_sizeof());
+  memset(status, 0, alsa_snd_pcm_status_sizeof());
+
+  if (alsa_snd_pcm_status(alsa->pcm, status) < 0)
+    return;
+
+  /* The delay is as of when the hardware position was last updated. */
+  alsa_snd_pcm_status_get_htstamp(status, &tstamp);
+  if (!tstamp.tv_sec && !tstamp.tv_nsec)
+    return;
+
+  timestamp = tstamp.tv_sec * alsa_nsecs_sec + tstamp.tv_nsec;
+  delay = alsa_snd_pcm_status_get_delay(status);
+
+  if (alsa->jitter)
+    tsig_jitter_anchor(alsa->jitter, timestamp, delay);
+
+  if (alsa->coherent)
+    tsig_coherent_anchor(alsa->coherent, timestamp, delay);
+}
+
+/**
+ * Find which signal, if any, interrupted a wait. Waits resume after any other
+ * signal, e.g. SIGUSR2 for a flight recorder dump, so never return -EINTR.
+ */
+static int alsa_loop_signal(void) {
+  if (alsa_got_sigint) {
+    alsa_got_sigint = 0;
+    return SIGINT;
+  } else if (alsa_got_sigalrm) {
+    alsa_got_sigalrm = 0;
+    return SIGALRM;
+  } else if (alsa_got_sigterm) {
+    alsa_got_sigterm = 0;
+    return SIGTERM;
+  }
+
+  return 0; /* e.g. SIGUSR2 for a flight recorder dump. */
+}
+
 /** Wait for poll. */
 static int alsa_loop_wait(snd_pcm_t *pcm, struct pollfd *pfds, unsigned nfds) {
   unsigned short revents;
   snd_pcm_state_t state;
+  int sig;
 
   for (;;) {
     if (poll(pfds, nfds, -1) < 0) {
       if (errno == EINTR) {
-        if (alsa_got_sigint) {
-          alsa_got_sigint = 0;
-          return SIGINT;
-        } else if (alsa_got_sigalrm) {
-          alsa_got_sigalrm = 0;
-          return SIGALRM;
-        } else if (alsa_got_sigterm) {
-          alsa_got_sigterm = 0;
-          return SIGTERM;
-        }
-        return -EINTR;
+        sig = alsa_loop_signal();
+        if (sig)
+          return sig;
+        continue;
       }
       return -EINVAL;
     }
@@ -363,6 +531,209 @@ static int alsa_loop_wait(snd_pcm_t *pcm, struct pollfd *pfds, unsigned nfds) {
   }
 }
 
+/** Wait for a timer to expire after a time in ns. */
+static int alsa_tsched_wait(int fd, int64_t nsecs) {
+  struct itimerspec its = {
+      .it_value.tv_sec = nsecs / alsa_nsecs_sec,
+      .it_value.tv_nsec = nsecs % alsa_nsecs_sec,
+  };
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  uint64_t expirations;
+  int sig;
+
+  if (timerfd_settime(fd, 0, &its, NULL) < 0)
+    return -errno;
+
+  for (;;) {
+    if (poll(&pfd, 1, -1) < 0) {
+      if (errno == EINTR) {
+        sig = alsa_loop_signal();
+        if (sig)
+          return sig;
+        continue;
+      }
+      return -EINVAL;
+    }
+
+    if (pfd.revents & POLLIN)
+      return read(fd, &expirations, sizeof(expirations)) < 0 ? -errno : 0;
+  }
+}
+
+/**
+ * Find how long until the buffer drains to the watermark in ns.
+ *
+ * The available frame count is as of when the hardware position was last
+ * updated, so the time since then is taken off.
+ */
+static int64_t alsa_tsched_sleep(tsig_alsa_t *alsa) {
+  snd_htimestamp_t tstamp;
+  snd_pcm_uframes_t avail;
+  snd_pcm_sframes_t fill;
+  int64_t sleep;
+  int64_t now;
+
+  if (alsa_snd_pcm_htimestamp(alsa->pcm, &avail, &tstamp) < 0)
+    return alsa_tsched_sleep_min;
+
+  fill = (snd_pcm_sframes_t)alsa->buffer_size - (snd_pcm_sframes_t)avail;
+  sleep = (fill - (snd_pcm_sframes_t)alsa->watermark) * alsa_nsecs_sec /
+          alsa->rate;
+
+  now = alsa_now();
+  if (alsa->has_tstamp && (tstamp.tv_sec || tstamp.tv_nsec) && now)
+    sleep -= now - (tstamp.tv_sec * alsa_nsecs_sec + tstamp.tv_nsec);
+
+  return sleep < alsa_tsched_sleep_min ? alsa_tsched_sleep_min : sleep;
+}
+
+/**
+ * Adjust the watermark to how close the buffer came to draining.
+ *
+ * A wakeup finding the buffer drained below half the watermark came too late
+ * for comfort, and the watermark is doubled, shortening later sleeps. After
+ * a while without that happening, it is lowered again by a quarter.
+ */
+static void alsa_tsched_adjust(tsig_alsa_t *alsa, snd_pcm_sframes_t fill) {
+  snd_pcm_uframes_t min = alsa_frames(alsa, alsa_tsched_watermark_min);
+  snd_pcm_uframes_t max = alsa->fill_target / 2;
+  tsig_log_t *log = alsa->log;
+  int64_t now = alsa_now();
+
+  if (fill < (snd_pcm_sframes_t)alsa->watermark / 2) {
+    alsa->watermark_calm = now + alsa_tsched_calm;
+    if (alsa->watermark >= max)
+      return;
+
+    alsa->watermark = alsa->watermark * 2 < max ? alsa->watermark * 2 : max;
+    tsig_log_dbg("Raised watermark to %lu frames.", alsa->watermark);
+  } else if (now >= alsa->watermark_calm && alsa->watermark > min) {
+    alsa->watermark_calm = now + alsa_tsched_calm;
+
+    alsa->watermark -= alsa->watermark / 4;
+    if (alsa->watermark < min)
+      alsa->watermark = min;
+    tsig_log_dbg("Lowered watermark to %lu frames.", alsa->watermark);
+  }
+}
+
+/**
+ * ALSA output loop scheduled by timer.
+ *
+ * Instead of waiting for a period to elapse, the buffer is topped up to the
+ * fill target, and then the loop sleeps until the buffer should have drained
+ * to the watermark. cf. PulseAudio, src/modules/alsa/alsa-sink.c
+ */
+static int alsa_loop_tsched(tsig_alsa_t *alsa, tsig_audio_cb_t cb,
+                            void *cb_data, tsig_audio_sample_t *cb_buf,
+                            uint8_t *buf) {
+  tsig_log_t *log = alsa->log;
+  snd_pcm_t *pcm = alsa->pcm;
+  snd_pcm_sframes_t avail;
+  snd_pcm_sframes_t want;
+  snd_pcm_uframes_t size;
+  bool is_running = false;
+  int fd;
+  int err;
+
+  fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to create timer: %s", strerror(-err));
+    return err;
+  }
+
+  alsa->watermark_calm = alsa_now() + alsa_tsched_calm;
+
+  for (;;) {
+    avail = alsa_snd_pcm_avail(pcm);
+    if (avail == -EBADFD) {
+      err = avail;
+      tsig_log_err("Failed to get available frames: %s",
+                   alsa_snd_strerror(err));
+      goto out_close_timer;
+    } else if (avail < 0) {
+      alsa_xrun_recover(alsa, avail);
+      is_running = false;
+      continue;
+    }
+
+    if (is_running)
+      alsa_tsched_adjust(alsa, (snd_pcm_sframes_t)alsa->buffer_size - avail);
+
+    /* Generate and write up to one period's worth at a time. */
+    want = avail - (snd_pcm_sframes_t)(alsa->buffer_size - alsa->fill_target);
+
+    while (want > 0) {
+      size = (snd_pcm_uframes_t)want;
+      if (size > alsa->period_size)
+        size = alsa->period_size;
+
+      cb(cb_data, cb_buf, size);
+
+      if (alsa->profile)
+        tsig_profile_begin(alsa->profile, TSIG_PROFILE_FILL);
+
+      tsig_audio_fill_buffer(alsa->audio_format, alsa->channels, size, buf,
+                             cb_buf);
+
+      if (alsa->profile) {
+        tsig_profile_end(alsa->profile, TSIG_PROFILE_FILL, size);
+        tsig_profile_begin(alsa->profile, TSIG_PROFILE_WRITE);
+      }
+
+      /* There is room for all of it, so it can't be partially written. */
+      err = alsa_snd_pcm_writei(pcm, buf, size);
+      tsig_recorder_event(TSIG_RECORDER_WRITE, size, err);
+
+      if (alsa->profile)
+        tsig_profile_end(alsa->profile, TSIG_PROFILE_WRITE,
+                         err < 0 ? 0 : err);
+
+      if (err == -EBADFD) {
+        tsig_log_err("Failed to write frames: %s", alsa_snd_strerror(err));
+        goto out_close_timer;
+      } else if (err == -EAGAIN) {
+        break;
+      } else if (err < 0) {
+        alsa_xrun_recover(alsa, err);
+        is_running = false;
+        break;
+      }
+
+      want -= err;
+    }
+
+    if (alsa_snd_pcm_state(pcm) == SND_PCM_STATE_RUNNING)
+      is_running = true;
+
+    /* Report playback timing for edge timing measurement and coherence. */
+    if (is_running && (alsa->jitter || alsa->coherent) && alsa->has_tstamp)
+      alsa_anchor(alsa);
+
+    /* Waits count toward the write stage. */
+    if (alsa->profile)
+      tsig_profile_begin(alsa->profile, TSIG_PROFILE_WRITE);
+
+    err = alsa_tsched_wait(fd, alsa_tsched_sleep(alsa));
+
+    if (alsa->profile)
+      tsig_profile_end(alsa->profile, TSIG_PROFILE_WRITE, 0);
+
+    if (err == SIGINT || err == SIGTERM || err == SIGALRM) {
+      goto out_close_timer;
+    } else if (err < 0) {
+      tsig_log_err("Failed to wait for timer: %s", strerror(-err));
+      goto out_close_timer;
+    }
+  }
+
+out_close_timer:
+  close(fd);
+
+  return err;
+}
+
 #ifdef TSIG_DEBUG
 /** Print initialized ALSA output context. */
 static void alsa_print(tsig_alsa_t *alsa) {
@@ -381,8 +752,16 @@ static void alsa_print(tsig_alsa_t *alsa) {
   tsig_log_dbg("  .period_size     = %lu,", alsa->period_size);
   tsig_log_dbg("  .start_threshold = %lu,", alsa->start_threshold);
   tsig_log_dbg("  .avail_min       = %lu,", alsa->avail_min);
+  tsig_log_dbg("  .has_tstamp      = %d,", alsa->has_tstamp);
+  tsig_log_dbg("  .is_tsched       = %d,", alsa->is_tsched);
+  tsig_log_dbg("  .fill_target     = %lu,", alsa->fill_target);
+  tsig_log_dbg("  .watermark       = %lu,", alsa->watermark);
   tsig_log_dbg("  .audio_format    = %s,", audio_format);
   tsig_log_dbg("  .timeout         = %u,", alsa->timeout);
+  tsig_log_dbg("  .jitter          = %p,", alsa->jitter);
+  tsig_log_dbg("  .coherent        = %p,", alsa->coherent);
+  tsig_log_dbg("  .profile         = %p,", alsa->profile);
+  tsig_log_dbg("  .governor        = %p,", alsa->governor);
   tsig_log_dbg("  .log             = %p,", alsa->log);
   tsig_log_dbg("};");
 }
@@ -413,9 +792,11 @@ int tsig_alsa_lib_init(tsig_log_t *log) {
 
   alsa_dlsym_assign(snd_config_update_free_global);
   alsa_dlsym_assign(snd_pcm_access_name);
+  alsa_dlsym_assign(snd_pcm_avail);
   alsa_dlsym_assign(snd_pcm_close);
   alsa_dlsym_assign(snd_pcm_format_name);
   alsa_dlsym_assign(snd_pcm_format_physical_width);
+  alsa_dlsym_assign(snd_pcm_htimestamp);
   alsa_dlsym_assign(snd_pcm_hw_params);
   alsa_dlsym_assign(snd_pcm_hw_params_any);
   alsa_dlsym_assign(snd_pcm_hw_params_get_buffer_size);
@@ -425,6 +806,7 @@ int tsig_alsa_lib_init(tsig_log_t *log) {
   alsa_dlsym_assign(snd_pcm_hw_params_set_channels_near);
   alsa_dlsym_assign(snd_pcm_hw_params_set_format);
   alsa_dlsym_assign(snd_pcm_hw_params_set_period_time_near);
+  alsa_dlsym_assign(snd_pcm_hw_params_set_period_wakeup);
   alsa_dlsym_assign(snd_pcm_hw_params_set_rate_near);
   alsa_dlsym_assign(snd_pcm_hw_params_sizeof);
   alsa_dlsym_assign(snd_pcm_open);
@@ -434,12 +816,19 @@ int tsig_alsa_lib_init(tsig_log_t *log) {
   alsa_dlsym_assign(snd_pcm_prepare);
   alsa_dlsym_assign(snd_pcm_resume);
   alsa_dlsym_assign(snd_pcm_state);
+  alsa_dlsym_assign(snd_pcm_status);
+  alsa_dlsym_assign(snd_pcm_status_get_delay);
+  alsa_dlsym_assign(snd_pcm_status_get_htstamp);
+  alsa_dlsym_assign(snd_pcm_status_sizeof);
   alsa_dlsym_assign(snd_pcm_sw_params);
   alsa_dlsym_assign(snd_pcm_sw_params_current);
   alsa_dlsym_assign(snd_pcm_sw_params_get_boundary);
   alsa_dlsym_assign(snd_pcm_sw_params_set_avail_min);
+  alsa_dlsym_assign(snd_pcm_sw_params_set_period_event);
   alsa_dlsym_assign(snd_pcm_sw_params_set_start_threshold);
   alsa_dlsym_assign(snd_pcm_sw_params_set_stop_threshold);
+  alsa_dlsym_assign(snd_pcm_sw_params_set_tstamp_mode);
+  alsa_dlsym_assign(snd_pcm_sw_params_set_tstamp_type);
   alsa_dlsym_assign(snd_pcm_sw_params_sizeof);
   alsa_dlsym_assign(snd_pcm_writei);
   alsa_dlsym_assign(snd_strerror);
@@ -462,9 +851,12 @@ int tsig_alsa_init(tsig_alsa_t *alsa, tsig_cfg_t *cfg, tsig_log_t *log) {
   int err;
 
   alsa->timeout = cfg->timeout;
+  alsa->is_tsched = cfg->tsched;
   alsa->log = log;
 
-  err = alsa_snd_pcm_open(&pcm, cfg->device, SND_PCM_STREAM_PLAYBACK, 0);
+  /* Period wakeups can only be disabled in non-blocking mode. */
+  err = alsa_snd_pcm_open(&pcm, cfg->device, SND_PCM_STREAM_PLAYBACK,
+                          alsa->is_tsched ? SND_PCM_NONBLOCK : 0);
   if (err < 0) {
     tsig_log_err("Failed to open ALSA device %s: %s", cfg->device,
                  alsa_snd_strerror(err));
@@ -486,9 +878,10 @@ int tsig_alsa_init(tsig_alsa_t *alsa, tsig_cfg_t *cfg, tsig_log_t *log) {
 
 #ifndef TSIG_DEBUG
   tsig_log_dbg(
-      "Opened ALSA device \"%s\" %s %u Hz %uch, buffer %lu, period %lu.",
+      "Opened ALSA device \"%s\" %s %u Hz %uch, buffer %lu, period %lu%s.",
       alsa->device, alsa_snd_pcm_format_name(alsa->format), alsa->rate,
-      alsa->channels, alsa->buffer_size, alsa->period_size);
+      alsa->channels, alsa->buffer_size, alsa->period_size,
+      alsa->is_tsched ? ", scheduled by timer" : "");
 #else
   alsa_print(alsa);
 #endif /* TSIG_DEBUG */
@@ -522,7 +915,7 @@ int tsig_alsa_loop(tsig_alsa_t *alsa, tsig_audio_cb_t cb, void *cb_data) {
   struct sigaction sa_term;
   struct sigaction sa_int;
   bool is_running = false;
-  double *cb_buf = NULL;
+  tsig_audio_sample_t *cb_buf = NULL;
   uint8_t *buf = NULL;
   uint8_t *ptr;
   int nfds;
@@ -568,6 +961,11 @@ int tsig_alsa_loop(tsig_alsa_t *alsa, tsig_audio_cb_t cb, void *cb_data) {
   sigaction(SIGALRM, &sa, &sa_alrm);
   alarm(alsa->timeout);
 
+  if (alsa->is_tsched) {
+    err = alsa_loop_tsched(alsa, cb, cb_data, cb_buf, buf);
+    goto out_restore_signals;
+  }
+
   /*
    * ALSA pulls one period's samples at a time with up to two waits.
    * cf. alsa-lib, test/pcm.c
@@ -575,14 +973,22 @@ int tsig_alsa_loop(tsig_alsa_t *alsa, tsig_audio_cb_t cb, void *cb_data) {
 
   for (;;) {
     if (is_running) {
+      /* Waits count toward the write stage. */
+      if (alsa->profile)
+        tsig_profile_begin(alsa->profile, TSIG_PROFILE_WRITE);
+
       err = alsa_loop_wait(pcm, pfds, nfds);
-      if (err == -EINTR || err == -EIO) {
+
+      if (alsa->profile)
+        tsig_profile_end(alsa->profile, TSIG_PROFILE_WRITE, 0);
+
+      if (err == -EIO) {
         tsig_log_err("Failed to wait for poll: %s", alsa_snd_strerror(err));
         goto out_restore_signals;
       } else if (err == SIGINT || err == SIGTERM || err == SIGALRM) {
         goto out_restore_signals;
       } else if (err < 0) {
-        alsa_xrun_recover(log, pcm, err);
+        alsa_xrun_recover(alsa, err);
         is_running = false;
       }
     }
@@ -591,20 +997,29 @@ int tsig_alsa_loop(tsig_alsa_t *alsa, tsig_audio_cb_t cb, void *cb_data) {
     cb(cb_data, cb_buf, alsa->period_size);
 
     /* Fill the period buffer with the generated samples. */
+    if (alsa->profile)
+      tsig_profile_begin(alsa->profile, TSIG_PROFILE_FILL);
+
     tsig_audio_fill_buffer(alsa->audio_format, alsa->channels,
                            alsa->period_size, buf, cb_buf);
 
+    if (alsa->profile) {
+      tsig_profile_end(alsa->profile, TSIG_PROFILE_FILL, alsa->period_size);
+      tsig_profile_begin(alsa->profile, TSIG_PROFILE_WRITE);
+    }
+
     /* Write the generated samples to the output device. */
     remain = alsa->period_size;
     ptr = buf;
 
     while (remain) {
       err = alsa_snd_pcm_writei(pcm, ptr, remain);
+      tsig_recorder_event(TSIG_RECORDER_WRITE, remain, err);
       if (err == -EBADFD) {
         tsig_log_err("Failed to write frames: %s", alsa_snd_strerror(err));
         goto out_restore_signals;
       } else if (err < 0) {
-        alsa_xrun_recover(log, pcm, err);
+        alsa_xrun_recover(alsa, err);
         is_running = false;
         break; /* Skip one period. */
       }
@@ -619,16 +1034,25 @@ int tsig_alsa_loop(tsig_alsa_t *alsa, tsig_audio_cb_t cb, void *cb_data) {
         break;
 
       err = alsa_loop_wait(pcm, pfds, nfds);
-      if (err == -EINTR || err == -EIO) {
+      if (err == -EIO) {
         tsig_log_err("Failed to wait for poll: %s", alsa_snd_strerror(err));
         goto out_restore_signals;
       } else if (err == SIGINT || err == SIGTERM || err == SIGALRM) {
         goto out_restore_signals;
       } else if (err < 0) {
-        alsa_xrun_recover(log, pcm, err);
+        alsa_xrun_recover(alsa, err);
         is_running = false;
       }
     }
+
+    if (alsa->profile)
+      tsig_profile_end(alsa->profile, TSIG_PROFILE_WRITE,
+                       alsa->period_size - remain);
+
+    /* Report playback timing for edge timing measurement and coherence. */
+    if (!remain && is_running && (alsa->jitter || alsa->coherent) &&
+        alsa->has_tstamp)
+      alsa_anchor(alsa);
   }
 
 out_restore_signals:
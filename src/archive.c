@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * archive.c: Minute-frame archive facilities.
+ *
+ * Station minutes for a range of dates may be encoded once, validated, and
+ * stored in a compact archive file, which the waveform generator (or the
+ * minute-frame server) may then use instead of running the station encoders.
+ *
+ * Every second of a station minute is one of a handful of per-tick transmit
+ * level patterns, e.g. a 0, 1, or marker bit, so an archive holds a table of
+ * the distinct patterns found in it, and each minute is stored as 60 codes
+ * into that table followed by a byte of tsig_station_flag_t flags. Codes are
+ * packed LSB first at the smallest of 1, 2, 4, or 8 bits that can hold them.
+ *
+ * Minutes are contiguous and fixed-size, so the position of a minute in the
+ * file is its index. All multibyte fields are in little-endian order:
+ *
+ *   Offset  Size  Field
+ *        0     4  Magic "TSFA"
+ *        4     1  Archive version (1)
+ *        5     1  Time station ID
+ *        6     1  Symbol code size in bits
+ *        7     1  Reserved (0)
+ *        8     2  Symbol count
+ *       10     2  Minute record size in bytes
+ *       12     2  DUT1 value in ms (signed)
+ *       14     2  CRC-16/CCITT-FALSE of all bytes after the header
+ *       16     8  Station time at start of first minute in ms since epoch
+ *       24     4  Minute count
+ *       28     4  Reserved (0)
+ *       32   4*n  Symbols, each a 20-tick transmit level bitfield
+ *    32+4n   ...  Minute records
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "archive.h"
+
+#include "datetime.h"
+#include "log.h"
+#include "station.h"
+#include "util.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Archive magic. */
+static const uint8_t archive_magic[4] = {'T', 'S', 'F', 'A'};
+
+/** Archive version. */
+static const uint8_t archive_version = 1;
+
+/** Size of a symbol in bytes. */
+static const uint32_t archive_symbol_size = 4;
+
+/** Number of milliseconds in a minute. */
+static const int64_t archive_msecs_min = 60000;
+
+/** Buffer size. */
+#define TSIG_ARCHIVE_MSG_SIZE 32
+
+/** Load an integer stored in little-endian order. */
+static uint64_t archive_get_le(const uint8_t buf[], uint32_t size) {
+  uint64_t value = 0;
+
+  while (size--)
+    value = (value << 8) | buf[size];
+
+  return value;
+}
+
+/** Store an integer in little-endian order. */
+static void archive_put_le(uint8_t buf[], uint64_t value, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++, value >>= 8)
+    buf[i] = value & 0xff;
+}
+
+/** Get the per-tick transmit level flags for a second as a symbol. */
+static uint32_t archive_get_symbol(const uint8_t xmit_level[], uint32_t sec) {
+  uint32_t tick = sec * TSIG_STATION_TICKS_SEC;
+  uint32_t symbol = 0;
+
+  for (uint32_t i = 0; i < TSIG_STATION_TICKS_SEC; i++, tick++)
+    if (xmit_level[tick / CHAR_BIT] & (1 << (tick % CHAR_BIT)))
+      symbol |= 1u << i;
+
+  return symbol;
+}
+
+/** Set the per-tick transmit level flags for a second from a symbol. */
+static void archive_put_symbol(uint8_t xmit_level[], uint32_t sec,
+                               uint32_t symbol) {
+  uint32_t tick = sec * TSIG_STATION_TICKS_SEC;
+
+  for (uint32_t i = 0; i < TSIG_STATION_TICKS_SEC; i++, tick++)
+    if (symbol & (1u << i))
+      xmit_level[tick / CHAR_BIT] |= 1 << (tick % CHAR_BIT);
+    else
+      xmit_level[tick / CHAR_BIT] &= ~(1 << (tick % CHAR_BIT));
+}
+
+/** Find the smallest symbol code size in bits for a symbol count. */
+static uint8_t archive_symbol_bits(uint32_t symbol_count) {
+  uint8_t bits = 1;
+
+  while ((1u << bits) < symbol_count)
+    bits *= 2;
+
+  return bits;
+}
+
+/** Find the size of a minute record in bytes for a symbol code size. */
+static uint16_t archive_record_size(uint8_t symbol_bits) {
+  return (60 * symbol_bits + CHAR_BIT - 1) / CHAR_BIT + 1;
+}
+
+/** Format a station time for logging. */
+static void archive_format_timestamp(char buf[], int64_t timestamp) {
+  tsig_datetime_t datetime = tsig_datetime_parse_timestamp(timestamp);
+
+  /* clang-format off */
+  sprintf(buf, /* "%04hu-%02hhu-%02hhu %02hhu:%02hhu" */
+          "%04" PRIu16 "-%02" PRIu8 "-%02" PRIu8 " %02" PRIu8 ":%02" PRIu8,
+          datetime.year, datetime.mon, datetime.day,
+          datetime.hour, datetime.min);
+  /* clang-format on */
+}
+
+/** Find or add the code for a symbol. */
+static int archive_find_symbol(uint32_t symbols[], uint32_t *symbol_count,
+                               uint32_t symbol) {
+  uint32_t i;
+
+  for (i = 0; i < *symbol_count; i++)
+    if (symbols[i] == symbol)
+      return i;
+
+  if (i == TSIG_ARCHIVE_SYMBOLS_MAX)
+    return -E2BIG;
+
+  symbols[(*symbol_count)++] = symbol;
+  return i;
+}
+
+/** Encode a station minute into a minute record. */
+static void archive_encode(tsig_station_t *station, int64_t timestamp,
+                           uint32_t symbols[], uint32_t symbol_count,
+                           uint8_t symbol_bits, uint8_t record[]) {
+  uint16_t record_size = archive_record_size(symbol_bits);
+  tsig_station_frame_t frame;
+  uint32_t symbol;
+  uint32_t code;
+  uint32_t bit;
+
+  tsig_station_encode(station, timestamp, &frame);
+
+  memset(record, 0, record_size);
+
+  for (uint32_t sec = 0; sec < 60; sec++) {
+    symbol = archive_get_symbol(frame.xmit_level, sec);
+    for (code = 0; code < symbol_count; code++)
+      if (symbols[code] == symbol)
+        break;
+
+    bit = sec * symbol_bits;
+    record[bit / CHAR_BIT] |= code << (bit % CHAR_BIT);
+  }
+
+  record[record_size - 1] = frame.flags;
+}
+
+/** Compare every archived minute against the station encoders. */
+static int archive_validate(tsig_archive_t *archive, tsig_station_t *station) {
+  tsig_log_t *log = archive->log;
+  tsig_station_frame_t frame;
+  uint8_t xmit_level[sizeof(frame.xmit_level)];
+  char msg[TSIG_ARCHIVE_MSG_SIZE];
+  int64_t timestamp;
+  uint8_t flags;
+
+  for (uint32_t i = 0; i < archive->minutes; i++) {
+    timestamp = archive->timestamp + i * archive_msecs_min;
+    tsig_station_encode(station, timestamp, &frame);
+
+    if (!tsig_archive_lookup(archive, timestamp, xmit_level, &flags) ||
+        memcmp(xmit_level, frame.xmit_level, sizeof(xmit_level)) ||
+        flags != frame.flags) {
+      archive_format_timestamp(msg, timestamp);
+      tsig_log_err("Failed to validate archived minute %s", msg);
+      return -EINVAL;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Open a minute-frame archive.
+ *
+ * @param archive Uninitialized minute-frame archive.
+ * @param path Path to archive file.
+ * @param station Initialized station waveform generator context.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_archive_open(tsig_archive_t *archive, const char *path,
+                      tsig_station_t *station, tsig_log_t *log) {
+  const uint8_t *map = MAP_FAILED;
+  struct stat st;
+  const uint8_t *ptr;
+  uint64_t size;
+  int err = -EINVAL;
+  int fd;
+
+  *archive = (tsig_archive_t){.log = log};
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to open archive \"%s\": %s", path, strerror(-err));
+    return err;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    err = -errno;
+    tsig_log_err("Failed to stat archive \"%s\": %s", path, strerror(errno));
+    goto out_close;
+  }
+
+  if ((uint64_t)st.st_size < TSIG_ARCHIVE_HEADER_SIZE) {
+    tsig_log_err("Failed to read archive \"%s\": truncated header", path);
+    goto out_close;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    err = -errno;
+    tsig_log_err("Failed to map archive \"%s\": %s", path, strerror(errno));
+    goto out_close;
+  }
+
+  archive->map = map;
+  archive->size = st.st_size;
+  archive->station = map[5];
+  archive->symbol_bits = map[6];
+  archive->symbol_count = archive_get_le(&map[8], 2);
+  archive->record_size = archive_get_le(&map[10], 2);
+  archive->dut1 = archive_get_le(&map[12], 2);
+  archive->timestamp = archive_get_le(&map[16], 8);
+  archive->minutes = archive_get_le(&map[24], 4);
+
+  size = TSIG_ARCHIVE_HEADER_SIZE +
+         (uint64_t)archive->symbol_count * archive_symbol_size +
+         (uint64_t)archive->minutes * archive->record_size;
+
+  if (memcmp(map, archive_magic, sizeof(archive_magic)) ||
+      map[4] != archive_version) {
+    tsig_log_err("Failed to read archive \"%s\": unknown format", path);
+    goto out_unmap;
+  } else if (!archive->symbol_count ||
+             archive->symbol_count > TSIG_ARCHIVE_SYMBOLS_MAX ||
+             archive->symbol_bits !=
+                 archive_symbol_bits(archive->symbol_count) ||
+             archive->record_size !=
+                 archive_record_size(archive->symbol_bits) ||
+             size != archive->size) {
+    tsig_log_err("Failed to read archive \"%s\": corrupted header", path);
+    goto out_unmap;
+  } else if (tsig_util_crc16(&map[TSIG_ARCHIVE_HEADER_SIZE],
+                             archive->size - TSIG_ARCHIVE_HEADER_SIZE) !=
+             archive_get_le(&map[14], 2)) {
+    tsig_log_err("Failed to read archive \"%s\": checksum mismatch", path);
+    goto out_unmap;
+  } else if (archive->station != station->station) {
+    tsig_log_err("Failed to use archive \"%s\" for %s, archive is for %s",
+                 path, tsig_station_name(station->station),
+                 tsig_station_name(archive->station));
+    goto out_unmap;
+  }
+
+  if (archive->dut1 != station->dut1)
+    tsig_log_warn("Archive \"%s\" has DUT1 %" PRIi16 " ms, not %" PRIi16 " ms",
+                  path, archive->dut1, station->dut1);
+
+  ptr = &map[TSIG_ARCHIVE_HEADER_SIZE];
+  for (uint32_t i = 0; i < archive->symbol_count; i++)
+    archive->symbols[i] = archive_get_le(&ptr[i * archive_symbol_size], 4);
+
+  archive->records = &ptr[archive->symbol_count * archive_symbol_size];
+
+  close(fd);
+  return 0;
+
+out_unmap:
+  munmap((void *)map, st.st_size);
+  archive->map = NULL;
+
+out_close:
+  close(fd);
+  return err;
+}
+
+/**
+ * Close a minute-frame archive.
+ *
+ * @param archive Opened minute-frame archive.
+ */
+void tsig_archive_close(tsig_archive_t *archive) {
+  if (archive->map)
+    munmap((void *)archive->map, archive->size);
+
+  archive->map = NULL;
+}
+
+/**
+ * Look up a station minute in a minute-frame archive.
+ *
+ * @param archive Opened minute-frame archive.
+ * @param timestamp Station time within the station minute to look up.
+ * @param[out] xmit_level Per-tick transmit level flags for the minute.
+ * @param[out] flags Bitfield of tsig_station_flag_t flags for the minute.
+ * @return Whether the minute was found.
+ */
+bool tsig_archive_lookup(const tsig_archive_t *archive, int64_t timestamp,
+                         uint8_t xmit_level[], uint8_t *flags) {
+  uint32_t mask = (1u << archive->symbol_bits) - 1;
+  const uint8_t *record;
+  int64_t index;
+  uint32_t code;
+  uint32_t bit;
+
+  if (!archive->map || timestamp < archive->timestamp)
+    return false;
+
+  index = (timestamp - archive->timestamp) / archive_msecs_min;
+  if (index >= archive->minutes)
+    return false;
+
+  record = &archive->records[index * archive->record_size];
+
+  for (uint32_t sec = 0; sec < 60; sec++) {
+    bit = sec * archive->symbol_bits;
+    code = (record[bit / CHAR_BIT] >> (bit % CHAR_BIT)) & mask;
+    archive_put_symbol(xmit_level, sec, archive->symbols[code]);
+  }
+
+  *flags = record[archive->record_size - 1];
+  return true;
+}
+
+/**
+ * Encode station minutes into a minute-frame archive.
+ *
+ * The archive is validated against the station encoders after writing.
+ *
+ * @param station Initialized station waveform generator context.
+ * @param path Path to archive file.
+ * @param timestamp Station time within the first station minute to encode.
+ * @param minutes Number of station minutes to encode.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_archive_write(tsig_station_t *station, const char *path,
+                       int64_t timestamp, uint32_t minutes, tsig_log_t *log) {
+  uint32_t symbols[TSIG_ARCHIVE_SYMBOLS_MAX];
+  uint8_t header[TSIG_ARCHIVE_HEADER_SIZE];
+  uint8_t buf[TSIG_ARCHIVE_SYMBOLS_MAX * 4];
+  char msg[TSIG_ARCHIVE_MSG_SIZE];
+  tsig_station_frame_t frame;
+  tsig_archive_t archive;
+  uint32_t symbol_count = 0;
+  uint16_t record_size;
+  uint8_t symbol_bits;
+  uint16_t crc = 0xffff;
+  int64_t ts;
+  FILE *file;
+  int err;
+
+  timestamp -= timestamp % archive_msecs_min;
+
+  /* Find the distinct symbols in the range. */
+  for (uint32_t i = 0; i < minutes; i++) {
+    tsig_station_encode(station, timestamp + i * archive_msecs_min, &frame);
+
+    for (uint32_t sec = 0; sec < 60; sec++) {
+      err = archive_find_symbol(symbols, &symbol_count,
+                                archive_get_symbol(frame.xmit_level, sec));
+      if (err < 0) {
+        tsig_log_err("Failed to write archive \"%s\": too many symbols", path);
+        return err;
+      }
+    }
+  }
+
+  symbol_bits = archive_symbol_bits(symbol_count);
+  record_size = archive_record_size(symbol_bits);
+
+  file = fopen(path, "wb");
+  if (!file) {
+    err = -errno;
+    tsig_log_err("Failed to open archive \"%s\": %s", path, strerror(-err));
+    return err;
+  }
+
+  /* The checksum isn't known yet, so the header is written twice. */
+  memset(header, 0, sizeof(header));
+  if (fwrite(header, sizeof(header), 1, file) != 1)
+    goto out_write_err;
+
+  for (uint32_t i = 0; i < symbol_count; i++)
+    archive_put_le(&buf[i * archive_symbol_size], symbols[i], 4);
+
+  crc = tsig_util_crc16_update(crc, buf, symbol_count * archive_symbol_size);
+  if (fwrite(buf, archive_symbol_size, symbol_count, file) != symbol_count)
+    goto out_write_err;
+
+  for (uint32_t i = 0; i < minutes; i++) {
+    ts = timestamp + i * archive_msecs_min;
+    archive_encode(station, ts, symbols, symbol_count, symbol_bits, buf);
+
+    crc = tsig_util_crc16_update(crc, buf, record_size);
+    if (fwrite(buf, record_size, 1, file) != 1)
+      goto out_write_err;
+  }
+
+  memcpy(&header[0], archive_magic, sizeof(archive_magic));
+  header[4] = archive_version;
+  header[5] = station->station;
+  header[6] = symbol_bits;
+  archive_put_le(&header[8], symbol_count, 2);
+  archive_put_le(&header[10], record_size, 2);
+  archive_put_le(&header[12], (uint16_t)station->dut1, 2);
+  archive_put_le(&header[14], crc, 2);
+  archive_put_le(&header[16], timestamp, 8);
+  archive_put_le(&header[24], minutes, 4);
+
+  if (fseek(file, 0, SEEK_SET) || fwrite(header, sizeof(header), 1, file) != 1)
+    goto out_write_err;
+
+  if (fclose(file)) {
+    err = -errno;
+    tsig_log_err("Failed to write archive \"%s\": %s", path, strerror(-err));
+    return err;
+  }
+
+  err = tsig_archive_open(&archive, path, station, log);
+  if (err < 0)
+    return err;
+
+  err = archive_validate(&archive, station);
+  tsig_archive_close(&archive);
+  if (err < 0)
+    return err;
+
+  archive_format_timestamp(msg, timestamp);
+  tsig_log(
+      "Wrote %" PRIu32 " %s minutes from %s to archive \"%s\" (%zu bytes).",
+      minutes, tsig_station_name(station->station), msg, path, archive.size);
+
+  return 0;
+
+out_write_err:
+  err = -errno;
+  tsig_log_err("Failed to write archive \"%s\": %s", path, strerror(errno));
+  fclose(file);
+  return err;
+}
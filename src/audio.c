@@ -15,6 +15,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 /** Sample format names. */
 static const tsig_mapping_t audio_formats[] = {
@@ -42,6 +43,12 @@ static const tsig_mapping_t audio_formats[] = {
     {"FLOAT64", TSIG_AUDIO_FORMAT_FLOAT64},
     {"FLOAT64_LE", TSIG_AUDIO_FORMAT_FLOAT64_LE},
     {"FLOAT64_BE", TSIG_AUDIO_FORMAT_FLOAT64_BE},
+    {"S24_3", TSIG_AUDIO_FORMAT_S24_3},
+    {"S24_3LE", TSIG_AUDIO_FORMAT_S24_3LE},
+    {"S24_3BE", TSIG_AUDIO_FORMAT_S24_3BE},
+    {"U24_3", TSIG_AUDIO_FORMAT_U24_3},
+    {"U24_3LE", TSIG_AUDIO_FORMAT_U24_3LE},
+    {"U24_3BE", TSIG_AUDIO_FORMAT_U24_3BE},
     {NULL, 0},
 };
 
@@ -58,6 +65,16 @@ static const tsig_mapping_t audio_rates[] = {
     {NULL, 0},
 };
 
+/** Sample conversion kernel names. */
+static const tsig_mapping_t audio_kernels[] = {
+    {"generic", TSIG_AUDIO_KERNEL_GENERIC},
+    {"specialized", TSIG_AUDIO_KERNEL_SPECIALIZED},
+    {NULL, 0},
+};
+
+/** Sample conversion kernel used by tsig_audio_fill_buffer(). */
+static tsig_audio_kernel_t audio_kernel = TSIG_AUDIO_KERNEL_GENERIC;
+
 /** Check if audio format is floating-point. */
 static bool audio_format_is_float(tsig_audio_format_t format) {
   return format == TSIG_AUDIO_FORMAT_FLOAT ||
@@ -78,7 +95,10 @@ static bool audio_format_is_signed(tsig_audio_format_t format) {
          format == TSIG_AUDIO_FORMAT_S24_BE ||
          format == TSIG_AUDIO_FORMAT_S32 ||
          format == TSIG_AUDIO_FORMAT_S32_LE ||
-         format == TSIG_AUDIO_FORMAT_S32_BE;
+         format == TSIG_AUDIO_FORMAT_S32_BE ||
+         format == TSIG_AUDIO_FORMAT_S24_3 ||
+         format == TSIG_AUDIO_FORMAT_S24_3LE ||
+         format == TSIG_AUDIO_FORMAT_S24_3BE;
 }
 
 /** Check if audio format is little-endian. */
@@ -87,7 +107,9 @@ static bool audio_format_is_le(tsig_audio_format_t format) {
       format == TSIG_AUDIO_FORMAT_S16 || format == TSIG_AUDIO_FORMAT_S24 ||
       format == TSIG_AUDIO_FORMAT_S32 || format == TSIG_AUDIO_FORMAT_U16 ||
       format == TSIG_AUDIO_FORMAT_U24 || format == TSIG_AUDIO_FORMAT_U32 ||
-      format == TSIG_AUDIO_FORMAT_FLOAT || format == TSIG_AUDIO_FORMAT_FLOAT64;
+      format == TSIG_AUDIO_FORMAT_FLOAT ||
+      format == TSIG_AUDIO_FORMAT_FLOAT64 ||
+      format == TSIG_AUDIO_FORMAT_S24_3 || format == TSIG_AUDIO_FORMAT_U24_3;
 
   return (is_le_unspecified && tsig_audio_is_cpu_le()) ||
          format == TSIG_AUDIO_FORMAT_S16_LE ||
@@ -97,7 +119,9 @@ static bool audio_format_is_le(tsig_audio_format_t format) {
          format == TSIG_AUDIO_FORMAT_U24_LE ||
          format == TSIG_AUDIO_FORMAT_U32_LE ||
          format == TSIG_AUDIO_FORMAT_FLOAT_LE ||
-         format == TSIG_AUDIO_FORMAT_FLOAT64_LE;
+         format == TSIG_AUDIO_FORMAT_FLOAT64_LE ||
+         format == TSIG_AUDIO_FORMAT_S24_3LE ||
+         format == TSIG_AUDIO_FORMAT_U24_3LE;
 }
 
 /** Find width of audio format. */
@@ -114,7 +138,13 @@ static size_t audio_format_width(tsig_audio_format_t format) {
             format == TSIG_AUDIO_FORMAT_S24_BE ||
             format == TSIG_AUDIO_FORMAT_U24 ||
             format == TSIG_AUDIO_FORMAT_U24_LE ||
-            format == TSIG_AUDIO_FORMAT_U24_BE)
+            format == TSIG_AUDIO_FORMAT_U24_BE ||
+            format == TSIG_AUDIO_FORMAT_S24_3 ||
+            format == TSIG_AUDIO_FORMAT_S24_3LE ||
+            format == TSIG_AUDIO_FORMAT_S24_3BE ||
+            format == TSIG_AUDIO_FORMAT_U24_3 ||
+            format == TSIG_AUDIO_FORMAT_U24_3LE ||
+            format == TSIG_AUDIO_FORMAT_U24_3BE)
              ? 3
          : (format == TSIG_AUDIO_FORMAT_S32 ||
             format == TSIG_AUDIO_FORMAT_S32_LE ||
@@ -168,6 +198,13 @@ size_t tsig_audio_format_phys_width(tsig_audio_format_t format) {
           format == TSIG_AUDIO_FORMAT_U16_LE ||
           format == TSIG_AUDIO_FORMAT_U16_BE)
              ? 2
+         : (format == TSIG_AUDIO_FORMAT_S24_3 ||
+            format == TSIG_AUDIO_FORMAT_S24_3LE ||
+            format == TSIG_AUDIO_FORMAT_S24_3BE ||
+            format == TSIG_AUDIO_FORMAT_U24_3 ||
+            format == TSIG_AUDIO_FORMAT_U24_3LE ||
+            format == TSIG_AUDIO_FORMAT_U24_3BE)
+             ? 3
          : (format == TSIG_AUDIO_FORMAT_S24 ||
             format == TSIG_AUDIO_FORMAT_S24_LE ||
             format == TSIG_AUDIO_FORMAT_S24_BE ||
@@ -203,24 +240,48 @@ tsig_audio_rate_t tsig_audio_rate(const char *name) {
 }
 
 /**
- * Fill an output audio buffer with generated samples.
+ * Pack four 24-bit samples into three 32-bit words.
  *
- * @param format Output sample format.
- * @param channels Output channel count.
- * @param size Sample count.
- * @param buf Output audio buffer.
- * @param cb_buf Buffer with generated 1ch 64-bit float samples.
+ * Each sample holds its bytes in output order in its low 24 bits, and the
+ * packed words hold them in little-endian order. This writes three words per
+ * four samples instead of twelve single bytes. The output need not be aligned,
+ * e.g. after an odd count of frames, so the words are stored with memcpy().
  */
-void tsig_audio_fill_buffer(tsig_audio_format_t format, uint32_t channels,
-                            uint64_t size, uint8_t buf[], double cb_buf[]) {
+static inline void audio_pack_24(uint8_t out[12], const uint32_t in[4],
+                                 bool is_cpu_le) {
+  uint32_t w[3] = {
+      in[0] | in[1] << 24,
+      in[1] >> 8 | in[2] << 16,
+      in[2] >> 16 | in[3] << 8,
+  };
+
+  for (uint32_t i = 0; i < 3; i++)
+    w[i] = is_cpu_le ? w[i] : __builtin_bswap32(w[i]);
+
+  memcpy(out, w, sizeof(w));
+}
+
+/**
+ * Fill an output audio buffer, inlined so that a constant format folds.
+ * Exactly one of `cb_f64` and `cb_q15` must be given.
+ */
+static inline __attribute__((always_inline)) void
+audio_fill_buffer(tsig_audio_format_t format, uint32_t channels, uint64_t size,
+                  uint8_t buf[], const double cb_f64[],
+                  const int32_t cb_q15[]) {
   bool is_swap = tsig_audio_is_cpu_le() != audio_format_is_le(format);
   size_t phys_width = tsig_audio_format_phys_width(format);
+  bool is_cpu_le = tsig_audio_is_cpu_le();
+  bool is_le = audio_format_is_le(format);
   bool is_signed = audio_format_is_signed(format);
   bool is_float = audio_format_is_float(format);
   size_t width = audio_format_width(format);
   uint64_t *buf_u64 = (uint64_t *)buf;
   uint32_t *buf_u32 = (uint32_t *)buf;
+  uint8_t *buf_u8 = buf;
   uint16_t *buf_u16 = (uint16_t *)buf;
+  uint32_t pack[4];
+  uint32_t packed = 0;
   union {
     uint64_t u64;
     uint32_t u32;
@@ -241,10 +302,23 @@ void tsig_audio_fill_buffer(tsig_audio_format_t format, uint32_t channels,
      * TODO: Quantizing to fewer bits might be even better.
      */
 
-    if (is_float) {
-      n.i64 = cb_buf[i] * -INT16_MIN; /* [-32768, 32768] */
+    if (cb_q15) {
+      /*
+       * The current sample value is instead Q15 in [-32768, 32768], so do
+       * the same in integer arithmetic. (32768 + x) * 65535 / 65536 rounds
+       * down to 32768 + x - 1 for all x except -32768.
+       */
+      n.i64 = cb_q15[i]; /* [-32768, 32768] */
+      if (!is_float) {
+        n.i64 += -INT16_MIN;
+        n.i64 -= n.i64 > 0; /* [0, 65535] */
+        if (is_signed)
+          n.i64 += INT16_MIN; /* [-32768, 32767] */
+      }
+    } else if (is_float) {
+      n.i64 = cb_f64[i] * -INT16_MIN; /* [-32768, 32768] */
     } else {
-      n.i64 = (1.0 + cb_buf[i]) * UINT16_MAX * 0.5; /* [0, 65535] */
+      n.i64 = (1.0 + cb_f64[i]) * UINT16_MAX * 0.5; /* [0, 65535] */
       if (is_signed)
         n.i64 += INT16_MIN; /* [-32768, 32767] */
     }
@@ -261,15 +335,269 @@ void tsig_audio_fill_buffer(tsig_audio_format_t format, uint32_t channels,
     else /* width == 2 */
       n.u16 = n.u64;
 
+    /* Packed formats hold the bytes of a sample in output order. */
+    if (phys_width == 3)
+      n.u32 = is_le ? n.u32 & 0xffffff : __builtin_bswap32(n.u32) >> 8;
+
     /* Write the current sample value for all interleaved channels. */
     for (uint32_t c = 0; c < channels; c++)
-      if (phys_width == 8)
+      if (phys_width == 8) {
         *buf_u64++ = is_swap ? __builtin_bswap64(n.u64) : n.u64;
-      else if (phys_width == 4)
+      } else if (phys_width == 4) {
         *buf_u32++ = is_swap ? __builtin_bswap32(n.u32) : n.u32;
-      else /* phys_width == 2 */
+      } else if (phys_width == 3) {
+        pack[packed++] = n.u32;
+        if (packed == 4) {
+          audio_pack_24(buf_u8, pack, is_cpu_le);
+          buf_u8 += 12;
+          packed = 0;
+        }
+      } else { /* phys_width == 2 */
         *buf_u16++ = is_swap ? __builtin_bswap16(n.u16) : n.u16;
+      }
+  }
+
+  /* Write any samples left over from packing one byte at a time. */
+  for (uint32_t k = 0; k < packed; k++)
+    for (uint32_t b = 0; b < 3; b++)
+      buf_u8[3 * k + b] = pack[k] >> (CHAR_BIT * b);
+}
+
+/** Fill an output audio buffer with samples of the type being generated. */
+static inline __attribute__((always_inline)) void
+audio_fill(tsig_audio_format_t format, uint32_t channels, uint64_t size,
+           uint8_t buf[], const tsig_audio_sample_t cb_buf[]) {
+#ifdef TSIG_USE_FIXED_POINT
+  audio_fill_buffer(format, channels, size, buf, NULL, cb_buf);
+#else
+  audio_fill_buffer(format, channels, size, buf, cb_buf, NULL);
+#endif /* TSIG_USE_FIXED_POINT */
+}
+
+/** Pointer to a function that fills an output buffer in one sample format. */
+typedef void (*audio_fill_fn_t)(uint32_t channels, uint64_t size,
+                                uint8_t buf[],
+                                const tsig_audio_sample_t cb_buf[]);
+
+#ifndef TSIG_AUDIO_FORMAT_ONLY
+/** Define a function that fills an output buffer in one sample format. */
+#define TSIG_AUDIO_FILL_FORMAT(name)                                        \
+  static void audio_fill_##name(uint32_t channels, uint64_t size,          \
+                                uint8_t buf[],                             \
+                                const tsig_audio_sample_t cb_buf[]) {      \
+    audio_fill(TSIG_AUDIO_FORMAT_##name, channels, size, buf, cb_buf);     \
+  }
+
+TSIG_AUDIO_FILL_FORMAT(S16_LE)
+TSIG_AUDIO_FILL_FORMAT(S16_BE)
+TSIG_AUDIO_FILL_FORMAT(S24_LE)
+TSIG_AUDIO_FILL_FORMAT(S24_BE)
+TSIG_AUDIO_FILL_FORMAT(S32_LE)
+TSIG_AUDIO_FILL_FORMAT(S32_BE)
+TSIG_AUDIO_FILL_FORMAT(U16_LE)
+TSIG_AUDIO_FILL_FORMAT(U16_BE)
+TSIG_AUDIO_FILL_FORMAT(U24_LE)
+TSIG_AUDIO_FILL_FORMAT(U24_BE)
+TSIG_AUDIO_FILL_FORMAT(U32_LE)
+TSIG_AUDIO_FILL_FORMAT(U32_BE)
+TSIG_AUDIO_FILL_FORMAT(FLOAT_LE)
+TSIG_AUDIO_FILL_FORMAT(FLOAT_BE)
+TSIG_AUDIO_FILL_FORMAT(FLOAT64_LE)
+TSIG_AUDIO_FILL_FORMAT(FLOAT64_BE)
+TSIG_AUDIO_FILL_FORMAT(S24_3LE)
+TSIG_AUDIO_FILL_FORMAT(S24_3BE)
+TSIG_AUDIO_FILL_FORMAT(U24_3LE)
+TSIG_AUDIO_FILL_FORMAT(U24_3BE)
+
+#undef TSIG_AUDIO_FILL_FORMAT
+
+/** Specialized fill functions for formats with explicit endianness. */
+static const audio_fill_fn_t audio_fill_formats[] = {
+    [TSIG_AUDIO_FORMAT_S16_LE] = &audio_fill_S16_LE,
+    [TSIG_AUDIO_FORMAT_S16_BE] = &audio_fill_S16_BE,
+    [TSIG_AUDIO_FORMAT_S24_LE] = &audio_fill_S24_LE,
+    [TSIG_AUDIO_FORMAT_S24_BE] = &audio_fill_S24_BE,
+    [TSIG_AUDIO_FORMAT_S32_LE] = &audio_fill_S32_LE,
+    [TSIG_AUDIO_FORMAT_S32_BE] = &audio_fill_S32_BE,
+    [TSIG_AUDIO_FORMAT_U16_LE] = &audio_fill_U16_LE,
+    [TSIG_AUDIO_FORMAT_U16_BE] = &audio_fill_U16_BE,
+    [TSIG_AUDIO_FORMAT_U24_LE] = &audio_fill_U24_LE,
+    [TSIG_AUDIO_FORMAT_U24_BE] = &audio_fill_U24_BE,
+    [TSIG_AUDIO_FORMAT_U32_LE] = &audio_fill_U32_LE,
+    [TSIG_AUDIO_FORMAT_U32_BE] = &audio_fill_U32_BE,
+    [TSIG_AUDIO_FORMAT_FLOAT_LE] = &audio_fill_FLOAT_LE,
+    [TSIG_AUDIO_FORMAT_FLOAT_BE] = &audio_fill_FLOAT_BE,
+    [TSIG_AUDIO_FORMAT_FLOAT64_LE] = &audio_fill_FLOAT64_LE,
+    [TSIG_AUDIO_FORMAT_FLOAT64_BE] = &audio_fill_FLOAT64_BE,
+    [TSIG_AUDIO_FORMAT_S24_3LE] = &audio_fill_S24_3LE,
+    [TSIG_AUDIO_FORMAT_S24_3BE] = &audio_fill_S24_3BE,
+    [TSIG_AUDIO_FORMAT_U24_3LE] = &audio_fill_U24_3LE,
+    [TSIG_AUDIO_FORMAT_U24_3BE] = &audio_fill_U24_3BE,
+};
+#endif /* TSIG_AUDIO_FORMAT_ONLY */
+
+/** Find a specialized fill function for a sample format, if any. */
+static audio_fill_fn_t audio_fill_format(tsig_audio_format_t format) {
+#ifdef TSIG_AUDIO_FORMAT_ONLY
+  (void)format; /* Suppress unused parameter warning. */
+
+  /* The generic kernel is already specialized for the only format. */
+  return NULL;
+#else
+  /* Formats come in threes: native-endian, little-endian, and big-endian. */
+  if (format >= 0 && format % 3 == 0)
+    format += tsig_audio_is_cpu_le() ? 1 : 2;
+
+  if (format < 0 || (size_t)format >= sizeof(audio_fill_formats) /
+                                          sizeof(*audio_fill_formats))
+    return NULL;
+
+  return audio_fill_formats[format];
+#endif /* TSIG_AUDIO_FORMAT_ONLY */
+}
+
+/**
+ * Fill an output audio buffer with generated samples.
+ *
+ * The sample conversion kernel is the one last set with
+ * tsig_audio_set_kernel(), or the generic kernel if it isn't available
+ * for the sample format.
+ *
+ * @param format Output sample format.
+ * @param channels Output channel count.
+ * @param size Sample count.
+ * @param buf Output audio buffer.
+ * @param cb_buf Buffer with generated 1ch samples.
+ */
+void tsig_audio_fill_buffer(tsig_audio_format_t format, uint32_t channels,
+                            uint64_t size, uint8_t buf[],
+                            tsig_audio_sample_t cb_buf[]) {
+  if (!tsig_audio_fill_buffer_kernel(audio_kernel, format, channels, size, buf,
+                                     cb_buf))
+    tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_GENERIC, format, channels,
+                                  size, buf, cb_buf);
+}
+
+/**
+ * Fill an output audio buffer with generated samples using a specific
+ * sample conversion kernel.
+ *
+ * @param kernel Sample conversion kernel.
+ * @param format Output sample format.
+ * @param channels Output channel count.
+ * @param size Sample count.
+ * @param buf Output audio buffer.
+ * @param cb_buf Buffer with generated 1ch samples.
+ * @return Whether the kernel is available for the sample format.
+ */
+bool tsig_audio_fill_buffer_kernel(tsig_audio_kernel_t kernel,
+                                   tsig_audio_format_t format,
+                                   uint32_t channels, uint64_t size,
+                                   uint8_t buf[],
+                                   tsig_audio_sample_t cb_buf[]) {
+  audio_fill_fn_t fill;
+
+  if (kernel == TSIG_AUDIO_KERNEL_SPECIALIZED) {
+    fill = audio_fill_format(format);
+    if (!fill)
+      return false;
+
+    fill(channels, size, buf, cb_buf);
+    return true;
+  }
+
+  if (kernel != TSIG_AUDIO_KERNEL_GENERIC)
+    return false;
+
+#ifdef TSIG_USE_FIXED_POINT
+  tsig_audio_fill_buffer_q15(format, channels, size, buf, cb_buf);
+#else
+  tsig_audio_fill_buffer_f64(format, channels, size, buf, cb_buf);
+#endif /* TSIG_USE_FIXED_POINT */
+
+  return true;
+}
+
+/**
+ * Fill an output audio buffer with generated 64-bit float samples.
+ *
+ * @param format Output sample format.
+ * @param channels Output channel count.
+ * @param size Sample count.
+ * @param buf Output audio buffer.
+ * @param cb_buf Buffer with generated 1ch 64-bit float samples.
+ */
+void tsig_audio_fill_buffer_f64(tsig_audio_format_t format, uint32_t channels,
+                                uint64_t size, uint8_t buf[],
+                                const double cb_buf[]) {
+#ifdef TSIG_AUDIO_FORMAT_ONLY
+  /* Specialize unless the backend fell back to another format. */
+  if (format == TSIG_AUDIO_FORMAT_ONLY) {
+    audio_fill_buffer(TSIG_AUDIO_FORMAT_ONLY, channels, size, buf, cb_buf,
+                      NULL);
+    return;
   }
+#endif /* TSIG_AUDIO_FORMAT_ONLY */
+
+  audio_fill_buffer(format, channels, size, buf, cb_buf, NULL);
+}
+
+/**
+ * Fill an output audio buffer with generated Q15 fixed-point samples.
+ *
+ * The output is identical to that of tsig_audio_fill_buffer_f64()
+ * for 64-bit float samples that are exactly representable in Q15.
+ *
+ * @param format Output sample format.
+ * @param channels Output channel count.
+ * @param size Sample count.
+ * @param buf Output audio buffer.
+ * @param cb_buf Buffer with generated 1ch Q15 fixed-point samples.
+ */
+void tsig_audio_fill_buffer_q15(tsig_audio_format_t format, uint32_t channels,
+                                uint64_t size, uint8_t buf[],
+                                const int32_t cb_buf[]) {
+#ifdef TSIG_AUDIO_FORMAT_ONLY
+  /* Specialize unless the backend fell back to another format. */
+  if (format == TSIG_AUDIO_FORMAT_ONLY) {
+    audio_fill_buffer(TSIG_AUDIO_FORMAT_ONLY, channels, size, buf, NULL,
+                      cb_buf);
+    return;
+  }
+#endif /* TSIG_AUDIO_FORMAT_ONLY */
+
+  audio_fill_buffer(format, channels, size, buf, NULL, cb_buf);
+}
+
+/**
+ * Match a sample conversion kernel name to its value.
+ *
+ * @param name Sample conversion kernel name.
+ * @return Sample conversion kernel value, or TSIG_AUDIO_KERNEL_UNKNOWN
+ *  if invalid.
+ */
+tsig_audio_kernel_t tsig_audio_kernel(const char *name) {
+  tsig_audio_kernel_t value = tsig_mapping_match_key(audio_kernels, name);
+  return value < 0 ? TSIG_AUDIO_KERNEL_UNKNOWN : value;
+}
+
+/**
+ * Match a sample conversion kernel value to its name.
+ *
+ * @param kernel Sample conversion kernel value.
+ * @return Sample conversion kernel name, or NULL if invalid.
+ */
+const char *tsig_audio_kernel_name(tsig_audio_kernel_t kernel) {
+  return tsig_mapping_match_value(audio_kernels, kernel);
+}
+
+/**
+ * Set the sample conversion kernel used by tsig_audio_fill_buffer().
+ *
+ * @param kernel Sample conversion kernel.
+ */
+void tsig_audio_set_kernel(tsig_audio_kernel_t kernel) {
+  audio_kernel = kernel;
 }
 
 /**
@@ -31,6 +31,14 @@ static const tsig_mapping_t backend_backends[] = {
     {"ALSA", TSIG_BACKEND_ALSA},
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_PLUGIN
+    {"plugin", TSIG_BACKEND_PLUGIN},
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+    {"file", TSIG_BACKEND_FILE},
+#endif /* TSIG_HAVE_FILE */
+
     {NULL, 0},
 };
 
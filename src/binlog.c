@@ -0,0 +1,913 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * binlog.c: Binary logging facilities.
+ *
+ * Formatting a message costs far more than recording what it was made of.
+ * Messages are instead recorded as binary records holding a format string ID,
+ * raw arguments, and a pair of timestamps. Formatting is deferred until the
+ * binary log is printed, possibly long after (and on a different machine
+ * than) the messages were logged.
+ *
+ * The binary log is a fixed-size memory-mapped file in native byte order:
+ *
+ *   offset  size  description
+ *        0   128  header
+ *      128   64K  format string dictionary
+ *   64K+128  ~1M  record ring, oldest records are overwritten first
+ *
+ * A dictionary entry is a 16-bit length, including the terminating NUL, and a
+ * format string. Format string IDs are dictionary entry indices. Entries are
+ * only ever appended, so IDs remain valid when the file is reused.
+ *
+ * A record is aligned to 8 bytes and begins with a 24-byte header holding its
+ * 16-bit size, 16-bit format string ID, 8-bit log level, 3 bytes of padding,
+ * and 64-bit CLOCK_MONOTONIC and CLOCK_REALTIME timestamps in ns. Arguments
+ * follow in order: integers, pointers, and floating-point values as 64 bits,
+ * strings as a 16-bit length and contents without a NUL.
+ *
+ * Records never wrap around the end of the ring; a padding record covers the
+ * space left over instead. Messages whose format strings can't be recorded
+ * this way are recorded as a single preformatted string.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "binlog.h"
+
+#include "log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Buffer sizes. */
+#define TSIG_BINLOG_SPEC_SIZE      32
+#define TSIG_BINLOG_LINE_SIZE      1024
+#define TSIG_BINLOG_TIMESTAMP_SIZE 128
+
+/** Special format string IDs. */
+#define TSIG_BINLOG_ID_TEXT 0xfffe /* Preformatted message. */
+#define TSIG_BINLOG_ID_PAD  0xffff /* Padding to the end of the ring. */
+
+/** Binary log file header. */
+typedef struct binlog_header {
+  char magic[8];       /** File magic. */
+  uint32_t version;    /** File format version. */
+  uint32_t byte_order; /** Byte order mark. */
+  uint64_t size;       /** File size. */
+  uint64_t dict_size;  /** Format string dictionary size. */
+  uint64_t dict_used;  /** Format string dictionary bytes in use. */
+  uint32_t dict_count; /** Format string dictionary entry count. */
+  uint32_t reserved;   /** Reserved. */
+  uint64_t ring_size;  /** Record ring size. */
+  uint64_t head;       /** Offset of next record, not wrapped. */
+  uint64_t tail;       /** Offset of oldest record, not wrapped. */
+} binlog_header_t;
+
+/** Binary log record header. */
+typedef struct binlog_record {
+  uint16_t size;       /** Record size, including header and padding. */
+  uint16_t id;         /** Format string ID. */
+  uint8_t level;       /** Log level. */
+  uint8_t reserved[3]; /** Reserved. */
+  int64_t monotonic;   /** CLOCK_MONOTONIC timestamp in ns. */
+  int64_t realtime;    /** CLOCK_REALTIME timestamp in ns. */
+} binlog_record_t;
+
+/** Conversion specification within a format string. */
+typedef struct binlog_spec {
+  const char *str;  /** Specification, beginning with '%'. */
+  uint32_t len;     /** Specification length. */
+  uint32_t mod;     /** Offset of length modifier. */
+  uint32_t mod_len; /** Length modifier length. */
+  uint32_t stars;   /** Count of '*' field width and precision arguments. */
+  char conv;        /** Conversion specifier. */
+} binlog_spec_t;
+
+/** Binary log file magic. */
+static const char binlog_magic[8] = "TSIGBLOG";
+
+/** Binary log file format version. */
+static const uint32_t binlog_version = 1;
+
+/** Binary log byte order mark. */
+static const uint32_t binlog_byte_order = 0x01020304;
+
+/** Nanoseconds per second. */
+static const int64_t binlog_nsecs_sec = 1000000000;
+
+/** Format string for messages with unrecordable format strings. */
+static const tsig_binlog_format_t binlog_format_text = {
+    .fmt = "%s",
+    .id = TSIG_BINLOG_ID_TEXT,
+    .arg_size = sizeof(uint16_t),
+    .arg_count = 1,
+    .args = {'s'},
+};
+
+/** Log level descriptions. */
+static const char *binlog_descs[] = {
+    "emergency: ", /* LOG_EMERG, unused */
+    "alert: ",     /* LOG_ALERT, unused */
+    "critical: ",  /* LOG_CRIT, unused */
+    "error: ",     /* LOG_ERROR */
+    "warning: ",   /* LOG_WARNING */
+    "notice: ",    /* LOG_NOTICE */
+    "",            /* LOG_INFO, left blank */
+    "debug: ",     /* LOG_DEBUG */
+};
+
+/** Get the header of a mapped binary log file. */
+static inline binlog_header_t *binlog_header(uint8_t *map) {
+  return (binlog_header_t *)map;
+}
+
+/** Get a timestamp in ns. */
+static inline int64_t binlog_now(clockid_t clock) {
+  struct timespec ts;
+
+  if (clock_gettime(clock, &ts))
+    return 0;
+
+  return ts.tv_sec * binlog_nsecs_sec + ts.tv_nsec;
+}
+
+/** Check a binary log file header against the size of its file. */
+static bool binlog_header_is_valid(const binlog_header_t *header,
+                                   uint64_t size) {
+  return !memcmp(header->magic, binlog_magic, sizeof(binlog_magic)) &&
+         header->version == binlog_version &&
+         header->byte_order == binlog_byte_order && header->size == size &&
+         TSIG_BINLOG_HEADER_SIZE + header->dict_size + header->ring_size ==
+             size &&
+         header->dict_used <= header->dict_size && header->ring_size &&
+         !(header->ring_size % sizeof(uint64_t)) &&
+         header->tail <= header->head &&
+         header->head - header->tail <= header->ring_size;
+}
+
+/** Parse a conversion specification. */
+static bool binlog_parse_spec(const char *str, binlog_spec_t *spec) {
+  const char *p = &str[1];
+
+  *spec = (binlog_spec_t){.str = str};
+
+  p += strspn(p, "-+ #0'");
+
+  if (*p == '*') {
+    spec->stars++;
+    p++;
+  } else {
+    p += strspn(p, "0123456789");
+  }
+
+  if (*p == '.') {
+    if (*++p == '*') {
+      spec->stars++;
+      p++;
+    } else {
+      p += strspn(p, "0123456789");
+    }
+  }
+
+  spec->mod = p - str;
+  spec->mod_len = strspn(p, "hljztLq");
+  p += spec->mod_len;
+
+  if (spec->mod_len > 2 || !*p)
+    return false;
+
+  spec->conv = *p;
+  spec->len = &p[1] - str;
+
+  /* Leave room to substitute a longer length modifier when printing. */
+  return spec->len + 2 < TSIG_BINLOG_SPEC_SIZE;
+}
+
+/**
+ * Find the argument type of a conversion specification.
+ *
+ * Integer types are 'b'/'B' (char), 'h'/'H' (short), 'i'/'I' (int), 'l'/'L'
+ * (long), 'q'/'Q' (long long), 'j'/'J' (intmax_t), 'z' (size_t), and 't'
+ * (ptrdiff_t), signed and unsigned, respectively. Other types are 'd'
+ * (double), 'D' (long double), 's' (string), and 'p' (pointer).
+ *
+ * @return Argument type, '\0' if none, or '?' if unsupported.
+ */
+static char binlog_spec_type(const binlog_spec_t *spec) {
+  static const char *mods[] = {"hh", "h", "", "l", "ll", "q", "j", "z", "t"};
+  static const char *types = "bhilqqjzt";
+  static const char *utypes = "BHILQQJzt";
+  const char *mod = &spec->str[spec->mod];
+  uint32_t i;
+
+  for (i = 0; i < sizeof(mods) / sizeof(*mods); i++)
+    if (strlen(mods[i]) == spec->mod_len &&
+        !strncmp(mod, mods[i], spec->mod_len))
+      break;
+
+  switch (spec->conv) {
+  case '%':
+    return spec->len == 2 ? '\0' : '?';
+  case 'c':
+    return spec->mod_len ? '?' : 'i';
+  case 'd':
+  case 'i':
+    return i < sizeof(mods) / sizeof(*mods) ? types[i] : '?';
+  case 'o':
+  case 'u':
+  case 'x':
+  case 'X':
+    return i < sizeof(mods) / sizeof(*mods) ? utypes[i] : '?';
+  case 'a':
+  case 'A':
+  case 'e':
+  case 'E':
+  case 'f':
+  case 'F':
+  case 'g':
+  case 'G':
+    if (!spec->mod_len || !strncmp(mod, "l", spec->mod_len))
+      return 'd';
+    return spec->mod_len == 1 && *mod == 'L' ? 'D' : '?';
+  case 's':
+    return spec->mod_len ? '?' : 's';
+  case 'p':
+    return spec->mod_len ? '?' : 'p';
+  default:
+    return '?';
+  }
+}
+
+/** Add an argument type to a format string. */
+static bool binlog_format_add_arg(tsig_binlog_format_t *format, char type) {
+  if (format->arg_count == TSIG_BINLOG_ARGS_MAX)
+    return false;
+
+  format->args[format->arg_count++] = type;
+  format->arg_size += type == 's' ? sizeof(uint16_t) : sizeof(uint64_t);
+
+  return true;
+}
+
+/** Parse the argument types of a format string. */
+static bool binlog_format_parse(tsig_binlog_format_t *format, const char *fmt) {
+  binlog_spec_t spec;
+  char type;
+
+  format->arg_size = 0;
+  format->arg_count = 0;
+
+  for (const char *p = strchr(fmt, '%'); p; p = strchr(&p[spec.len], '%')) {
+    if (!binlog_parse_spec(p, &spec))
+      return false;
+
+    type = binlog_spec_type(&spec);
+    if (type == '?')
+      return false;
+
+    for (uint32_t i = 0; i < spec.stars; i++)
+      if (!binlog_format_add_arg(format, 'i'))
+        return false;
+
+    if (type && !binlog_format_add_arg(format, type))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Find or add a format string in the dictionary.
+ *
+ * @return Format string ID, or -1 if the dictionary is full.
+ */
+static int binlog_dict_find(tsig_binlog_t *binlog, const char *fmt) {
+  binlog_header_t *header = binlog_header(binlog->map);
+  size_t len = strlen(fmt) + 1;
+  uint64_t offset = 0;
+  uint16_t entry_len;
+  uint8_t *entry;
+
+  for (uint32_t id = 0; id < header->dict_count; id++) {
+    entry = &binlog->dict[offset];
+    memcpy(&entry_len, entry, sizeof(entry_len));
+
+    if (entry_len == len && !memcmp(&entry[sizeof(entry_len)], fmt, len))
+      return id;
+
+    offset += sizeof(entry_len) + entry_len;
+  }
+
+  if (len > UINT16_MAX || header->dict_count >= TSIG_BINLOG_ID_TEXT ||
+      header->dict_used + sizeof(entry_len) + len > header->dict_size)
+    return -1;
+
+  entry = &binlog->dict[header->dict_used];
+  entry_len = len;
+  memcpy(entry, &entry_len, sizeof(entry_len));
+  memcpy(&entry[sizeof(entry_len)], fmt, len);
+
+  header->dict_used += sizeof(entry_len) + len;
+
+  return header->dict_count++;
+}
+
+/**
+ * Look up a format string.
+ *
+ * Format strings are expected to be string literals, so they are looked up
+ * by address in an open addressing hash table.
+ */
+static const tsig_binlog_format_t *binlog_format_find(tsig_binlog_t *binlog,
+                                                      const char *fmt) {
+  uint32_t mask = TSIG_BINLOG_FORMATS - 1;
+  uint32_t i = (uint32_t)((uintptr_t)fmt * 2654435761u) & mask;
+  tsig_binlog_format_t *format;
+  int id;
+
+  for (uint32_t n = 0; n < TSIG_BINLOG_FORMATS; n++, i = (i + 1) & mask) {
+    format = &binlog->formats[i];
+
+    if (format->fmt == fmt)
+      return format->id == TSIG_BINLOG_ID_TEXT ? &binlog_format_text : format;
+
+    if (format->fmt)
+      continue;
+
+    format->fmt = fmt;
+    format->id = TSIG_BINLOG_ID_TEXT;
+
+    if (binlog_format_parse(format, fmt) &&
+        (id = binlog_dict_find(binlog, fmt)) >= 0)
+      format->id = id;
+
+    return format->id == TSIG_BINLOG_ID_TEXT ? &binlog_format_text : format;
+  }
+
+  return &binlog_format_text;
+}
+
+/** Encode arguments for a record. */
+static uint32_t binlog_encode_args(uint8_t buf[], uint32_t size,
+                                   const tsig_binlog_format_t *format,
+                                   va_list params) {
+  uint32_t fixed = format->arg_size;
+  int64_t value = 0;
+  uint32_t pos = 0;
+  const char *str;
+  uint16_t len;
+  double dvalue;
+
+  for (uint32_t i = 0; i < format->arg_count; i++) {
+    switch (format->args[i]) {
+    case 'b':
+      value = (signed char)va_arg(params, int);
+      break;
+    case 'B':
+      value = (unsigned char)va_arg(params, int);
+      break;
+    case 'h':
+      value = (short)va_arg(params, int);
+      break;
+    case 'H':
+      value = (unsigned short)va_arg(params, int);
+      break;
+    case 'i':
+      value = va_arg(params, int);
+      break;
+    case 'I':
+      value = va_arg(params, unsigned);
+      break;
+    case 'l':
+      value = va_arg(params, long);
+      break;
+    case 'L':
+      value = va_arg(params, unsigned long);
+      break;
+    case 'q':
+      value = va_arg(params, long long);
+      break;
+    case 'Q':
+      value = va_arg(params, unsigned long long);
+      break;
+    case 'j':
+      value = va_arg(params, intmax_t);
+      break;
+    case 'J':
+      value = va_arg(params, uintmax_t);
+      break;
+    case 'z':
+      value = va_arg(params, size_t);
+      break;
+    case 't':
+      value = va_arg(params, ptrdiff_t);
+      break;
+    case 'p':
+      value = (uintptr_t)va_arg(params, void *);
+      break;
+    case 'd':
+      dvalue = va_arg(params, double);
+      memcpy(&value, &dvalue, sizeof(value));
+      break;
+    case 'D':
+      dvalue = va_arg(params, long double);
+      memcpy(&value, &dvalue, sizeof(value));
+      break;
+    case 's':
+      str = va_arg(params, const char *);
+      if (!str)
+        str = "(null)";
+
+      /* Truncate strings to leave room for the remaining arguments. */
+      fixed -= sizeof(len);
+      len = strnlen(str, size - pos - sizeof(len) - fixed);
+
+      memcpy(&buf[pos], &len, sizeof(len));
+      memcpy(&buf[pos + sizeof(len)], str, len);
+      pos += sizeof(len) + len;
+      continue;
+    }
+
+    fixed -= sizeof(value);
+    memcpy(&buf[pos], &value, sizeof(value));
+    pos += sizeof(value);
+  }
+
+  return pos;
+}
+
+/** Encode a preformatted message for a record. */
+static uint32_t binlog_encode_text(uint8_t buf[], uint32_t size,
+                                   const char *fmt, va_list params) {
+  char text[TSIG_BINLOG_RECORD_SIZE];
+  uint16_t len;
+  int ret;
+
+  ret = vsnprintf(text, size - sizeof(len) + 1, fmt, params);
+  if (ret < 0)
+    ret = 0;
+
+  len = (uint32_t)ret < size - sizeof(len) ? (uint32_t)ret
+                                            : size - sizeof(len);
+
+  memcpy(buf, &len, sizeof(len));
+  memcpy(&buf[sizeof(len)], text, len);
+
+  return sizeof(len) + len;
+}
+
+/** Discard the oldest records until the ring has room up to an offset. */
+static void binlog_evict(tsig_binlog_t *binlog, uint64_t end) {
+  binlog_header_t *header = binlog_header(binlog->map);
+  binlog_record_t *record;
+
+  while (header->tail + header->ring_size < end) {
+    record = (binlog_record_t *)&binlog->ring[header->tail % header->ring_size];
+
+    /* Don't get stuck on a corrupt record. */
+    if (!record->size) {
+      header->tail = end - header->ring_size;
+      break;
+    }
+
+    header->tail += record->size;
+  }
+}
+
+/** Reserve space for a record at the head of the ring. */
+static uint8_t *binlog_reserve(tsig_binlog_t *binlog, uint32_t size) {
+  binlog_header_t *header = binlog_header(binlog->map);
+  uint64_t pos = header->head % header->ring_size;
+  uint64_t remain = header->ring_size - pos;
+  binlog_record_t *pad;
+
+  if (remain < size) {
+    binlog_evict(binlog, header->head + remain);
+
+    pad = (binlog_record_t *)&binlog->ring[pos];
+    pad->size = remain;
+    pad->id = TSIG_BINLOG_ID_PAD;
+
+    header->head += remain;
+    pos = 0;
+  }
+
+  binlog_evict(binlog, header->head + size);
+
+  return &binlog->ring[pos];
+}
+
+/** Reset a binary log file. */
+static void binlog_reset(tsig_binlog_t *binlog) {
+  binlog_header_t *header = binlog_header(binlog->map);
+
+  memset(binlog->map, 0, TSIG_BINLOG_SIZE);
+
+  memcpy(header->magic, binlog_magic, sizeof(binlog_magic));
+  header->version = binlog_version;
+  header->byte_order = binlog_byte_order;
+  header->size = TSIG_BINLOG_SIZE;
+  header->dict_size = TSIG_BINLOG_DICT_SIZE;
+  header->ring_size = TSIG_BINLOG_SIZE - TSIG_BINLOG_HEADER_SIZE -
+                      TSIG_BINLOG_DICT_SIZE;
+}
+
+/** Write literal text into a line buffer. */
+static void binlog_line_write(char buf[], size_t size, size_t *len,
+                              const char *str, size_t str_len) {
+  if (*len + str_len > size - 1)
+    str_len = size - 1 - *len;
+
+  memcpy(&buf[*len], str, str_len);
+  *len += str_len;
+  buf[*len] = '\0';
+}
+
+/** Read an argument from a record. */
+static bool binlog_record_read(const uint8_t args[], uint32_t size,
+                               uint32_t *pos, void *value, uint32_t len) {
+  if (*pos + len > size)
+    return false;
+
+  memcpy(value, &args[*pos], len);
+  *pos += len;
+
+  return true;
+}
+
+/** Render a message from its format string and recorded arguments. */
+static bool binlog_render(char buf[], size_t size, const char *fmt,
+                          const uint8_t args[], uint32_t args_size) {
+  char spec_fmt[TSIG_BINLOG_SPEC_SIZE];
+  char str[TSIG_BINLOG_RECORD_SIZE];
+  const char *lit = fmt;
+  const char *p;
+  binlog_spec_t spec;
+  uint32_t pos = 0;
+  size_t len = 0;
+  int64_t value;
+  int stars[2];
+  uint16_t str_len;
+  double dvalue;
+  char type;
+  int ret;
+
+  buf[0] = '\0';
+
+  for (;;) {
+    p = strchr(lit, '%');
+    if (!p) {
+      binlog_line_write(buf, size, &len, lit, strlen(lit));
+      return true;
+    }
+
+    binlog_line_write(buf, size, &len, lit, p - lit);
+
+    if (!binlog_parse_spec(p, &spec))
+      return false;
+
+    lit = &p[spec.len];
+
+    type = binlog_spec_type(&spec);
+    if (type == '?')
+      return false;
+
+    if (!type) {
+      binlog_line_write(buf, size, &len, "%", 1);
+      continue;
+    }
+
+    for (uint32_t i = 0; i < spec.stars; i++) {
+      if (!binlog_record_read(args, args_size, &pos, &value, sizeof(value)))
+        return false;
+      stars[i] = (int)value;
+    }
+
+    /* Integers were widened to 64 bits, everything else is passed as is. */
+    memcpy(spec_fmt, spec.str, spec.mod);
+    if (strchr("diouxX", spec.conv)) {
+      memcpy(&spec_fmt[spec.mod], "ll", 2);
+      spec_fmt[spec.mod + 2] = spec.conv;
+      spec_fmt[spec.mod + 3] = '\0';
+    } else {
+      spec_fmt[spec.mod] = spec.conv;
+      spec_fmt[spec.mod + 1] = '\0';
+    }
+
+    if (type == 's') {
+      if (!binlog_record_read(args, args_size, &pos, &str_len,
+                              sizeof(str_len)) ||
+          pos + str_len > args_size || str_len >= sizeof(str))
+        return false;
+
+      memcpy(str, &args[pos], str_len);
+      str[str_len] = '\0';
+      pos += str_len;
+    } else if (!binlog_record_read(args, args_size, &pos, &value,
+                                   sizeof(value))) {
+      return false;
+    }
+
+    memcpy(&dvalue, &value, sizeof(dvalue));
+
+#define binlog_render_arg(arg)                                            \
+  (spec.stars == 2   ? snprintf(&buf[len], size - len, spec_fmt, stars[0], \
+                                stars[1], (arg))                            \
+   : spec.stars == 1 ? snprintf(&buf[len], size - len, spec_fmt, stars[0], \
+                                (arg))                                      \
+                     : snprintf(&buf[len], size - len, spec_fmt, (arg)))
+
+    if (type == 's')
+      ret = binlog_render_arg(str);
+    else if (type == 'p')
+      ret = binlog_render_arg((void *)(uintptr_t)value);
+    else if (type == 'd' || type == 'D')
+      ret = binlog_render_arg(dvalue);
+    else if (spec.conv == 'c')
+      ret = binlog_render_arg((int)value);
+    else
+      ret = binlog_render_arg((long long)value);
+
+#undef binlog_render_arg
+
+    if (ret < 0)
+      return false;
+
+    len = len + ret < size ? len + ret : size - 1;
+  }
+}
+
+/** Print a record. */
+static void binlog_print_record(FILE *file, const binlog_record_t *record,
+                                const char *formats[], uint32_t count) {
+  char timestamp[TSIG_BINLOG_TIMESTAMP_SIZE];
+  char line[TSIG_BINLOG_LINE_SIZE];
+  const char *fmt = NULL;
+  const char *desc = "";
+  struct tm tm;
+  time_t secs;
+
+  if (record->id == TSIG_BINLOG_ID_TEXT)
+    fmt = binlog_format_text.fmt;
+  else if (record->id < count)
+    fmt = formats[record->id];
+
+  if (!fmt || !binlog_render(line, sizeof(line), fmt, (uint8_t *)&record[1],
+                             record->size - sizeof(*record)))
+    snprintf(line, sizeof(line), "(undecodable message, format string ID %u)",
+             record->id);
+
+  if (record->level < sizeof(binlog_descs) / sizeof(*binlog_descs))
+    desc = binlog_descs[record->level];
+
+  secs = record->realtime / binlog_nsecs_sec;
+  if (!localtime_r(&secs, &tm) ||
+      !strftime(timestamp, sizeof(timestamp), "%x %X", &tm))
+    timestamp[0] = '\0';
+
+  fprintf(file, "%s.%.03" PRId64 " [%" PRId64 ".%06" PRId64 "] | %s%s\n",
+          timestamp, record->realtime % binlog_nsecs_sec / 1000000,
+          record->monotonic / binlog_nsecs_sec,
+          record->monotonic % binlog_nsecs_sec / 1000, desc, line);
+}
+
+/** Print the records in a mapped binary log file. */
+static int binlog_print_records(uint8_t *map, FILE *file, tsig_log_t *log) {
+  binlog_header_t *header = binlog_header(map);
+  uint8_t *dict = &map[TSIG_BINLOG_HEADER_SIZE];
+  uint8_t *ring = &dict[header->dict_size];
+  const binlog_record_t *record;
+  const char **formats;
+  uint64_t offset = 0;
+  uint16_t entry_len;
+  uint64_t pos;
+  int err = 0;
+
+  formats = calloc(header->dict_count + 1, sizeof(*formats));
+  if (!formats) {
+    err = -errno;
+    tsig_log_err("Failed to allocate memory for binary log format strings: %s",
+                 strerror(-err));
+    return err;
+  }
+
+  for (uint32_t id = 0; id < header->dict_count; id++) {
+    if (offset + sizeof(entry_len) > header->dict_used)
+      break;
+
+    memcpy(&entry_len, &dict[offset], sizeof(entry_len));
+    offset += sizeof(entry_len);
+
+    if (!entry_len || offset + entry_len > header->dict_used ||
+        dict[offset + entry_len - 1])
+      break;
+
+    formats[id] = (char *)&dict[offset];
+    offset += entry_len;
+  }
+
+  for (uint64_t o = header->tail; o < header->head; o += record->size) {
+    pos = o % header->ring_size;
+    record = (binlog_record_t *)&ring[pos];
+
+    if (record->size % sizeof(uint64_t) || !record->size ||
+        record->size > header->ring_size - pos ||
+        (record->id != TSIG_BINLOG_ID_PAD && record->size < sizeof(*record))) {
+      tsig_log_err("Failed to print binary log, corrupt record at %" PRIu64,
+                   o);
+      err = -EINVAL;
+      break;
+    }
+
+    if (record->id != TSIG_BINLOG_ID_PAD)
+      binlog_print_record(file, record, formats, header->dict_count);
+  }
+
+  free(formats);
+
+  return err;
+}
+
+/**
+ * Open a binary log file for writing.
+ *
+ * A valid existing binary log file is appended to, otherwise a new one is
+ * created in its place.
+ *
+ * @param binlog Uninitialized binary log context.
+ * @param path Binary log file path.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_binlog_open(tsig_binlog_t *binlog, const char *path) {
+  struct stat st;
+  uint8_t *map;
+  int err = 0;
+  int fd;
+
+  memset(binlog, 0, sizeof(*binlog));
+
+  fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return -errno;
+
+  if (fstat(fd, &st) < 0) {
+    err = -errno;
+    goto out_close;
+  }
+
+  /* Empty the file first so that a new binary log starts out zeroed. */
+  if (st.st_size != TSIG_BINLOG_SIZE &&
+      (ftruncate(fd, 0) < 0 || ftruncate(fd, TSIG_BINLOG_SIZE) < 0)) {
+    err = -errno;
+    goto out_close;
+  }
+
+  map = mmap(NULL, TSIG_BINLOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+             0);
+  if (map == MAP_FAILED) {
+    err = -errno;
+    goto out_close;
+  }
+
+  binlog->map = map;
+
+  if (!binlog_header_is_valid(binlog_header(map), TSIG_BINLOG_SIZE))
+    binlog_reset(binlog);
+
+  binlog->dict = &map[TSIG_BINLOG_HEADER_SIZE];
+  binlog->ring = &binlog->dict[binlog_header(map)->dict_size];
+
+out_close:
+  close(fd);
+
+  return err;
+}
+
+/**
+ * Write a message to a binary log file.
+ *
+ * @param binlog Initialized binary log context.
+ * @param level Log level.
+ * @param fmt Format string.
+ * @param params Format string arguments.
+ */
+void tsig_binlog_write(tsig_binlog_t *binlog, int level, const char *fmt,
+                       va_list params) {
+  uint64_t buf[TSIG_BINLOG_RECORD_SIZE / sizeof(uint64_t)];
+  binlog_record_t *record = (binlog_record_t *)buf;
+  uint8_t *args = (uint8_t *)&record[1];
+  uint32_t size = sizeof(buf) - sizeof(*record);
+  const tsig_binlog_format_t *format;
+
+  format = binlog_format_find(binlog, fmt);
+
+  *record = (binlog_record_t){
+      .id = format->id,
+      .level = level,
+      .monotonic = binlog_now(CLOCK_MONOTONIC),
+      .realtime = binlog_now(CLOCK_REALTIME),
+  };
+
+  if (format == &binlog_format_text)
+    size = binlog_encode_text(args, size, fmt, params);
+  else
+    size = binlog_encode_args(args, size, format, params);
+
+  /* Pad the record out to keep the next one aligned. */
+  size += sizeof(*record);
+  record->size = (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+  memset(&((uint8_t *)buf)[size], 0, record->size - size);
+  size = record->size;
+
+  memcpy(binlog_reserve(binlog, size), record, size);
+  binlog_header(binlog->map)->head += size;
+}
+
+/**
+ * Close a binary log file.
+ *
+ * @param binlog Initialized binary log context.
+ */
+void tsig_binlog_close(tsig_binlog_t *binlog) {
+  if (binlog->map)
+    munmap(binlog->map, TSIG_BINLOG_SIZE);
+
+  binlog->map = NULL;
+}
+
+/**
+ * Print a binary log file as text, oldest message first.
+ *
+ * @param path Binary log file path.
+ * @param file Output file.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_binlog_print(const char *path, FILE *file, tsig_log_t *log) {
+  struct stat st;
+  uint8_t *map;
+  int err = 0;
+  int fd;
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to open binary log file \"%s\": %s", path,
+                 strerror(-err));
+    return err;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    err = -errno;
+    tsig_log_err("Failed to stat binary log file \"%s\": %s", path,
+                 strerror(-err));
+    goto out_close;
+  }
+
+  if ((uint64_t)st.st_size < TSIG_BINLOG_HEADER_SIZE) {
+    err = -EINVAL;
+    tsig_log_err("Failed to print binary log, \"%s\" is not a binary log file",
+                 path);
+    goto out_close;
+  }
+
+  map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    err = -errno;
+    tsig_log_err("Failed to map binary log file \"%s\": %s", path,
+                 strerror(-err));
+    goto out_close;
+  }
+
+  if (!binlog_header_is_valid(binlog_header(map), st.st_size)) {
+    err = -EINVAL;
+    tsig_log_err("Failed to print binary log, \"%s\" is not a binary log file",
+                 path);
+    goto out_munmap;
+  }
+
+  err = binlog_print_records(map, file, log);
+
+out_munmap:
+  munmap(map, st.st_size);
+
+out_close:
+  close(fd);
+
+  return err;
+}
@@ -9,6 +9,7 @@
 
 #include "cfg.h"
 
+#include "archive.h"
 #include "audio.h"
 #include "backend.h"
 #include "datetime.h"
@@ -38,11 +39,57 @@
 #define TSIG_CFG_BACKENDS "pipewire, pulse"
 #elif defined(TSIG_HAVE_PIPEWIRE) && defined(TSIG_HAVE_ALSA)
 #define TSIG_CFG_BACKENDS "pipewire, alsa"
-#else
+#elif defined(TSIG_HAVE_PULSE) && defined(TSIG_HAVE_ALSA)
 #define TSIG_CFG_BACKENDS "pulse, alsa"
+#elif defined(TSIG_HAVE_PIPEWIRE)
+#define TSIG_CFG_BACKENDS "pipewire"
+#elif defined(TSIG_HAVE_PULSE)
+#define TSIG_CFG_BACKENDS "pulse"
+#else
+#define TSIG_CFG_BACKENDS "alsa"
 #endif /* TSIG_HAVE_PIPEWIRE, TSIG_HAVE_PULSE, TSIG_HAVE_ALSA */
 #endif /* TSIG_HAVE_BACKENDS */
 
+/** Configurable time stations. */
+#if defined(TSIG_STATION_ONLY_BPC)
+#define TSIG_CFG_STATIONS "BPC"
+#define TSIG_CFG_STATION  "BPC"
+#elif defined(TSIG_STATION_ONLY_DCF77)
+#define TSIG_CFG_STATIONS "DCF77"
+#define TSIG_CFG_STATION  "DCF77"
+#elif defined(TSIG_STATION_ONLY_JJY)
+#define TSIG_CFG_STATIONS "JJY or JJY40"
+#define TSIG_CFG_STATION  "JJY"
+#elif defined(TSIG_STATION_ONLY_JJY60)
+#define TSIG_CFG_STATIONS "JJY60"
+#define TSIG_CFG_STATION  "JJY60"
+#elif defined(TSIG_STATION_ONLY_MSF)
+#define TSIG_CFG_STATIONS "MSF"
+#define TSIG_CFG_STATION  "MSF"
+#elif defined(TSIG_STATION_ONLY_WWVB)
+#define TSIG_CFG_STATIONS "WWVB"
+#define TSIG_CFG_STATION  "WWVB"
+#else
+#define TSIG_CFG_STATIONS "BPC, DCF77, JJY, JJY60, MSF, or WWVB"
+#define TSIG_CFG_STATION  "WWVB"
+#endif /* TSIG_STATION_ONLY_* */
+
+/** Default sample format and rate names. */
+#define TSIG_CFG_STR(x)  #x
+#define TSIG_CFG_XSTR(x) TSIG_CFG_STR(x)
+
+#ifdef TSIG_AUDIO_FORMAT_ONLY_NAME
+#define TSIG_CFG_FORMAT TSIG_AUDIO_FORMAT_ONLY_NAME
+#else
+#define TSIG_CFG_FORMAT "S16"
+#endif /* TSIG_AUDIO_FORMAT_ONLY_NAME */
+
+#ifdef TSIG_AUDIO_RATE_ONLY
+#define TSIG_CFG_RATE TSIG_CFG_XSTR(TSIG_AUDIO_RATE_ONLY)
+#else
+#define TSIG_CFG_RATE "48000"
+#endif /* TSIG_AUDIO_RATE_ONLY */
+
 /** Pointer to a setter function. */
 typedef bool (*cfg_setter_t)(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 
@@ -57,6 +104,8 @@ static bool cfg_set_station(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_base(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_offset(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_dut1(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_coherent(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str);
 static bool cfg_set_timeout(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -65,8 +114,13 @@ static bool cfg_set_backend(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 
 #ifdef TSIG_HAVE_ALSA
 static bool cfg_set_device(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_tsched(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+static bool cfg_set_direct(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+#endif /* TSIG_HAVE_FILE */
+
 static bool cfg_set_format(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_rate(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_channels(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
@@ -74,10 +128,22 @@ static bool cfg_set_smooth(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_ultrasound(tsig_cfg_t *cfg, tsig_log_t *log,
                                const char *str);
 static bool cfg_set_audible(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_governor(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str);
+static bool cfg_set_wisdom(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_serve(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_archive(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_archive_days(tsig_cfg_t *cfg, tsig_log_t *log,
+                                 const char *str);
 static bool cfg_set_log_file(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_binlog(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_syslog(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_verbose(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
 static bool cfg_set_quiet(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_jitter(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_profile(tsig_cfg_t *cfg, tsig_log_t *log, const char *str);
+static bool cfg_set_recorder(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str);
 
 #ifdef TSIG_DEBUG
 static void cfg_print(tsig_cfg_t *cfg, tsig_log_t *log);
@@ -95,6 +161,20 @@ static const long cfg_timeout_max = 86400000;
 static const long cfg_channels_min = 0;
 static const long cfg_channels_max = 1024;
 
+/** Archive day count limits (exclusive). */
+static const long cfg_archive_days_min = 0;
+static const long cfg_archive_days_max = TSIG_ARCHIVE_DAYS_MAX + 1;
+
+#ifdef TSIG_HAVE_PLUGIN
+/** Output method prefix for an output sink plugin path. */
+static const char cfg_plugin_prefix[] = "plugin:";
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+/** Output method prefix for a raw output file path. */
+static const char cfg_file_prefix[] = "file:";
+#endif /* TSIG_HAVE_FILE */
+
 /** Time conversions. */
 static const long cfg_msecs_hour = 3600000;
 static const long cfg_msecs_min = 60000;
@@ -108,16 +188,24 @@ static const char cfg_help_fmt[] = {
     "\n"
     "Usage: %s [OPTION]... [STATION]\n"
     "\n"
-    "STATION may be BPC, DCF77, JJY, JJY60, MSF, or WWVB (default: WWVB).\n"
+    "STATION may be " TSIG_CFG_STATIONS " (default: " TSIG_CFG_STATION ").\n"
     "\n"
     "Time signal options:\n"
     "  -b, --base=BASE          time base in YYYY-MM-DD HH:mm:ss[(+-)hhmm] format\n"
     "  -o, --offset=OFFSET      user offset in [+-]HH:mm:ss[.SSS] format\n"
     "  -d, --dut1=DUT1          DUT1 value in ms (only for MSF and WWVB)\n"
+    "  -K, --coherent           tie carrier phase and edges to absolute time\n"
     "\n"
     "Timeout options:\n"
     "  -t, --timeout=TIMEOUT    time to run before exiting in HH:mm:ss format\n"
     "\n"
+    "Server options:\n"
+    "  -s, --serve=SERVE        serve minute frames instead of playing audio\n"
+    "\n"
+    "Archive options:\n"
+    "  -A, --archive=ARCHIVE    read minute frames from an archive file\n"
+    "  -W, --write-archive=DAYS write DAYS of minute frames to ARCHIVE and exit\n"
+    "\n"
     "Sound options (rarely needed):\n"
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -126,24 +214,38 @@ static const char cfg_help_fmt[] = {
 
 #ifdef TSIG_HAVE_ALSA
     "  -D, --device=DEVICE      output device (only for ALSA)\n"
+    "  -T, --tsched             schedule output by timer (only for ALSA)\n"
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+    "  -O, --direct             bypass the page cache (only for file)\n"
+#endif /* TSIG_HAVE_FILE */
+
     "  -f, --format=FORMAT      output sample format\n"
     "  -r, --rate=RATE          output sample rate\n"
     "  -c, --channels=CHANNELS  output channels\n"
     "  -S, --smooth             smooth rapid gain changes in output waveform\n"
     "  -u, --ultrasound         enable ultrasound output (MAY DAMAGE EQUIPMENT)\n"
     "  -a, --audible            make output waveform audible (for entertainment only)\n"
+    "  -g, --governor           reduce output quality when CPU-starved\n"
+    "  -w, --wisdom=WISDOM_FILE remember the fastest sample conversion in a file\n"
     "\n"
     "Configuration file options:\n"
     "  -C, --config=CONFIG_FILE load options from a file\n"
     "\n"
     "Logging options:\n"
     "  -l, --log=LOG_FILE       log messages to a file\n"
+    "  -B, --binlog=BINLOG_FILE record messages to a binary log file\n"
+    "  -P, --print-binlog       print messages in BINLOG_FILE and exit\n"
     "  -L, --syslog             log messages to syslog\n"
     "  -v, --verbose            increase logging verbosity\n"
     "  -q, --quiet              suppress logging to console (and only console)\n"
     "\n"
+    "Diagnostic options:\n"
+    "  -j, --jitter             measure edge timing against playback position\n"
+    "  -p, --profile            measure CPU cost of each pipeline stage\n"
+    "  -R, --recorder=DUMP_FILE dump recent events to a file upon glitches\n"
+    "\n"
     "Miscellaneous:\n"
     "  -h, --help               show this help and exit\n"
     "  -H, --longhelp           also show allowed and default option values\n"
@@ -158,18 +260,33 @@ static const char cfg_longhelp_fmt[] = {
     "  time base      1970-01-01 00:00:00+0000 to 9999-12-31 23:59:59+2359\n"
     "  user offset    -23:59:59.999 to 23:59:59.999\n"
     "  DUT1 value     -999 to 999\n"
+    "  coherent       provide to turn on\n"
     "  timeout        00:00:01 to 23:59:59\n"
 
 #ifdef TSIG_HAVE_BACKENDS
     "  output method  " TSIG_CFG_BACKENDS "\n"
 #endif /* TSIG_HAVE_BACKENDS */
 
+#ifdef TSIG_HAVE_PLUGIN
+    "                 plugin:PATH (PATH to an output sink plugin)\n"
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+    "                 file:PATH (PATH to render raw output to)\n"
+#endif /* TSIG_HAVE_FILE */
+
 #ifdef TSIG_HAVE_ALSA
     "  output device  ALSA device name\n"
+    "  tsched         provide to turn on\n"
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+    "  direct         provide to turn on\n"
+#endif /* TSIG_HAVE_FILE */
+
     "  sample format  S16, S16_LE, S16_BE, U16, U16_LE, U16_BE,\n"
     "                 S24, S24_LE, S24_BE, U24, U24_LE, U24_BE,\n"
+    "                 S24_3, S24_3LE, S24_3BE, U24_3, U24_3LE, U24_3BE,\n"
     "                 S32, S32_LE, S32_BE, U32, U32_LE, U32_BE,\n"
     "                 FLOAT, FLOAT_LE, FLOAT_BE,\n"
     "                 FLOAT64, FLOAT64_LE, FLOAT64_BE\n"
@@ -179,16 +296,26 @@ static const char cfg_longhelp_fmt[] = {
     "  smooth gain    provide to turn on\n"
     "  ultrasound     provide to turn on (MAY DAMAGE EQUIPMENT)\n"
     "  audible        provide to turn on (for entertainment only)\n"
+    "  governor       provide to turn on\n"
+    "  wisdom         filesystem path\n"
+    "  serve          Unix socket path, or \"pty\" for a pseudo-TTY\n"
+    "  archive        filesystem path\n"
+    "  archive days   1 to 36525\n"
     "  config file    filesystem path\n"
     "  log file       filesystem path\n"
+    "  binary log     filesystem path\n"
     "  syslog         provide to turn on\n"
     "  verbose        provide to turn on\n"
     "  quiet          provide to turn on\n"
+    "  jitter         provide to turn on\n"
+    "  profile        provide to turn on\n"
+    "  recorder       filesystem path\n"
     "\n"
     "Default option values:\n"
     "  time base      current system time\n"
     "  user offset    00:00:00.000\n"
     "  DUT1 value     0\n"
+    "  coherent       off\n"
     "  timeout        forever\n"
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -197,29 +324,43 @@ static const char cfg_longhelp_fmt[] = {
 
 #ifdef TSIG_HAVE_ALSA
     "  ALSA device    default\n"
+    "  tsched         off\n"
 #endif /* TSIG_HAVE_ALSA */
 
-    "  sample format  S16\n"
-    "  sample rate    48000\n"
+#ifdef TSIG_HAVE_FILE
+    "  direct         off\n"
+#endif /* TSIG_HAVE_FILE */
+
+    "  sample format  " TSIG_CFG_FORMAT "\n"
+    "  sample rate    " TSIG_CFG_RATE "\n"
     "  channels       1\n"
     "  smooth gain    off\n"
     "  ultrasound     off\n"
     "  audible        off\n"
+    "  governor       off\n"
+    "  wisdom         none\n"
+    "  serve          none\n"
+    "  archive        none\n"
     "  config file    none\n"
     "  log file       none\n"
+    "  binary log     none\n"
     "  syslog         off\n"
     "  verbose        off\n"
     "  quiet          off\n"
+    "  jitter         off\n"
+    "  profile        off\n"
+    "  recorder       none\n"
     "\n"
     /* clang-format on */
 };
 
 /** Default program configuration. */
 static tsig_cfg_t cfg_default = {
-    .station = TSIG_STATION_ID_WWVB,
+    .station = TSIG_STATION_ID_DEFAULT,
     .base = TSIG_STATION_BASE_SYSTEM,
     .offset = 0,
     .dut1 = 0,
+    .coherent = false,
     .timeout = 0,
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -228,18 +369,33 @@ static tsig_cfg_t cfg_default = {
 
 #ifdef TSIG_HAVE_ALSA
     .device = {"default"},
+    .tsched = false,
 #endif /* TSIG_HAVE_ALSA */
 
-    .format = TSIG_AUDIO_FORMAT_S16,
-    .rate = TSIG_AUDIO_RATE_48000,
+#ifdef TSIG_HAVE_FILE
+    .direct = false,
+#endif /* TSIG_HAVE_FILE */
+
+    .format = TSIG_AUDIO_FORMAT_DEFAULT,
+    .rate = TSIG_AUDIO_RATE_DEFAULT,
     .channels = 1,
     .smooth = false,
     .ultrasound = false,
     .audible = false,
+    .governor = false,
+    .wisdom = {""},
+    .serve = {""},
+    .archive = {""},
+    .archive_days = 0,
     .log_file = {""},
+    .binlog = {""},
+    .print_binlog = false,
     .syslog = false,
     .verbose = false,
     .quiet = false,
+    .jitter = false,
+    .profile = false,
+    .recorder = {""},
 };
 
 /** Long options. */
@@ -247,6 +403,7 @@ static struct option cfg_longopts[] = {
     {"base", required_argument, NULL, 'b'},
     {"offset", required_argument, NULL, 'o'},
     {"dut1", required_argument, NULL, 'd'},
+    {"coherent", no_argument, NULL, 'K'},
     {"timeout", required_argument, NULL, 't'},
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -255,19 +412,34 @@ static struct option cfg_longopts[] = {
 
 #ifdef TSIG_HAVE_ALSA
     {"device", required_argument, NULL, 'D'},
+    {"tsched", no_argument, NULL, 'T'},
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+    {"direct", no_argument, NULL, 'O'},
+#endif /* TSIG_HAVE_FILE */
+
     {"format", required_argument, NULL, 'f'},
     {"rate", required_argument, NULL, 'r'},
     {"channels", required_argument, NULL, 'c'},
     {"smooth", no_argument, NULL, 'S'},
     {"ultrasound", no_argument, NULL, 'u'},
     {"audible", no_argument, NULL, 'a'},
+    {"governor", no_argument, NULL, 'g'},
+    {"wisdom", required_argument, NULL, 'w'},
+    {"serve", required_argument, NULL, 's'},
+    {"archive", required_argument, NULL, 'A'},
+    {"write-archive", required_argument, NULL, 'W'},
     {"config", required_argument, NULL, 'C'},
     {"log", required_argument, NULL, 'l'},
+    {"binlog", required_argument, NULL, 'B'},
+    {"print-binlog", no_argument, NULL, 'P'},
     {"syslog", no_argument, NULL, 'L'},
     {"verbose", no_argument, NULL, 'v'},
     {"quiet", no_argument, NULL, 'q'},
+    {"jitter", no_argument, NULL, 'j'},
+    {"profile", no_argument, NULL, 'p'},
+    {"recorder", required_argument, NULL, 'R'},
     {"help", no_argument, NULL, 'h'},
     {"longhelp", no_argument, NULL, 'H'},
     {NULL, 0, NULL, 0},
@@ -275,17 +447,21 @@ static struct option cfg_longopts[] = {
 
 /** Short options. */
 static const char cfg_opts[] = {
-    "b:o:d:t:"
+    "b:o:d:Kt:"
 
 #ifdef TSIG_HAVE_BACKENDS
     "m:"
 #endif /* TSIG_HAVE_BACKENDS */
 
 #ifdef TSIG_HAVE_ALSA
-    "D:"
+    "D:T"
 #endif /* TSIG_HAVE_ALSA */
 
-    "f:r:c:SuaC:l:LvqhH",
+#ifdef TSIG_HAVE_FILE
+    "O"
+#endif /* TSIG_HAVE_FILE */
+
+    "f:r:c:Suagw:s:A:W:C:l:B:PLvqjpR:hH",
 };
 
 /** Setter functions for a configuration file. */
@@ -295,6 +471,7 @@ static cfg_setter_info_t cfg_setter_info[] = {
     {"base", &cfg_set_base},
     {"offset", &cfg_set_offset},
     {"dut1", &cfg_set_dut1},
+    {"coherent", &cfg_set_coherent},
     {"timeout", &cfg_set_timeout},
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -303,18 +480,31 @@ static cfg_setter_info_t cfg_setter_info[] = {
 
 #ifdef TSIG_HAVE_ALSA
     {"device", &cfg_set_device},
+    {"tsched", &cfg_set_tsched},
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+    {"direct", &cfg_set_direct},
+#endif /* TSIG_HAVE_FILE */
+
     {"format", &cfg_set_format},
     {"rate", &cfg_set_rate},
     {"channels", &cfg_set_channels},
     {"smooth", &cfg_set_smooth},
     {"ultrasound", &cfg_set_ultrasound},
     {"audible", &cfg_set_audible},
+    {"governor", &cfg_set_governor},
+    {"wisdom", &cfg_set_wisdom},
+    {"serve", &cfg_set_serve},
+    {"archive", &cfg_set_archive},
     {"log", &cfg_set_log_file},
+    {"binlog", &cfg_set_binlog},
     {"syslog", &cfg_set_syslog},
     {"verbose", &cfg_set_verbose},
     {"quiet", &cfg_set_quiet},
+    {"jitter", &cfg_set_jitter},
+    {"profile", &cfg_set_profile},
+    {"recorder", &cfg_set_recorder},
     {NULL, NULL},
     /* clang-format on */
 };
@@ -634,11 +824,52 @@ static bool cfg_set_timeout(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   return true;
 }
 
+/** Setter for coherent. */
+static bool cfg_set_coherent(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->coherent = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->coherent = false;
+  } else {
+    tsig_log_err("Invalid coherent \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
+
 #ifdef TSIG_HAVE_BACKENDS
 /** Setter for backend. */
 static bool cfg_set_backend(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   tsig_backend_t backend = tsig_backend(str);
 
+#ifdef TSIG_HAVE_PLUGIN
+  /* Output sink plugins are given as "plugin:PATH". */
+  if (!strncmp(str, cfg_plugin_prefix, strlen(cfg_plugin_prefix)) &&
+      str[strlen(cfg_plugin_prefix)]) {
+    strncpy(cfg->plugin, &str[strlen(cfg_plugin_prefix)], sizeof(cfg->plugin));
+    cfg->plugin[sizeof(cfg->plugin) - 1] = '\0';
+    backend = TSIG_BACKEND_PLUGIN;
+  } else if (backend == TSIG_BACKEND_PLUGIN) {
+    tsig_log_err("Invalid output method \"%s\" requires a plugin path", str);
+    return false;
+  }
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  /* Raw output files are given as "file:PATH". */
+  if (!strncmp(str, cfg_file_prefix, strlen(cfg_file_prefix)) &&
+      str[strlen(cfg_file_prefix)]) {
+    strncpy(cfg->file, &str[strlen(cfg_file_prefix)], sizeof(cfg->file));
+    cfg->file[sizeof(cfg->file) - 1] = '\0';
+    backend = TSIG_BACKEND_FILE;
+  } else if (backend == TSIG_BACKEND_FILE) {
+    tsig_log_err("Invalid output method \"%s\" requires a file path", str);
+    return false;
+  }
+#endif /* TSIG_HAVE_FILE */
+
   if (backend == TSIG_BACKEND_UNKNOWN) {
     tsig_log_err("Invalid output method \"%s\"", str);
     return false;
@@ -659,8 +890,38 @@ static bool cfg_set_device(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
 
   return true;
 }
+
+/** Setter for tsched. */
+static bool cfg_set_tsched(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->tsched = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->tsched = false;
+  } else {
+    tsig_log_err("Invalid tsched \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+/** Setter for direct. */
+static bool cfg_set_direct(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->direct = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->direct = false;
+  } else {
+    tsig_log_err("Invalid direct \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
+#endif /* TSIG_HAVE_FILE */
+
 /** Setter for format. */
 static bool cfg_set_format(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   tsig_audio_format_t format = tsig_audio_format(str);
@@ -745,6 +1006,69 @@ static bool cfg_set_audible(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   return true;
 }
 
+/** Setter for governor. */
+static bool cfg_set_governor(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->governor = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->governor = false;
+  } else {
+    tsig_log_err("Invalid governor \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
+
+/** Setter for wisdom. */
+static bool cfg_set_wisdom(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  strncpy(cfg->wisdom, str, sizeof(cfg->wisdom));
+  cfg->wisdom[sizeof(cfg->wisdom) - 1] = '\0';
+
+  return true;
+}
+
+/** Setter for serve. */
+static bool cfg_set_serve(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  strncpy(cfg->serve, str, sizeof(cfg->serve));
+  cfg->serve[sizeof(cfg->serve) - 1] = '\0';
+
+  return true;
+}
+
+/** Setter for archive. */
+static bool cfg_set_archive(tsig_cfg_t *cfg, tsig_log_t *log,
+                            const char *str) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  strncpy(cfg->archive, str, sizeof(cfg->archive));
+  cfg->archive[sizeof(cfg->archive) - 1] = '\0';
+
+  return true;
+}
+
+/** Setter for archive_days. */
+static bool cfg_set_archive_days(tsig_cfg_t *cfg, tsig_log_t *log,
+                                 const char *str) {
+  long archive_days;
+
+  if (!cfg_strtol(str, &archive_days) ||
+      !(cfg_archive_days_min < archive_days &&
+        archive_days < cfg_archive_days_max)) {
+    tsig_log_err("Invalid archive days \"%s\" must be between 1 and 36525",
+                 str);
+    return false;
+  }
+
+  cfg->archive_days = (uint16_t)archive_days;
+  return true;
+}
+
 /** Setter for log_file. */
 static bool cfg_set_log_file(tsig_cfg_t *cfg, tsig_log_t *log,
                              const char *str) {
@@ -756,6 +1080,16 @@ static bool cfg_set_log_file(tsig_cfg_t *cfg, tsig_log_t *log,
   return true;
 }
 
+/** Setter for binlog. */
+static bool cfg_set_binlog(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  strncpy(cfg->binlog, str, sizeof(cfg->binlog));
+  cfg->binlog[sizeof(cfg->binlog) - 1] = '\0';
+
+  return true;
+}
+
 /** Setter for syslog. */
 static bool cfg_set_syslog(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   if (!str || !tsig_util_strcasecmp(str, "on")) {
@@ -798,6 +1132,45 @@ static bool cfg_set_quiet(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
   return true;
 }
 
+/** Setter for jitter. */
+static bool cfg_set_jitter(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->jitter = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->jitter = false;
+  } else {
+    tsig_log_err("Invalid jitter \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
+
+/** Setter for profile. */
+static bool cfg_set_profile(tsig_cfg_t *cfg, tsig_log_t *log, const char *str) {
+  if (!str || !tsig_util_strcasecmp(str, "on")) {
+    cfg->profile = true;
+  } else if (!tsig_util_strcasecmp(str, "off")) {
+    cfg->profile = false;
+  } else {
+    tsig_log_err("Invalid profile \"%s\" must be \"on\" or \"off\"", str);
+    return false;
+  }
+
+  return true;
+}
+
+/** Setter for recorder. */
+static bool cfg_set_recorder(tsig_cfg_t *cfg, tsig_log_t *log,
+                             const char *str) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  strncpy(cfg->recorder, str, sizeof(cfg->recorder));
+  cfg->recorder[sizeof(cfg->recorder) - 1] = '\0';
+
+  return true;
+}
+
 /** Find setter function for a configuration file option name. */
 static int cfg_setter_index(char *name) {
   if (!name)
@@ -948,9 +1321,15 @@ static bool cfg_parse_file(tsig_cfg_t *cfg, tsig_log_t *log, const char *path) {
 
     const char *option_name = cfg_setter_info[k].name;
     cfg_setter_t setter = cfg_setter_info[k].setter;
-    bool is_value_required = strcmp(name, "smooth") &&
+    bool is_value_required = strcmp(name, "coherent") &&
+                             strcmp(name, "smooth") &&
                              strcmp(name, "ultrasound") &&
-                             strcmp(name, "syslog");
+                             strcmp(name, "governor") &&
+                             strcmp(name, "tsched") &&
+                             strcmp(name, "direct") &&
+                             strcmp(name, "syslog") &&
+                             strcmp(name, "jitter") &&
+                             strcmp(name, "profile");
 
     if (!value && is_value_required) {
       tsig_log_err(
@@ -996,30 +1375,51 @@ static void cfg_print(tsig_cfg_t *cfg, tsig_log_t *log) {
 #endif /* TSIG_HAVE_BACKENDS */
 
   tsig_log_dbg("tsig_cfg_t %p = {", cfg);
-  tsig_log_dbg("  .station    = %s,", station);
-  tsig_log_dbg("  .base       = %" PRIi64 ",", cfg->base);
-  tsig_log_dbg("  .offset     = %" PRIi32 ",", cfg->offset);
-  tsig_log_dbg("  .dut1       = %" PRIi16 ",", cfg->dut1);
-  tsig_log_dbg("  .timeout    = %u,", cfg->timeout);
+  tsig_log_dbg("  .station      = %s,", station);
+  tsig_log_dbg("  .base         = %" PRIi64 ",", cfg->base);
+  tsig_log_dbg("  .offset       = %" PRIi32 ",", cfg->offset);
+  tsig_log_dbg("  .dut1         = %" PRIi16 ",", cfg->dut1);
+  tsig_log_dbg("  .coherent     = %d,", cfg->coherent);
+  tsig_log_dbg("  .timeout      = %u,", cfg->timeout);
 
 #ifdef TSIG_HAVE_BACKENDS
-  tsig_log_dbg("  .backend    = %s,", backend);
+  tsig_log_dbg("  .backend      = %s,", backend);
 #endif /* TSIG_HAVE_BACKENDS */
 
 #ifdef TSIG_HAVE_ALSA
-  tsig_log_dbg("  .device     = \"%s\",", cfg->device);
+  tsig_log_dbg("  .device       = \"%s\",", cfg->device);
+  tsig_log_dbg("  .tsched       = %d,", cfg->tsched);
 #endif /* TSIG_HAVE_ALSA */
 
-  tsig_log_dbg("  .format     = %s,", format);
-  tsig_log_dbg("  .rate       = %" PRIu32 ",", cfg->rate);
-  tsig_log_dbg("  .channels   = %" PRIu16 ",", cfg->channels);
-  tsig_log_dbg("  .smooth     = %d,", cfg->smooth);
-  tsig_log_dbg("  .ultrasound = %d,", cfg->ultrasound);
-  tsig_log_dbg("  .audible    = %d,", cfg->audible);
-  tsig_log_dbg("  .log_file   = \"%s\",", cfg->log_file);
-  tsig_log_dbg("  .syslog     = %d,", cfg->syslog);
-  tsig_log_dbg("  .verbose    = %d,", cfg->verbose);
-  tsig_log_dbg("  .quiet      = %d,", cfg->quiet);
+#ifdef TSIG_HAVE_PLUGIN
+  tsig_log_dbg("  .plugin       = \"%s\",", cfg->plugin);
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  tsig_log_dbg("  .file         = \"%s\",", cfg->file);
+  tsig_log_dbg("  .direct       = %d,", cfg->direct);
+#endif /* TSIG_HAVE_FILE */
+
+  tsig_log_dbg("  .format       = %s,", format);
+  tsig_log_dbg("  .rate         = %" PRIu32 ",", cfg->rate);
+  tsig_log_dbg("  .channels     = %" PRIu16 ",", cfg->channels);
+  tsig_log_dbg("  .smooth       = %d,", cfg->smooth);
+  tsig_log_dbg("  .ultrasound   = %d,", cfg->ultrasound);
+  tsig_log_dbg("  .audible      = %d,", cfg->audible);
+  tsig_log_dbg("  .governor     = %d,", cfg->governor);
+  tsig_log_dbg("  .wisdom       = \"%s\",", cfg->wisdom);
+  tsig_log_dbg("  .serve        = \"%s\",", cfg->serve);
+  tsig_log_dbg("  .archive      = \"%s\",", cfg->archive);
+  tsig_log_dbg("  .archive_days = %" PRIu16 ",", cfg->archive_days);
+  tsig_log_dbg("  .log_file     = \"%s\",", cfg->log_file);
+  tsig_log_dbg("  .binlog       = \"%s\",", cfg->binlog);
+  tsig_log_dbg("  .print_binlog = %d,", cfg->print_binlog);
+  tsig_log_dbg("  .syslog       = %d,", cfg->syslog);
+  tsig_log_dbg("  .verbose      = %d,", cfg->verbose);
+  tsig_log_dbg("  .quiet        = %d,", cfg->quiet);
+  tsig_log_dbg("  .jitter       = %d,", cfg->jitter);
+  tsig_log_dbg("  .profile      = %d,", cfg->profile);
+  tsig_log_dbg("  .recorder     = \"%s\",", cfg->recorder);
   tsig_log_dbg("};");
 }
 #endif /* TSIG_DEBUG */
@@ -1047,6 +1447,7 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
   bool got_base = false;
   bool got_offset = false;
   bool got_dut1 = false;
+  bool got_coherent = false;
   bool got_timeout = false;
 
 #ifdef TSIG_HAVE_BACKENDS
@@ -1055,18 +1456,31 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
 
 #ifdef TSIG_HAVE_ALSA
   bool got_device = false;
+  bool got_tsched = false;
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+  bool got_direct = false;
+#endif /* TSIG_HAVE_FILE */
+
   bool got_format = false;
   bool got_rate = false;
   bool got_channels = false;
   bool got_smooth = false;
   bool got_ultrasound = false;
   bool got_audible = false;
+  bool got_governor = false;
+  bool got_wisdom = false;
+  bool got_serve = false;
+  bool got_archive = false;
   bool got_log_file = false;
+  bool got_binlog = false;
   bool got_syslog = false;
   bool got_verbose = false;
   bool got_quiet = false;
+  bool got_jitter = false;
+  bool got_profile = false;
+  bool got_recorder = false;
 
   *cfg = cfg_default;
 
@@ -1089,6 +1503,10 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
         is_ok = cfg_set_dut1(cfg, log, optarg);
         got_dut1 = true;
         break;
+      case 'K':
+        cfg->coherent = true;
+        got_coherent = true;
+        break;
       case 't':
         is_ok = cfg_set_timeout(cfg, log, optarg);
         got_timeout = true;
@@ -1106,8 +1524,19 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
         is_ok = cfg_set_device(cfg, log, optarg);
         got_device = true;
         break;
+      case 'T':
+        cfg->tsched = true;
+        got_tsched = true;
+        break;
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+      case 'O':
+        cfg->direct = true;
+        got_direct = true;
+        break;
+#endif /* TSIG_HAVE_FILE */
+
       case 'f':
         is_ok = cfg_set_format(cfg, log, optarg);
         got_format = true;
@@ -1132,6 +1561,25 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
         cfg->audible = true;
         got_audible = true;
         break;
+      case 'g':
+        cfg->governor = true;
+        got_governor = true;
+        break;
+      case 'w':
+        is_ok = cfg_set_wisdom(cfg, log, optarg);
+        got_wisdom = true;
+        break;
+      case 's':
+        is_ok = cfg_set_serve(cfg, log, optarg);
+        got_serve = true;
+        break;
+      case 'A':
+        is_ok = cfg_set_archive(cfg, log, optarg);
+        got_archive = true;
+        break;
+      case 'W':
+        is_ok = cfg_set_archive_days(cfg, log, optarg);
+        break;
       case 'C':
         cfg_file_path = optarg;
         break;
@@ -1139,6 +1587,13 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
         is_ok = cfg_set_log_file(cfg, log, optarg);
         got_log_file = true;
         break;
+      case 'B':
+        is_ok = cfg_set_binlog(cfg, log, optarg);
+        got_binlog = true;
+        break;
+      case 'P':
+        cfg->print_binlog = true;
+        break;
       case 'L':
         cfg->syslog = true;
         got_syslog = true;
@@ -1151,6 +1606,18 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
         cfg->quiet = true;
         got_quiet = true;
         break;
+      case 'j':
+        cfg->jitter = true;
+        got_jitter = true;
+        break;
+      case 'p':
+        cfg->profile = true;
+        got_profile = true;
+        break;
+      case 'R':
+        is_ok = cfg_set_recorder(cfg, log, optarg);
+        got_recorder = true;
+        break;
       case 'h':
         if (!help)
           help = 1;
@@ -1183,6 +1650,8 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
     cfg->offset = cfg_file.offset;
   if (!got_dut1)
     cfg->dut1 = cfg_file.dut1;
+  if (!got_coherent)
+    cfg->coherent = cfg_file.coherent;
   if (!got_timeout)
     cfg->timeout = cfg_file.timeout;
 
@@ -1191,9 +1660,23 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
     cfg->backend = cfg_file.backend;
 #endif /* TSIG_HAVE_BACKENDS */
 
+#ifdef TSIG_HAVE_PLUGIN
+  if (!got_backend)
+    strcpy(cfg->plugin, cfg_file.plugin);
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  if (!got_backend)
+    strcpy(cfg->file, cfg_file.file);
+  if (!got_direct)
+    cfg->direct = cfg_file.direct;
+#endif /* TSIG_HAVE_FILE */
+
 #ifdef TSIG_HAVE_ALSA
   if (!got_device)
     strcpy(cfg->device, cfg_file.device);
+  if (!got_tsched)
+    cfg->tsched = cfg_file.tsched;
 #endif /* TSIG_HAVE_ALSA */
 
   if (!got_format)
@@ -1208,14 +1691,30 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
     cfg->ultrasound = cfg_file.ultrasound;
   if (!got_audible)
     cfg->audible = cfg_file.audible;
+  if (!got_governor)
+    cfg->governor = cfg_file.governor;
+  if (!got_wisdom)
+    strcpy(cfg->wisdom, cfg_file.wisdom);
+  if (!got_serve)
+    strcpy(cfg->serve, cfg_file.serve);
+  if (!got_archive)
+    strcpy(cfg->archive, cfg_file.archive);
   if (!got_log_file)
     strcpy(cfg->log_file, cfg_file.log_file);
+  if (!got_binlog)
+    strcpy(cfg->binlog, cfg_file.binlog);
   if (!got_syslog)
     cfg->syslog = cfg_file.syslog;
   if (!got_verbose)
     cfg->verbose = cfg_file.verbose;
   if (!got_quiet)
     cfg->quiet = cfg_file.quiet;
+  if (!got_jitter)
+    cfg->jitter = cfg_file.jitter;
+  if (!got_profile)
+    cfg->profile = cfg_file.profile;
+  if (!got_recorder)
+    strcpy(cfg->recorder, cfg_file.recorder);
 
   tsig_util_getprogname(progname);
 
@@ -1225,8 +1724,10 @@ tsig_cfg_init_result_t tsig_cfg_init(tsig_cfg_t *cfg, tsig_log_t *log, int argc,
   } else if (help) {
     fprintf(stderr, cfg_help_fmt, progname);
   } else {
-    tsig_log_finish_init(log, cfg->log_file, cfg->syslog, cfg->verbose,
-                         cfg->quiet);
+    /* A binary log being printed isn't also recorded to. */
+    tsig_log_finish_init(log, cfg->log_file,
+                         cfg->print_binlog ? "" : cfg->binlog, cfg->syslog,
+                         cfg->verbose, cfg->quiet);
   }
 
 #ifdef TSIG_DEBUG
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * coherent.c: Phase-coherent timing facilities.
+ *
+ * Several instances sharing a disciplined system clock (e.g. by PTP) emit
+ * coherent signals if each sample is a function of the absolute time at
+ * which it plays, rather than of when each instance happened to start. Audio
+ * backends report the same playback timing anchors as for edge timing
+ * measurement, from which the system time at which the next frame to be
+ * generated will play is predicted, compensating for output latency.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "coherent.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/** Time conversions. */
+static const int64_t coherent_nsecs_sec = 1000000000;
+
+/** Convert a timespec to ns. */
+static int64_t coherent_nsecs(const struct timespec *ts) {
+  return ts->tv_sec * coherent_nsecs_sec + ts->tv_nsec;
+}
+
+/**
+ * Initialize a phase-coherent timing context.
+ *
+ * @param coherent Uninitialized phase-coherent timing context.
+ * @param rate Sample rate.
+ * @param log Initialized logging context.
+ */
+void tsig_coherent_init(tsig_coherent_t *coherent, uint32_t rate,
+                        tsig_log_t *log) {
+  memset(coherent, 0, sizeof(*coherent));
+
+  coherent->rate = rate;
+  coherent->log = log;
+}
+
+/**
+ * Account for a generated buffer.
+ *
+ * @param coherent Initialized phase-coherent timing context.
+ * @param size Count of frames in the buffer.
+ */
+void tsig_coherent_advance(tsig_coherent_t *coherent, uint32_t size) {
+  coherent->frames += size;
+}
+
+/**
+ * Note a playback timing anchor.
+ *
+ * @param coherent Initialized phase-coherent timing context.
+ * @param timestamp CLOCK_MONOTONIC time in ns at which the anchor was taken.
+ * @param delay Count of frames between the frame playing at that time
+ *  and the next frame to be generated.
+ */
+void tsig_coherent_anchor(tsig_coherent_t *coherent, int64_t timestamp,
+                          int64_t delay) {
+  struct timespec realtime;
+  struct timespec monotonic;
+
+  /* The system time may be stepped, so convert each time. */
+  if (clock_gettime(CLOCK_REALTIME, &realtime) ||
+      clock_gettime(CLOCK_MONOTONIC, &monotonic))
+    return;
+
+  timestamp += coherent_nsecs(&realtime) - coherent_nsecs(&monotonic);
+
+  coherent->anchor_frame = coherent->frames;
+  coherent->anchor_time = timestamp + delay * coherent_nsecs_sec /
+                                          coherent->rate;
+  coherent->has_anchor = true;
+}
+
+/**
+ * Predict when the next frame to be generated will play.
+ *
+ * Until the backend reports an anchor, output latency is unknown and the
+ * current system time is returned.
+ *
+ * @param coherent Initialized phase-coherent timing context.
+ * @return System time in ns since epoch.
+ */
+int64_t tsig_coherent_next(const tsig_coherent_t *coherent) {
+  struct timespec realtime;
+  uint64_t frames;
+
+  if (coherent->has_anchor) {
+    frames = coherent->frames - coherent->anchor_frame;
+    return coherent->anchor_time +
+           (int64_t)(frames * coherent_nsecs_sec / coherent->rate);
+  }
+
+  clock_gettime(CLOCK_REALTIME, &realtime);
+
+  return coherent_nsecs(&realtime);
+}
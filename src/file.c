@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * file.c: Raw file output facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "file.h"
+
+#include "audio.h"
+#include "cfg.h"
+#include "log.h"
+#include "profile.h"
+#include "recorder.h"
+#include "writer.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Signal status flags. */
+static volatile sig_atomic_t file_got_sigint = 0;
+static volatile sig_atomic_t file_got_sigterm = 0;
+
+/** Period time in us. Rendering isn't latency-sensitive. */
+static const uint32_t file_period_time = 500000;
+
+/** Time conversions. */
+static const uint32_t file_usecs_sec = 1000000;
+
+/** Signal handler. */
+static void file_signal_handler(int signal) {
+  if (signal == SIGINT)
+    file_got_sigint = 1;
+  else if (signal == SIGTERM)
+    file_got_sigterm = 1;
+}
+
+/** Check signal status flags. */
+static int file_got_signal(void) {
+  if (file_got_sigint) {
+    file_got_sigint = 0;
+    return SIGINT;
+  } else if (file_got_sigterm) {
+    file_got_sigterm = 0;
+    return SIGTERM;
+  }
+  return 0;
+}
+
+#ifdef TSIG_DEBUG
+static void file_print(tsig_file_t *file) {
+  const char *audio_format = tsig_audio_format_name(file->audio_format);
+  const char *mode = file->writer.mode == TSIG_WRITER_MODE_URING ? "io_uring"
+                                                                 : "thread";
+  tsig_log_t *log = file->log;
+  tsig_log_dbg("tsig_file_t %p = {", file);
+  tsig_log_dbg("  .path         = \"%s\",", file->path);
+  tsig_log_dbg("  .writer       = {");
+  tsig_log_dbg("    .fd        = %d,", file->writer.fd);
+  tsig_log_dbg("    .is_direct = %d,", file->writer.is_direct);
+  tsig_log_dbg("    .mode      = %s,", mode);
+  tsig_log_dbg("  },");
+  tsig_log_dbg("  .is_direct    = %d,", file->is_direct);
+  tsig_log_dbg("  .audio_format = %s,", audio_format);
+  tsig_log_dbg("  .rate         = %" PRIu32 ",", file->rate);
+  tsig_log_dbg("  .channels     = %" PRIu32 ",", file->channels);
+  tsig_log_dbg("  .period_size  = %" PRIu32 ",", file->period_size);
+  tsig_log_dbg("  .stride       = %" PRIu32 ",", file->stride);
+  tsig_log_dbg("  .timeout      = %u,", file->timeout);
+  tsig_log_dbg("  .profile      = %p,", file->profile);
+  tsig_log_dbg("  .log          = %p,", log);
+  tsig_log_dbg("};");
+}
+#endif /* TSIG_DEBUG */
+
+/**
+ * Initialize raw file output.
+ *
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_file_lib_init(tsig_log_t *log) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  return 0;
+}
+
+/**
+ * Initialize raw file output context.
+ *
+ * @param file Uninitialized raw file output context.
+ * @param cfg Initialized program configuration.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_file_init(tsig_file_t *file, tsig_cfg_t *cfg, tsig_log_t *log) {
+  int err;
+
+  *file = (tsig_file_t){
+      .path = cfg->file,
+      .is_direct = cfg->direct,
+      .audio_format = cfg->format,
+      .rate = cfg->rate,
+      .channels = cfg->channels,
+      .period_size = file_period_time * (uint64_t)cfg->rate / file_usecs_sec,
+      .stride = tsig_audio_format_phys_width(cfg->format) * cfg->channels,
+      .timeout = cfg->timeout,
+      .log = log,
+  };
+
+  err = tsig_writer_init(&file->writer, file->path, file->is_direct, log);
+  if (err < 0)
+    return err;
+
+#ifndef TSIG_DEBUG
+  tsig_log_dbg("Opened file %s %s %" PRIu32 " Hz %" PRIu32 "ch, period %" PRIu32
+               ".",
+               file->path, tsig_audio_format_name(file->audio_format),
+               file->rate, file->channels, file->period_size);
+#else
+  file_print(file);
+#endif /* TSIG_DEBUG */
+
+  return 0;
+}
+
+/**
+ * Convert generated samples directly into the writer's buffers.
+ *
+ * A frame straddling two buffers is instead converted into `frame` and copied.
+ */
+static int file_write(tsig_file_t *file, tsig_audio_sample_t cb_buf[],
+                      uint32_t size, uint8_t frame[]) {
+  bool is_split;
+  uint8_t *out;
+  size_t avail;
+  uint32_t len;
+  int err;
+
+  while (size) {
+    out = tsig_writer_get_buf(&file->writer, &avail);
+    len = avail / file->stride < size ? avail / file->stride : size;
+
+    is_split = !len;
+    if (is_split) {
+      out = frame;
+      len = 1;
+    }
+
+    if (file->profile)
+      tsig_profile_begin(file->profile, TSIG_PROFILE_FILL);
+
+    tsig_audio_fill_buffer(file->audio_format, file->channels, len, out,
+                           cb_buf);
+
+    if (file->profile) {
+      tsig_profile_end(file->profile, TSIG_PROFILE_FILL, len);
+      tsig_profile_begin(file->profile, TSIG_PROFILE_WRITE);
+    }
+
+    if (is_split)
+      err = tsig_writer_write(&file->writer, frame, file->stride);
+    else
+      err = tsig_writer_put_buf(&file->writer, (size_t)file->stride * len);
+
+    if (file->profile)
+      tsig_profile_end(file->profile, TSIG_PROFILE_WRITE, len);
+
+    if (err < 0)
+      return err;
+
+    cb_buf += len;
+    size -= len;
+  }
+
+  return 0;
+}
+
+/**
+ * Raw file output loop.
+ *
+ * Output is rendered as fast as it can be written. A user timeout is the
+ * duration of output to render rather than the time to run.
+ *
+ * @param file Initialized raw file output context.
+ * @param cb Sample generator callback function.
+ * @param cb_data Callback function context object.
+ * @return Signal value if loop exited normally,
+ *  negative error code upon error.
+ */
+int tsig_file_loop(tsig_file_t *file, tsig_audio_cb_t cb, void *cb_data) {
+  struct sigaction sa = {.sa_handler = &file_signal_handler};
+  uint64_t frames = (uint64_t)file->timeout * file->rate;
+  uint32_t size = file->period_size;
+  tsig_log_t *log = file->log;
+  tsig_audio_sample_t *cb_buf;
+  struct sigaction sa_term;
+  struct sigaction sa_int;
+  uint8_t *frame;
+  int err;
+
+  cb_buf = malloc(sizeof(*cb_buf) * size);
+  if (!cb_buf) {
+    tsig_log_err("Failed to allocate generated sample buffer");
+    return -ENOMEM;
+  }
+
+  /* Frames are otherwise converted directly into the writer's buffers. */
+  frame = malloc(file->stride);
+  if (!frame) {
+    tsig_log_err("Failed to allocate output frame buffer");
+    err = -ENOMEM;
+    goto out_free_cb_buf;
+  }
+
+  /* Install signal handler. */
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, &sa_int);
+  sigaction(SIGTERM, &sa, &sa_term);
+
+  for (;;) {
+    /* Stop after the last period when rendering a fixed duration. */
+    if (file->timeout && frames <= size) {
+      if (!frames) {
+        err = SIGALRM;
+        break;
+      }
+      size = frames;
+    }
+
+    /* Generate one period's worth of 1ch samples. */
+    cb(cb_data, cb_buf, size);
+
+    err = file_write(file, cb_buf, size, frame);
+    tsig_recorder_event(TSIG_RECORDER_WRITE, size, err);
+
+    if (err < 0) {
+      tsig_log_err("Failed to write to file %s: %s", file->path,
+                   strerror(-err));
+      break;
+    }
+
+    frames -= size;
+
+    err = file_got_signal();
+    if (err)
+      break;
+  }
+
+  sigaction(SIGTERM, &sa_term, NULL);
+  sigaction(SIGINT, &sa_int, NULL);
+
+  free(frame);
+
+out_free_cb_buf:
+  free(cb_buf);
+
+  return err;
+}
+
+/**
+ * Deinitialize raw file output context.
+ *
+ * Writes any output still buffered.
+ *
+ * @param file Initialized raw file output context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_file_deinit(tsig_file_t *file) {
+  return tsig_writer_deinit(&file->writer);
+}
+
+/**
+ * Deinitialize raw file output.
+ *
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_file_lib_deinit(tsig_log_t *log) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  return 0;
+}
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * governor.c: Adaptive output quality facilities.
+ *
+ * On an overloaded machine, xruns corrupt the time code far worse than a less
+ * polished waveform would. The governor watches how long the waveform
+ * generator callback takes relative to the duration of the audio it produces
+ * (its load, the complement of its deadline margin), as well as any xruns
+ * reported by the audio backend.
+ *
+ * At each minute boundary, if the past minute had an xrun or a callback with
+ * too little margin, output quality steps down one level: gain smoothing is
+ * turned off, then the sine wave is read from a table of one period instead
+ * of being generated, then a square wave is output instead. Once the callback
+ * has had plenty of margin for several minutes, quality steps back up.
+ *
+ * Changing levels only at minute boundaries keeps each minute's waveform
+ * consistent, and every change is logged.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "governor.h"
+
+#include "log.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/** Worst callback load in permille above which quality steps down. */
+static const uint32_t governor_load_high = 500;
+
+/** Worst callback load in permille below which there is headroom. */
+static const uint32_t governor_load_low = 150;
+
+/** Consecutive minutes with headroom before quality steps up. */
+static const uint32_t governor_calm_mins = 5;
+
+/** Nanoseconds per second. */
+static const int64_t governor_nsecs_sec = 1000000000;
+
+/** Output quality level names. */
+static const char *governor_level_names[] = {
+    "full",         /* TSIG_GOVERNOR_FULL */
+    "no smoothing", /* TSIG_GOVERNOR_NO_SMOOTH */
+    "cached",       /* TSIG_GOVERNOR_CACHED */
+    "square",       /* TSIG_GOVERNOR_SQUARE */
+};
+
+/** Get a CLOCK_MONOTONIC timestamp in ns. */
+static int64_t governor_now(void) {
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return 0;
+
+  return ts.tv_sec * governor_nsecs_sec + ts.tv_nsec;
+}
+
+/** Find the next available level in a direction, stopping at either end. */
+static tsig_governor_level_t governor_step(tsig_governor_level_t level,
+                                           uint32_t levels, int step) {
+  do
+    level += step;
+  while (level > TSIG_GOVERNOR_FULL && level < TSIG_GOVERNOR_SQUARE &&
+         !(levels & 1 << level));
+
+  return level;
+}
+
+/**
+ * Initialize an adaptive output quality context.
+ *
+ * @param governor Uninitialized adaptive output quality context.
+ * @param rate Sample rate.
+ * @param log Initialized logging context.
+ */
+void tsig_governor_init(tsig_governor_t *governor, uint32_t rate,
+                        tsig_log_t *log) {
+  memset(governor, 0, sizeof(*governor));
+
+  governor->level = TSIG_GOVERNOR_FULL;
+  governor->rate = rate;
+  governor->log = log;
+}
+
+/**
+ * Note the start of a waveform generator callback.
+ *
+ * @param governor Initialized adaptive output quality context.
+ */
+void tsig_governor_begin(tsig_governor_t *governor) {
+  governor->started = governor_now();
+}
+
+/**
+ * Note the end of a waveform generator callback.
+ *
+ * @param governor Initialized adaptive output quality context.
+ * @param size Count of samples generated.
+ */
+void tsig_governor_end(tsig_governor_t *governor, uint32_t size) {
+  int64_t duration = (int64_t)size * governor_nsecs_sec / governor->rate;
+  int64_t elapsed;
+  int64_t load;
+
+  if (!governor->started || !duration)
+    return;
+
+  elapsed = governor_now() - governor->started;
+  governor->started = 0;
+
+  load = elapsed * 1000 / duration;
+  if (load > governor->load)
+    governor->load = load > UINT32_MAX ? UINT32_MAX : load;
+}
+
+/**
+ * Note a buffer xrun reported by an audio backend.
+ *
+ * @param governor Initialized adaptive output quality context.
+ */
+void tsig_governor_xrun(tsig_governor_t *governor) {
+  governor->xruns++;
+  governor->xruns_total++;
+}
+
+/**
+ * Choose the output quality level for the next minute.
+ *
+ * This should be called at each minute boundary. Measurements are reset.
+ *
+ * @param governor Initialized adaptive output quality context.
+ * @param levels Bitfield of (1 << level) for each level that would make a
+ *  difference. TSIG_GOVERNOR_FULL and TSIG_GOVERNOR_SQUARE always do.
+ * @return Output quality level.
+ */
+tsig_governor_level_t tsig_governor_update(tsig_governor_t *governor,
+                                           uint32_t levels) {
+  bool is_starved = governor->xruns || governor->load > governor_load_high;
+  bool has_headroom = !governor->xruns && governor->load < governor_load_low;
+  tsig_governor_level_t level = governor->level;
+  tsig_log_t *log = governor->log;
+
+  levels |= 1 << TSIG_GOVERNOR_FULL | 1 << TSIG_GOVERNOR_SQUARE;
+
+  governor->calm = has_headroom ? governor->calm + 1 : 0;
+
+  /* A level may stop making a difference, e.g. after a sample rate change. */
+  if ((is_starved || !(levels & 1 << level)) && level < TSIG_GOVERNOR_SQUARE) {
+    level = governor_step(level, levels, 1);
+  } else if (governor->calm >= governor_calm_mins &&
+             level > TSIG_GOVERNOR_FULL) {
+    level = governor_step(level, levels, -1);
+    governor->calm = 0;
+  }
+
+  if (level != governor->level) {
+    tsig_log_note("Output quality %s to %s (worst callback load %" PRIu32
+                  ".%" PRIu32 "%%, %" PRIu32 " xruns).",
+                  level > governor->level ? "reduced" : "restored",
+                  governor_level_names[level], governor->load / 10,
+                  governor->load % 10, governor->xruns);
+
+    governor->level = level;
+    governor->transitions++;
+  }
+
+  governor->load = 0;
+  governor->xruns = 0;
+
+  return level;
+}
+
+/**
+ * Log a summary of adaptive output quality.
+ *
+ * @param governor Initialized adaptive output quality context.
+ */
+void tsig_governor_print(const tsig_governor_t *governor) {
+  tsig_log_t *log = governor->log;
+
+  tsig_log("Governor: output quality %s, %" PRIu64 " changes, %" PRIu64
+           " xruns.",
+           governor_level_names[governor->level], governor->transitions,
+           governor->xruns_total);
+}
+
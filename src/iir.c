@@ -16,6 +16,9 @@
  *
  *   A = 2 * cos(2 * pi * F / R)
  *
+ * A fixed-point variant of the generator keeps A and Y in Q30 format for CPUs
+ * with slow double-precision math, e.g. ARMv6 with VFP2. Its output is Q15.
+ *
  * Copyright © 2025 James Seo <james@equiv.tech>
  *
  * [1]: Y. Cheng, "TMS320C62x Algorithm: Sine Wave Generation",
@@ -178,6 +181,15 @@ static uint32_t iir_gcd(uint32_t a, uint32_t b) {
   return a;
 }
 
+/** Convert a double in [-2.0, 2.0] to Q30 fixed-point, saturating. */
+static int32_t iir_q30(double x) {
+  double q = x * (1 << 30);
+  return q >= INT32_MAX   ? INT32_MAX
+         : q <= INT32_MIN ? INT32_MIN
+         : q >= 0.0       ? (int32_t)(q + 0.5)
+                          : (int32_t)(q - 0.5);
+}
+
 /**
  * Initialize an IIR filter sine wave generator.
  *
@@ -203,6 +215,7 @@ void tsig_iir_init(tsig_iir_t *iir, uint32_t freq, uint32_t rate, int phase) {
   phase_delta = freq / gcd;
   phase_base = rate / gcd;
   iir->period = phase_base;
+  iir->delta = phase_delta;
 
   /* Compute A as twice the cosine of the phase change per sample. */
   angle = iir_2pi * phase_delta / phase_base;
@@ -217,6 +230,7 @@ void tsig_iir_init(tsig_iir_t *iir, uint32_t freq, uint32_t rate, int phase) {
    * now signifies the numerator of this fraction, not a sample count.
    */
   phase = ((int64_t)phase * phase_delta) % phase_base;
+  iir->angle = phase < 0 ? phase + phase_base : phase;
 
   /* Prime the generator with the first two samples. */
   angle = iir_2pi * phase / phase_base;
@@ -229,6 +243,11 @@ void tsig_iir_init(tsig_iir_t *iir, uint32_t freq, uint32_t rate, int phase) {
   angle = iir_2pi * phase / phase_base;
   iir->init_y1 = iir_sin(angle);
 
+  /* Prepare the fixed-point generator as well. */
+  iir->a_q30 = iir_q30(iir->a);
+  iir->init_y0_q30 = iir_q30(iir->init_y0);
+  iir->init_y1_q30 = iir_q30(iir->init_y1);
+
   /* Set the generator to the start of its period. */
   iir->sample = 0;
 }
@@ -269,3 +288,117 @@ double tsig_iir_next(tsig_iir_t *iir) {
 
   return ret;
 }
+
+/**
+ * Generate a fixed-point sample from an IIR filter sine wave generator.
+ *
+ * This tracks the same period as tsig_iir_next(), but computes samples in
+ * Q30 fixed-point, needing only a 32x32->64-bit multiply per sample.
+ * A generator should be advanced by only one of the two functions.
+ *
+ * @param iir: Pointer to an initialized IIR filter sine wave generator.
+ * @return Sample value in Q15 fixed-point, i.e. in [-32768, 32768].
+ */
+int32_t tsig_iir_next_q15(tsig_iir_t *iir) {
+  int32_t next_y;
+  int32_t ret;
+
+  /* Reset generator state at the start of each period, as above. */
+  if (!iir->sample) {
+    iir->y0_q30 = iir->init_y0_q30;
+    iir->y1_q30 = iir->init_y1_q30;
+  }
+
+  ret = iir->y0_q30;
+
+  /* Generate the next sample unless a reset is imminent. */
+  if (iir->sample + 2 < iir->period) {
+    next_y = (((int64_t)iir->a_q30 * iir->y1_q30 + (1 << 29)) >> 30) -
+             iir->y0_q30;
+    iir->y0_q30 = iir->y1_q30;
+    iir->y1_q30 = next_y;
+    iir->sample++;
+  } else if (iir->sample + 1 < iir->period) {
+    iir->y0_q30 = iir->y1_q30;
+    iir->sample++;
+  } else {
+    iir->sample = 0;
+  }
+
+  return (ret + (1 << 14)) >> 15;
+}
+
+/**
+ * Generate a square wave sample from an IIR filter sine wave generator.
+ *
+ * The square wave has the same period and phase as the sine wave, but needs
+ * only an addition and a comparison per sample. A generator switching to or
+ * from this function should be moved with tsig_iir_seek() first.
+ *
+ * @param iir: Pointer to an initialized IIR filter sine wave generator.
+ * @return 1 during the positive half of the period, -1 otherwise.
+ */
+int tsig_iir_next_square(tsig_iir_t *iir) {
+  int ret = 2 * iir->angle < iir->period ? 1 : -1;
+
+  iir->angle += iir->delta;
+  if (iir->angle >= iir->period)
+    iir->angle -= iir->period;
+
+  if (++iir->sample == iir->period)
+    iir->sample = 0;
+
+  return ret;
+}
+
+/**
+ * Advance an IIR filter sine wave generator without generating a sample.
+ *
+ * This is for callers that look up samples by their number in the period,
+ * e.g. from a table of one period's samples. A generator switching to or from
+ * this function should be moved with tsig_iir_seek() first.
+ *
+ * @param iir: Pointer to an initialized IIR filter sine wave generator.
+ * @return Sample number in period before advancing.
+ */
+uint32_t tsig_iir_next_index(tsig_iir_t *iir) {
+  uint32_t ret = iir->sample;
+
+  if (++iir->sample == iir->period)
+    iir->sample = 0;
+
+  return ret;
+}
+
+/**
+ * Move an IIR filter sine wave generator to a sample within its period.
+ *
+ * The filter state is recomputed directly rather than by generating samples,
+ * so this is cheap enough to do whenever switching generator functions.
+ *
+ * @param iir: Pointer to an initialized IIR filter sine wave generator.
+ * @param sample: Sample number in period.
+ */
+void tsig_iir_seek(tsig_iir_t *iir, uint32_t sample) {
+  int64_t angle;
+
+  sample %= iir->period;
+
+  /* As in tsig_iir_init(), but normalized to fall within [0, period). */
+  angle = ((int64_t)iir->phase + sample) * iir->delta % iir->period;
+  if (angle < 0)
+    angle += iir->period;
+
+  iir->sample = sample;
+  iir->angle = angle;
+  iir->y0 = iir_sin(iir_2pi * angle / iir->period);
+
+  angle += iir->delta;
+  if (angle >= iir->period)
+    angle -= iir->period;
+
+  iir->y1 = iir_sin(iir_2pi * angle / iir->period);
+
+  iir->y0_q30 = iir_q30(iir->y0);
+  iir->y1_q30 = iir_q30(iir->y1);
+}
@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * jitter.c: Edge timing measurement facilities.
+ *
+ * Whenever the waveform generator changes transmit levels, it notes the index
+ * of the frame at the new level and the system time at which the change was
+ * supposed to happen. Audio backends periodically report a playback timing
+ * anchor: a timestamp, and the number of frames between the frame playing at
+ * that time and the next frame to be generated. Together, these predict when
+ * each change actually reaches the DAC, and the difference from the intended
+ * time is kept as running statistics and a histogram.
+ *
+ * The mean error is mostly output latency, which the waveform generator does
+ * not compensate for. The spread is the timing jitter a receiver sees.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "jitter.h"
+
+#include "log.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/** Interval between logged summaries in ns. */
+static const int64_t jitter_report_interval = 600000000000;
+
+/** Maximum number of rows in a printed histogram. */
+#define TSIG_JITTER_PRINT_ROWS 16
+
+/** Maximum width of a bar in a printed histogram. */
+#define TSIG_JITTER_PRINT_WIDTH 40
+
+/** Time conversions. */
+static const int64_t jitter_nsecs_sec = 1000000000;
+static const int64_t jitter_nsecs_msec = 1000000;
+static const int64_t jitter_nsecs_usec = 1000;
+static const double jitter_usecs_msec = 1000.0;
+
+/** Convert a timespec to ns. */
+static int64_t jitter_nsecs(const struct timespec *ts) {
+  return ts->tv_sec * jitter_nsecs_sec + ts->tv_nsec;
+}
+
+/** Find the histogram bin for an error in us. */
+static uint32_t jitter_bin(int64_t error) {
+  return (error - TSIG_JITTER_MIN_USECS) / TSIG_JITTER_BIN_USECS;
+}
+
+/** Find the error in us at the middle of a histogram bin. */
+static int64_t jitter_bin_usecs(uint32_t bin) {
+  return TSIG_JITTER_MIN_USECS + (int64_t)bin * TSIG_JITTER_BIN_USECS +
+         TSIG_JITTER_BIN_USECS / 2;
+}
+
+/** Record an error in us. */
+static void jitter_record(tsig_jitter_t *jitter, int64_t error) {
+  double delta = error - jitter->mean;
+
+  /* cf. Welford's online algorithm */
+  jitter->count++;
+  jitter->mean += delta / jitter->count;
+  jitter->m2 += delta * (error - jitter->mean);
+
+  if (error < jitter->min)
+    jitter->min = error;
+  if (error > jitter->max)
+    jitter->max = error;
+
+  if (error < TSIG_JITTER_MIN_USECS)
+    jitter->below++;
+  else if (error >= TSIG_JITTER_MAX_USECS)
+    jitter->above++;
+  else
+    jitter->bins[jitter_bin(error)]++;
+}
+
+/** Integer square root, so as not to need libm. */
+static uint64_t jitter_isqrt(uint64_t x) {
+  uint64_t r = x;
+  uint64_t y;
+
+  if (x < 2)
+    return x;
+
+  /* cf. Newton's method */
+  for (y = (r + x / r) / 2; y < r; y = (r + x / r) / 2)
+    r = y;
+
+  return r;
+}
+
+/** Standard deviation of recorded errors in us. */
+static uint64_t jitter_stddev(const tsig_jitter_t *jitter) {
+  if (jitter->count < 2)
+    return 0;
+
+  return jitter_isqrt(jitter->m2 / (jitter->count - 1));
+}
+
+/** Log a one-line summary of recorded errors. */
+static void jitter_summary(const tsig_jitter_t *jitter) {
+  tsig_log_t *log = jitter->log;
+
+  if (!jitter->count) {
+    tsig_log("Edge timing: no edges measured.");
+    return;
+  }
+
+  tsig_log("Edge timing: %" PRIu64 " edges, mean %+.3f ms, sd %.3f ms, "
+           "p50 %+.3f ms, p99 %+.3f ms, range %+.3f to %+.3f ms.",
+           jitter->count, jitter->mean / jitter_usecs_msec,
+           jitter_stddev(jitter) / jitter_usecs_msec,
+           tsig_jitter_percentile(jitter, 500) / jitter_usecs_msec,
+           tsig_jitter_percentile(jitter, 990) / jitter_usecs_msec,
+           jitter->min / jitter_usecs_msec, jitter->max / jitter_usecs_msec);
+}
+
+/** Resolve pending edges against an anchor in system time. */
+static void jitter_resolve(tsig_jitter_t *jitter, int64_t timestamp,
+                           int64_t delay) {
+  int64_t frame = (int64_t)jitter->frames - delay;
+  tsig_jitter_edge_t *edge;
+  int64_t predicted;
+
+  for (uint32_t i = 0; i < jitter->edge_count; i++) {
+    edge = &jitter->edges[i];
+    predicted = timestamp + ((int64_t)edge->frame - frame) * jitter_nsecs_sec /
+                                jitter->rate;
+    jitter_record(jitter, (predicted - edge->intended) / jitter_nsecs_usec);
+  }
+
+  jitter->edge_count = 0;
+
+  if (!jitter->next_report) {
+    jitter->next_report = timestamp + jitter_report_interval;
+  } else if (timestamp >= jitter->next_report) {
+    jitter->next_report += jitter_report_interval;
+    jitter_summary(jitter);
+  }
+}
+
+/**
+ * Initialize an edge timing measurement context.
+ *
+ * @param jitter Uninitialized edge timing measurement context.
+ * @param rate Sample rate.
+ * @param log Initialized logging context.
+ */
+void tsig_jitter_init(tsig_jitter_t *jitter, uint32_t rate, tsig_log_t *log) {
+  memset(jitter, 0, sizeof(*jitter));
+
+  jitter->rate = rate;
+  jitter->min = INT64_MAX;
+  jitter->max = INT64_MIN;
+  jitter->log = log;
+}
+
+/**
+ * Note a transmit level change in the buffer being generated.
+ *
+ * @param jitter Initialized edge timing measurement context.
+ * @param offset Index of first frame at new level within the buffer.
+ * @param timestamp Intended system time in milliseconds since epoch.
+ */
+void tsig_jitter_edge(tsig_jitter_t *jitter, uint32_t offset,
+                      int64_t timestamp) {
+  /* Nothing is playing yet or the backend reports no anchors. Drop it. */
+  if (jitter->edge_count == TSIG_JITTER_EDGES_MAX) {
+    jitter->dropped++;
+    return;
+  }
+
+  jitter->edges[jitter->edge_count++] = (tsig_jitter_edge_t){
+      .frame = jitter->frames + offset,
+      .intended = timestamp * jitter_nsecs_msec,
+  };
+}
+
+/**
+ * Account for a generated buffer.
+ *
+ * @param jitter Initialized edge timing measurement context.
+ * @param size Count of frames in the buffer.
+ */
+void tsig_jitter_advance(tsig_jitter_t *jitter, uint32_t size) {
+  jitter->frames += size;
+}
+
+/**
+ * Resolve pending edges against a playback timing anchor.
+ *
+ * @param jitter Initialized edge timing measurement context.
+ * @param timestamp CLOCK_MONOTONIC time in ns at which the anchor was taken.
+ * @param delay Count of frames between the frame playing at that time
+ *  and the next frame to be generated.
+ */
+void tsig_jitter_anchor(tsig_jitter_t *jitter, int64_t timestamp,
+                        int64_t delay) {
+  struct timespec realtime;
+  struct timespec monotonic;
+
+  if (!jitter->edge_count)
+    return;
+
+  /* Edges are in system time, which may be stepped, so convert each time. */
+  if (clock_gettime(CLOCK_REALTIME, &realtime) ||
+      clock_gettime(CLOCK_MONOTONIC, &monotonic))
+    return;
+
+  timestamp += jitter_nsecs(&realtime) - jitter_nsecs(&monotonic);
+
+  jitter_resolve(jitter, timestamp, delay);
+}
+
+/**
+ * Estimate a percentile of recorded errors.
+ *
+ * @param jitter Initialized edge timing measurement context.
+ * @param permille Percentile in tenths of a percent, from 0 to 1000.
+ * @return Estimated error in us, to the middle of a histogram bin.
+ */
+int64_t tsig_jitter_percentile(const tsig_jitter_t *jitter, uint32_t permille) {
+  uint64_t rank = (jitter->count * permille + 999) / 1000;
+  uint64_t seen = jitter->below;
+  int64_t error;
+
+  if (!jitter->count)
+    return 0;
+
+  if (!rank || seen >= rank)
+    return jitter->min;
+
+  for (uint32_t i = 0; i < TSIG_JITTER_BINS; i++) {
+    seen += jitter->bins[i];
+    if (seen >= rank) {
+      error = jitter_bin_usecs(i);
+      return error < jitter->min   ? jitter->min
+             : error > jitter->max ? jitter->max
+                                   : error;
+    }
+  }
+
+  return jitter->max;
+}
+
+/**
+ * Log a summary and histogram of recorded errors.
+ *
+ * @param jitter Initialized edge timing measurement context.
+ */
+void tsig_jitter_print(const tsig_jitter_t *jitter) {
+  char bar[TSIG_JITTER_PRINT_WIDTH + 1];
+  tsig_log_t *log = jitter->log;
+  uint32_t rows[TSIG_JITTER_PRINT_ROWS];
+  uint32_t row_bins;
+  uint32_t row_max;
+  uint32_t first;
+  uint32_t last;
+  uint32_t len;
+  uint32_t n;
+
+  jitter_summary(jitter);
+
+  if (jitter->dropped)
+    tsig_log_warn("Edge timing: %" PRIu64 " edges dropped.", jitter->dropped);
+
+  if (jitter->count == jitter->below + jitter->above)
+    return;
+
+  /* Merge bins so that the occupied part of the histogram fits. */
+  first = jitter_bin(jitter->min < TSIG_JITTER_MIN_USECS ? TSIG_JITTER_MIN_USECS
+                                                         : jitter->min);
+  last = jitter_bin(jitter->max >= TSIG_JITTER_MAX_USECS
+                        ? TSIG_JITTER_MAX_USECS - 1
+                        : jitter->max);
+  row_bins = (last - first) / TSIG_JITTER_PRINT_ROWS + 1;
+  n = (last - first) / row_bins + 1;
+
+  memset(rows, 0, sizeof(rows));
+  row_max = 0;
+
+  for (uint32_t i = 0; i < n; i++) {
+    for (uint32_t j = 0; j < row_bins && first + i * row_bins + j <= last; j++)
+      rows[i] += jitter->bins[first + i * row_bins + j];
+    if (rows[i] > row_max)
+      row_max = rows[i];
+  }
+
+  if (jitter->below)
+    tsig_log("  below %+9.3f ms %" PRIu64,
+             TSIG_JITTER_MIN_USECS / jitter_usecs_msec, jitter->below);
+
+  for (uint32_t i = 0; i < n; i++) {
+    len = ((uint64_t)rows[i] * TSIG_JITTER_PRINT_WIDTH + row_max - 1) / row_max;
+    memset(bar, '#', len);
+    bar[len] = '\0';
+    tsig_log("  %+9.3f ms %-*s %" PRIu32,
+             (TSIG_JITTER_MIN_USECS +
+              (int64_t)(first + i * row_bins) * TSIG_JITTER_BIN_USECS) /
+                 jitter_usecs_msec,
+             TSIG_JITTER_PRINT_WIDTH, bar, rows[i]);
+  }
+
+  if (jitter->above)
+    tsig_log("  above %+9.3f ms %" PRIu64,
+             TSIG_JITTER_MAX_USECS / jitter_usecs_msec, jitter->above);
+}
@@ -9,6 +9,7 @@
 
 #include "log.h"
 
+#include "binlog.h"
 #include "defaults.h"
 
 #include <syslog.h>
@@ -69,6 +70,9 @@ static tsig_log_t log_default = {
     .status_line = {{""}},
 };
 
+/** Binary log context. */
+static tsig_binlog_t log_binlog;
+
 /** Find next write position and remaining space in a status line buffer. */
 static void log_status_line_find_write_pos(char buf[], int len, char **wr,
                                            int *remain) {
@@ -236,6 +240,7 @@ static void log_print(tsig_log_t *log) {
   tsig_log_dbg("  .is_stderr_tty  = %d,", log->is_stderr_tty);
   tsig_log_dbg("  .log_file       = %p,", log->log_file);
   tsig_log_dbg("  .syslog         = %d,", log->syslog);
+  tsig_log_dbg("  .binlog         = %p,", log->binlog);
   tsig_log_dbg("  .have_status    = %d,", log->have_status);
   tsig_log_dbg("  .status_lines   = %d,", log->status_lines);
   tsig_log_dbg("  .status_line    = %p,", &log->status_line);
@@ -281,12 +286,16 @@ void tsig_log_init(tsig_log_t *log) {
  *
  * @param log Initialized logging context.
  * @param log_file Log file. Will emit logs to it if not NULL.
+ * @param binlog_file Binary log file. Will record logs to it if not NULL.
  * @param syslog Whether to emit logs to syslog.
  * @param verbose Whether to emit verbose logs.
  * @param quiet Whether to emit no logs to console.
  */
-void tsig_log_finish_init(tsig_log_t *log, char log_file[], bool syslog,
-                          bool verbose, bool quiet) {
+void tsig_log_finish_init(tsig_log_t *log, char log_file[],
+                          char binlog_file[], bool syslog, bool verbose,
+                          bool quiet) {
+  int err;
+
   if (verbose)
     log->level = LOG_DEBUG;
 
@@ -306,6 +315,16 @@ void tsig_log_finish_init(tsig_log_t *log, char log_file[], bool syslog,
                     strerror(errno));
   }
 
+  if (*binlog_file) {
+    err = tsig_binlog_open(&log_binlog, binlog_file);
+
+    if (err < 0)
+      tsig_log_warn("Failed to open binary log file \"%s\": %s", binlog_file,
+                    strerror(-err));
+    else
+      log->binlog = &log_binlog;
+  }
+
 #ifdef TSIG_DEBUG
   log_print(log);
 #endif /* TSIG_DEBUG */
@@ -318,6 +337,7 @@ void tsig_log_finish_init(tsig_log_t *log, char log_file[], bool syslog,
  *
  * Depending on the circumstances, the same message is emitted
  * to the console (stdout/stderr), a log file, and/or syslog.
+ * A binary log, if any, records it regardless of log level.
  *
  * @param log Initialized logging context.
  * @param level Log level.
@@ -330,6 +350,7 @@ __attribute__((format(printf, 5, 6))) void tsig_log_msg(tsig_log_t *log,
                                                         const char *src_file,
                                                         int src_line,
                                                         const char *fmt, ...) {
+  va_list bparams;
   va_list cparams;
   va_list fparams;
   va_list sparams;
@@ -337,6 +358,15 @@ __attribute__((format(printf, 5, 6))) void tsig_log_msg(tsig_log_t *log,
 
   va_start(params, fmt);
 
+  if (log->binlog) {
+    va_copy(bparams, params);
+    tsig_binlog_write(log->binlog, level, fmt, bparams);
+    va_end(bparams);
+  }
+
+  if (level > log->level)
+    goto out_va_end;
+
   if (log->console) {
     va_copy(cparams, params);
     log_msg_console(log, level, src_file, src_line, fmt, cparams);
@@ -357,6 +387,7 @@ __attribute__((format(printf, 5, 6))) void tsig_log_msg(tsig_log_t *log,
     va_end(sparams);
   }
 
+out_va_end:
   va_end(params);
 }
 
@@ -453,6 +484,11 @@ void tsig_log_deinit(tsig_log_t *log) {
   if (log->log_file)
     fclose(log->log_file);
 
+  if (log->binlog) {
+    tsig_binlog_close(log->binlog);
+    log->binlog = NULL;
+  }
+
   log_status_clear(log);
 }
 
@@ -11,9 +11,12 @@
 
 #include "audio.h"
 #include "cfg.h"
+#include "coherent.h"
 #include "defaults.h"
+#include "jitter.h"
 #include "log.h"
 #include "mapping.h"
+#include "profile.h"
 
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
@@ -45,6 +48,11 @@ static int (*pipewire_pw_properties_setf)(struct pw_properties *properties, cons
 static int (*pipewire_pw_stream_connect)(struct pw_stream *stream, enum spa_direction direction, uint32_t target_id, enum pw_stream_flags flags, const struct spa_pod **params, uint32_t n_params);
 static struct pw_buffer *(*pipewire_pw_stream_dequeue_buffer)(struct pw_stream *stream);
 static void (*pipewire_pw_stream_destroy)(struct pw_stream *stream);
+#if PW_CHECK_VERSION(0, 3, 50)
+static int (*pipewire_pw_stream_get_time_n)(struct pw_stream *stream, struct pw_time *time, size_t size);
+#else
+static int (*pipewire_pw_stream_get_time)(struct pw_stream *stream, struct pw_time *time);
+#endif
 static struct pw_stream *(*pipewire_pw_stream_new_simple)(struct pw_loop *loop, const char *name, struct pw_properties *props, const struct pw_stream_events *events, void *data);
 static int (*pipewire_pw_stream_queue_buffer)(struct pw_stream *stream, struct pw_buffer *buffer);
 /* clang-format on */
@@ -73,6 +81,9 @@ static const tsig_mapping_nn_t pipewire_format_map[] = {
     {TSIG_AUDIO_FORMAT_FLOAT64, SPA_AUDIO_FORMAT_F64},
     {TSIG_AUDIO_FORMAT_FLOAT64_LE, SPA_AUDIO_FORMAT_F64_LE},
     {TSIG_AUDIO_FORMAT_FLOAT64_BE, SPA_AUDIO_FORMAT_F64_BE},
+    {TSIG_AUDIO_FORMAT_S24_3, SPA_AUDIO_FORMAT_S24},
+    {TSIG_AUDIO_FORMAT_S24_3LE, SPA_AUDIO_FORMAT_S24_LE},
+    {TSIG_AUDIO_FORMAT_S24_3BE, SPA_AUDIO_FORMAT_S24_BE},
     {0, 0},
 };
 
@@ -89,6 +100,8 @@ static const tsig_mapping_t pipewire_formats[] = {
     {"F32_BE", SPA_AUDIO_FORMAT_F32_BE},
     {"F64_LE", SPA_AUDIO_FORMAT_F64_LE},
     {"F64_BE", SPA_AUDIO_FORMAT_F64_BE},
+    {"S24_LE", SPA_AUDIO_FORMAT_S24_LE},
+    {"S24_BE", SPA_AUDIO_FORMAT_S24_BE},
     {NULL, 0},
 };
 
@@ -111,6 +124,40 @@ static void pipewire_on_signal(void *data, int signal) {
   pipewire_pw_main_loop_quit(pipewire->loop);
 }
 
+/** Report playback timing for edge timing measurement and coherence. */
+static void pipewire_anchor(tsig_pipewire_t *pipewire) {
+  struct pw_time time;
+  int64_t delay;
+  int err;
+
+#if PW_CHECK_VERSION(0, 3, 50)
+  err = pipewire_pw_stream_get_time_n(pipewire->stream, &time, sizeof(time));
+#else
+  err = pipewire_pw_stream_get_time(pipewire->stream, &time);
+#endif
+  if (err < 0 || !time.now || !time.rate.denom)
+    return;
+
+  /*
+   * The delay is in graph clock ticks from the start of the current cycle to
+   * when the first queued frame plays. Queued frames are counted as given in
+   * struct pw_buffer::size, and resampler frames are counted separately.
+   */
+
+  delay = time.delay * pipewire->rate * time.rate.num / time.rate.denom;
+  delay += time.queued;
+
+#if PW_CHECK_VERSION(0, 3, 50)
+  delay += time.buffered;
+#endif
+
+  if (pipewire->jitter)
+    tsig_jitter_anchor(pipewire->jitter, time.now, delay);
+
+  if (pipewire->coherent)
+    tsig_coherent_anchor(pipewire->coherent, time.now, delay);
+}
+
 /** PipeWire process event callback. */
 static void pipewire_on_process(void *data) {
   tsig_pipewire_t *pipewire = data;
@@ -154,14 +201,29 @@ static void pipewire_on_process(void *data) {
   pipewire->cb(pipewire->cb_data, pipewire->cb_buf, size);
 
   /* Fill the output buffer with the generated samples. */
+  if (pipewire->profile)
+    tsig_profile_begin(pipewire->profile, TSIG_PROFILE_FILL);
+
   tsig_audio_fill_buffer(pipewire->audio_format, pipewire->channels, size, buf,
                          pipewire->cb_buf);
 
+  if (pipewire->profile) {
+    tsig_profile_end(pipewire->profile, TSIG_PROFILE_FILL, size);
+    tsig_profile_begin(pipewire->profile, TSIG_PROFILE_WRITE);
+  }
+
   spa_buf->datas[0].chunk->offset = 0;
   spa_buf->datas[0].chunk->stride = pipewire->stride;
   spa_buf->datas[0].chunk->size = size * pipewire->stride;
+  pw_buf->size = size;
 
   pipewire_pw_stream_queue_buffer(pipewire->stream, pw_buf);
+
+  if (pipewire->profile)
+    tsig_profile_end(pipewire->profile, TSIG_PROFILE_WRITE, size);
+
+  if (pipewire->jitter || pipewire->coherent)
+    pipewire_anchor(pipewire);
 }
 
 /** Stream events. */
@@ -189,6 +251,9 @@ static void pipewire_print(tsig_pipewire_t *pipewire) {
   tsig_log_dbg("  .size         = %" PRIu32 ",", pipewire->size);
   tsig_log_dbg("  .audio_format = %s,", audio_format);
   tsig_log_dbg("  .timeout      = %u,", pipewire->timeout);
+  tsig_log_dbg("  .jitter       = %p,", pipewire->jitter);
+  tsig_log_dbg("  .coherent     = %p,", pipewire->coherent);
+  tsig_log_dbg("  .profile      = %p,", pipewire->profile);
   tsig_log_dbg("  .log          = %p,", log);
   tsig_log_dbg("};");
 }
@@ -229,6 +294,11 @@ int tsig_pipewire_lib_init(tsig_log_t *log) {
   pipewire_dlsym_assign(pw_stream_connect);
   pipewire_dlsym_assign(pw_stream_dequeue_buffer);
   pipewire_dlsym_assign(pw_stream_destroy);
+#if PW_CHECK_VERSION(0, 3, 50)
+  pipewire_dlsym_assign(pw_stream_get_time_n);
+#else
+  pipewire_dlsym_assign(pw_stream_get_time);
+#endif
   pipewire_dlsym_assign(pw_stream_new_simple);
   pipewire_dlsym_assign(pw_stream_queue_buffer);
 
@@ -347,7 +417,7 @@ int tsig_pipewire_init(tsig_pipewire_t *pipewire, tsig_cfg_t *cfg,
    * buffer, which should be at least twice as large as we'll ever need.
    */
 
-  pipewire->cb_buf = malloc(buffer_size * sizeof(double));
+  pipewire->cb_buf = malloc(buffer_size * sizeof(*pipewire->cb_buf));
   if (!pipewire->cb_buf) {
     tsig_log_err("Failed to allocate generated sample buffer");
     err = -ENOMEM;
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * plan.c: Startup kernel planning facilities.
+ *
+ * Which sample conversion kernel is fastest depends on the CPU, the sample
+ * format, and the channel count. At startup, each kernel available for the
+ * actual stream is briefly timed converting a sweep across the full range of
+ * sample values, and the fastest one whose output is bit-exact with that of
+ * the generic kernel is used. A kernel that is only as fast as the generic
+ * kernel to within measurement noise isn't worth remembering, so the generic
+ * kernel is kept unless beaten by a clear margin.
+ *
+ * Choices can be remembered in a wisdom file, one per line, keyed by machine
+ * and stream, so that later starts skip the measurement, e.g.:
+ *
+ *   x86_64:Intel(R)_Core(TM)_i5-8250U_CPU_@_1.60GHz f64 S16_LE 2 specialized
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "plan.h"
+
+#include "audio.h"
+#include "log.h"
+
+#include <sys/utsname.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Name of the type of generated samples. */
+#ifdef TSIG_USE_FIXED_POINT
+static const char *plan_sample_type = "q15";
+#else
+static const char *plan_sample_type = "f64";
+#endif /* TSIG_USE_FIXED_POINT */
+
+/** Path to CPU information. */
+static const char *plan_cpuinfo_path = "/proc/cpuinfo";
+
+/** Key in CPU information for the CPU model. */
+static const char *plan_cpuinfo_key = "model name";
+
+/** Nanoseconds per second. */
+static const int64_t plan_nsecs_sec = 1000000000;
+
+/** Get a CLOCK_MONOTONIC timestamp in ns. */
+static int64_t plan_now(void) {
+  struct timespec ts;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return 0;
+
+  return ts.tv_sec * plan_nsecs_sec + ts.tv_nsec;
+}
+
+/** Identify this machine by architecture and CPU model, without spaces. */
+static void plan_machine(char machine[]) {
+  char line[TSIG_PLAN_LINE_SIZE];
+  struct utsname uts;
+  size_t len = 0;
+  char *model;
+  FILE *file;
+
+  if (!uname(&uts))
+    len = snprintf(machine, TSIG_PLAN_MACHINE_SIZE, "%s", uts.machine);
+
+  file = fopen(plan_cpuinfo_path, "r");
+  if (file) {
+    while (fgets(line, sizeof(line), file)) {
+      if (strncmp(line, plan_cpuinfo_key, strlen(plan_cpuinfo_key)))
+        continue;
+
+      model = strchr(line, ':');
+      if (!model)
+        continue;
+
+      model += strspn(model + 1, " \t") + 1;
+      model[strcspn(model, "\n")] = '\0';
+      snprintf(&machine[len], TSIG_PLAN_MACHINE_SIZE - len, ":%s", model);
+      break;
+    }
+
+    fclose(file);
+  }
+
+  if (!machine[0])
+    strcpy(machine, "unknown");
+
+  for (char *p = machine; *p; p++)
+    if (*p == ' ' || *p == '\t')
+      *p = '_';
+}
+
+/** Look up a previously chosen kernel in a wisdom file. */
+static tsig_audio_kernel_t plan_wisdom_find(const char *path, const char *key,
+                                            tsig_log_t *log) {
+  char line[TSIG_PLAN_LINE_SIZE];
+  tsig_audio_kernel_t kernel = TSIG_AUDIO_KERNEL_UNKNOWN;
+  size_t key_len = strlen(key);
+  FILE *file;
+
+  file = fopen(path, "r");
+  if (!file) {
+    if (errno != ENOENT)
+      tsig_log_warn("Failed to open wisdom file \"%s\": %s", path,
+                    strerror(errno));
+    return kernel;
+  }
+
+  /* Later lines win, so that a rerun can overrule an earlier choice. */
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, key, key_len) || line[key_len] != ' ')
+      continue;
+
+    line[strcspn(line, "\n")] = '\0';
+    kernel = tsig_audio_kernel(&line[key_len + 1]);
+  }
+
+  fclose(file);
+
+  return kernel;
+}
+
+/** Remember a chosen kernel in a wisdom file. */
+static void plan_wisdom_add(const char *path, const char *key,
+                            tsig_audio_kernel_t kernel, tsig_log_t *log) {
+  FILE *file;
+
+  file = fopen(path, "a");
+  if (!file) {
+    tsig_log_warn("Failed to open wisdom file \"%s\": %s", path,
+                  strerror(errno));
+    return;
+  }
+
+  fprintf(file, "%s %s\n", key, tsig_audio_kernel_name(kernel));
+
+  if (fclose(file))
+    tsig_log_warn("Failed to write wisdom file \"%s\": %s", path,
+                  strerror(errno));
+}
+
+/** Fill a buffer with a sweep across the full range of sample values. */
+static void plan_sweep(tsig_audio_sample_t cb_buf[], uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+#ifdef TSIG_USE_FIXED_POINT
+    cb_buf[i] = -32768 + (int64_t)i * 65536 / (size - 1);
+#else
+    cb_buf[i] = -1.0 + 2.0 * i / (size - 1);
+#endif /* TSIG_USE_FIXED_POINT */
+  }
+}
+
+/**
+ * Time a kernel converting TSIG_PLAN_FRAMES frames in ns.
+ *
+ * A single conversion takes only microseconds, so each run repeats it for at
+ * least TSIG_PLAN_RUN_NSECS and takes the mean. The fastest run counts.
+ */
+static int64_t plan_time(tsig_audio_kernel_t kernel, tsig_audio_format_t format,
+                         uint32_t channels, uint8_t buf[],
+                         tsig_audio_sample_t cb_buf[]) {
+  int64_t best = INT64_MAX;
+  int64_t count;
+  int64_t start;
+  int64_t time;
+
+  for (int i = 0; i < TSIG_PLAN_RUNS; i++) {
+    count = 0;
+    start = plan_now();
+
+    do {
+      tsig_audio_fill_buffer_kernel(kernel, format, channels, TSIG_PLAN_FRAMES,
+                                    buf, cb_buf);
+      count++;
+      time = plan_now() - start;
+    } while (time < TSIG_PLAN_RUN_NSECS);
+
+    if (time / count < best)
+      best = time / count;
+  }
+
+  return best;
+}
+
+/** Check if a kernel beats the generic kernel by more than the margin. */
+static bool plan_is_faster(int64_t time, int64_t generic_time) {
+  return time * 100 < generic_time * (100 - TSIG_PLAN_MARGIN);
+}
+
+/** Measure each available kernel and find the fastest. */
+static tsig_audio_kernel_t plan_measure(tsig_audio_format_t format,
+                                        uint32_t channels, tsig_log_t *log) {
+  size_t size = TSIG_PLAN_FRAMES * channels *
+                tsig_audio_format_phys_width(format);
+  tsig_audio_kernel_t best = TSIG_AUDIO_KERNEL_GENERIC;
+  tsig_audio_sample_t *cb_buf;
+  int64_t generic_time = INT64_MAX;
+  int64_t best_time = INT64_MAX;
+  uint8_t *expected;
+  uint8_t *buf;
+  int64_t time;
+
+  cb_buf = malloc(sizeof(*cb_buf) * TSIG_PLAN_FRAMES);
+  expected = malloc(size);
+  buf = malloc(size);
+  if (!cb_buf || !expected || !buf) {
+    tsig_log_err("Failed to allocate kernel planning buffers");
+    goto out_free_bufs;
+  }
+
+  plan_sweep(cb_buf, TSIG_PLAN_FRAMES);
+  tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_GENERIC, format, channels,
+                                TSIG_PLAN_FRAMES, expected, cb_buf);
+
+  for (int i = 0; i < TSIG_AUDIO_KERNELS; i++) {
+    memset(buf, 0, size);
+    if (!tsig_audio_fill_buffer_kernel(i, format, channels, TSIG_PLAN_FRAMES,
+                                       buf, cb_buf))
+      continue;
+
+    if (memcmp(buf, expected, size)) {
+      tsig_log_warn("Sample conversion kernel %s is not bit-exact, skipping",
+                    tsig_audio_kernel_name(i));
+      continue;
+    }
+
+    time = plan_time(i, format, channels, buf, cb_buf);
+    tsig_log_dbg("Sample conversion kernel %s took %" PRId64 " ns for %d "
+                 "frames.",
+                 tsig_audio_kernel_name(i), time, TSIG_PLAN_FRAMES);
+
+    /* The generic kernel comes first, and is kept unless clearly beaten. */
+    if (i == TSIG_AUDIO_KERNEL_GENERIC) {
+      generic_time = time;
+      best_time = time;
+    } else if (time < best_time && plan_is_faster(time, generic_time)) {
+      best = i;
+      best_time = time;
+    }
+  }
+
+out_free_bufs:
+  free(buf);
+  free(expected);
+  free(cb_buf);
+
+  return best;
+}
+
+/**
+ * Choose the fastest sample conversion kernel for a stream.
+ *
+ * @param format Output sample format.
+ * @param channels Output channel count.
+ * @param wisdom Path to a wisdom file, or an empty string.
+ * @param log Initialized logging context.
+ * @return Chosen sample conversion kernel.
+ */
+tsig_audio_kernel_t tsig_plan(tsig_audio_format_t format, uint32_t channels,
+                              const char *wisdom, tsig_log_t *log) {
+  char machine[TSIG_PLAN_MACHINE_SIZE] = {0};
+  char key[TSIG_PLAN_LINE_SIZE];
+  tsig_audio_kernel_t kernel;
+
+  plan_machine(machine);
+  snprintf(key, sizeof(key), "%s %s %s %" PRIu32, machine, plan_sample_type,
+           tsig_audio_format_name(format), channels);
+
+  if (wisdom[0]) {
+    kernel = plan_wisdom_find(wisdom, key, log);
+
+    /* Wisdom from a build with a different set of kernels may not apply. */
+    if (kernel != TSIG_AUDIO_KERNEL_UNKNOWN &&
+        tsig_audio_fill_buffer_kernel(kernel, format, channels, 0, NULL,
+                                      NULL)) {
+      tsig_log_dbg("Using sample conversion kernel %s from wisdom.",
+                   tsig_audio_kernel_name(kernel));
+      return kernel;
+    }
+  }
+
+  kernel = plan_measure(format, channels, log);
+  tsig_log_dbg("Using sample conversion kernel %s.",
+               tsig_audio_kernel_name(kernel));
+
+  if (wisdom[0])
+    plan_wisdom_add(wisdom, key, kernel, log);
+
+  return kernel;
+}
@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * plugin.c: Output sink plugin facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "plugin.h"
+
+#include "audio.h"
+#include "cfg.h"
+#include "coherent.h"
+#include "jitter.h"
+#include "log.h"
+#include "profile.h"
+#include "recorder.h"
+#include "sink.h"
+#include "station.h"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Signal status flags. */
+static volatile sig_atomic_t plugin_got_sigint = 0;
+static volatile sig_atomic_t plugin_got_sigalrm = 0;
+static volatile sig_atomic_t plugin_got_sigterm = 0;
+
+/** Default period time in us. */
+static const uint32_t plugin_period_time = 100000;
+
+/** Time conversions. */
+static const int64_t plugin_nsecs_sec = 1000000000;
+static const int64_t plugin_nsecs_msec = 1000000;
+static const uint32_t plugin_usecs_sec = 1000000;
+
+/** Signal handler. */
+static void plugin_signal_handler(int signal) {
+  if (signal == SIGINT)
+    plugin_got_sigint = 1;
+  else if (signal == SIGALRM)
+    plugin_got_sigalrm = 1;
+  else if (signal == SIGTERM)
+    plugin_got_sigterm = 1;
+}
+
+/** Check signal status flags. */
+static int plugin_got_signal(void) {
+  if (plugin_got_sigint) {
+    plugin_got_sigint = 0;
+    return SIGINT;
+  } else if (plugin_got_sigalrm) {
+    plugin_got_sigalrm = 0;
+    return SIGALRM;
+  } else if (plugin_got_sigterm) {
+    plugin_got_sigterm = 0;
+    return SIGTERM;
+  }
+  return 0;
+}
+
+/** Check if a signal that stops the loop is pending. */
+static bool plugin_is_stopping(void) {
+  return plugin_got_sigint || plugin_got_sigalrm || plugin_got_sigterm;
+}
+
+/** Get CLOCK_MONOTONIC time in ns. */
+static int64_t plugin_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * plugin_nsecs_sec + ts.tv_nsec;
+}
+
+/** Get the station time in ns of the first of the frames just generated. */
+static int64_t plugin_station_time(const tsig_station_t *station,
+                                   uint32_t size) {
+  /* Samples are counted from a timestamp in ms, and may count for days. */
+  uint64_t samples = station->samples - size;
+
+  return (int64_t)station->timestamp * plugin_nsecs_msec +
+         (int64_t)(samples / station->rate) * plugin_nsecs_sec +
+         (int64_t)(samples % station->rate) * plugin_nsecs_sec / station->rate;
+}
+
+/** Check that a sink descriptor is usable. */
+static int plugin_check_sink(tsig_plugin_t *plugin, const tsig_sink_t *sink) {
+  tsig_log_t *log = plugin->log;
+
+  if (!sink) {
+    tsig_log_err("Failed to load sink plugin %s: version %d not implemented",
+                 plugin->path, TSIG_SINK_ABI_VERSION);
+    return -EINVAL;
+  }
+
+  if (sink->abi_version != TSIG_SINK_ABI_VERSION ||
+      sink->size < sizeof(*sink)) {
+    tsig_log_err("Failed to load sink plugin %s: version %" PRIu32
+                 " size %" PRIu32 " incompatible with version %d size %zu",
+                 plugin->path, sink->abi_version, sink->size,
+                 TSIG_SINK_ABI_VERSION, sizeof(*sink));
+    return -EINVAL;
+  }
+
+  if (!sink->open || !sink->put_block || !sink->close) {
+    tsig_log_err("Failed to load sink plugin %s: missing functions",
+                 plugin->path);
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+#ifdef TSIG_DEBUG
+static void plugin_print(tsig_plugin_t *plugin) {
+  const char *audio_format = tsig_audio_format_name(plugin->audio_format);
+  tsig_log_t *log = plugin->log;
+  tsig_log_dbg("tsig_plugin_t %p = {", plugin);
+  tsig_log_dbg("  .lib          = %p,", plugin->lib);
+  tsig_log_dbg("  .path         = \"%s\",", plugin->path);
+  tsig_log_dbg("  .sink         = %p,", plugin->sink);
+  tsig_log_dbg("  .sink_data    = %p,", plugin->sink_data);
+  tsig_log_dbg("  .params       = {");
+  tsig_log_dbg("    .abi_version = %" PRIu32 ",", plugin->params.abi_version);
+  tsig_log_dbg("    .format      = %s,", plugin->params.format);
+  tsig_log_dbg("    .phys_width  = %" PRIu32 ",", plugin->params.phys_width);
+  tsig_log_dbg("    .rate        = %" PRIu32 ",", plugin->params.rate);
+  tsig_log_dbg("    .channels    = %" PRIu32 ",", plugin->params.channels);
+  tsig_log_dbg("    .period_size = %" PRIu32 ",", plugin->params.period_size);
+  tsig_log_dbg("  },");
+  tsig_log_dbg("  .audio_format = %s,", audio_format);
+  tsig_log_dbg("  .stride       = %" PRIu32 ",", plugin->stride);
+  tsig_log_dbg("  .timeout      = %u,", plugin->timeout);
+  tsig_log_dbg("  .jitter       = %p,", plugin->jitter);
+  tsig_log_dbg("  .coherent     = %p,", plugin->coherent);
+  tsig_log_dbg("  .profile      = %p,", plugin->profile);
+  tsig_log_dbg("  .station      = %p,", plugin->station);
+  tsig_log_dbg("  .log          = %p,", log);
+  tsig_log_dbg("};");
+}
+#endif /* TSIG_DEBUG */
+
+/** Open a sink with the configured stream parameters. */
+static int plugin_open(tsig_plugin_t *plugin, const tsig_sink_t *sink,
+                       tsig_cfg_t *cfg) {
+  tsig_sink_params_t *params = &plugin->params;
+  tsig_log_t *log = plugin->log;
+  int err;
+
+  *params = (tsig_sink_params_t){
+      .abi_version = TSIG_SINK_ABI_VERSION,
+      .format = tsig_audio_format_name(cfg->format),
+      .phys_width = tsig_audio_format_phys_width(cfg->format),
+      .rate = cfg->rate,
+      .channels = cfg->channels,
+      .period_size =
+          plugin_period_time * (uint64_t)cfg->rate / plugin_usecs_sec,
+  };
+
+  err = sink->open(&plugin->sink_data, params);
+  if (err < 0) {
+    tsig_log_err("Failed to open sink plugin %s: %s", plugin->path,
+                 strerror(-err));
+    return err;
+  }
+
+  /* The sink may only change the period size, and only within reason. */
+  if (!params->period_size || params->period_size > cfg->rate) {
+    tsig_log_err("Failed to open sink plugin %s: invalid period %" PRIu32,
+                 plugin->path, params->period_size);
+    sink->close(plugin->sink_data);
+    return -EINVAL;
+  }
+
+  plugin->sink = sink;
+  plugin->stride = params->phys_width * params->channels;
+
+  return 0;
+}
+
+/**
+ * Initialize output sink plugins.
+ *
+ * Nothing is loaded until tsig_plugin_init() is given a path.
+ *
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_plugin_lib_init(tsig_log_t *log) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  return 0;
+}
+
+/**
+ * Initialize output sink plugin context.
+ *
+ * @param plugin Uninitialized output sink plugin context.
+ * @param cfg Initialized program configuration.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_plugin_init(tsig_plugin_t *plugin, tsig_cfg_t *cfg, tsig_log_t *log) {
+  const tsig_sink_t *sink;
+  tsig_sink_entry_t entry;
+  int err = -EINVAL;
+
+  *plugin = (tsig_plugin_t){
+      .path = cfg->plugin,
+      .audio_format = cfg->format,
+      .timeout = cfg->timeout,
+      .log = log,
+  };
+
+  plugin->lib = dlopen(plugin->path, RTLD_NOW | RTLD_LOCAL);
+  if (!plugin->lib) {
+    tsig_log_err("Failed to load sink plugin %s: %s", plugin->path, dlerror());
+    return err;
+  }
+
+  *(void **)(&entry) = dlsym(plugin->lib, TSIG_SINK_ENTRY);
+  if (!entry) {
+    tsig_log_err("Failed to load sink plugin %s: %s", plugin->path, dlerror());
+    goto out_dlclose;
+  }
+
+  sink = entry(TSIG_SINK_ABI_VERSION);
+
+  err = plugin_check_sink(plugin, sink);
+  if (err < 0)
+    goto out_dlclose;
+
+  err = plugin_open(plugin, sink, cfg);
+  if (err < 0)
+    goto out_dlclose;
+
+#ifndef TSIG_DEBUG
+  tsig_log_dbg("Opened sink plugin \"%s\" %s %" PRIu32 " Hz %" PRIu32
+               "ch, period %" PRIu32 ".",
+               sink->name ? sink->name : plugin->path, plugin->params.format,
+               plugin->params.rate, plugin->params.channels,
+               plugin->params.period_size);
+#else
+  plugin_print(plugin);
+#endif /* TSIG_DEBUG */
+
+  return 0;
+
+out_dlclose:
+  dlclose(plugin->lib);
+  plugin->lib = NULL;
+
+  return err;
+}
+
+/**
+ * Output sink plugin loop.
+ *
+ * @param plugin Initialized output sink plugin context.
+ * @param cb Sample generator callback function.
+ * @param cb_data Callback function context object.
+ * @return Signal value if loop exited normally,
+ *  negative error code upon error.
+ */
+int tsig_plugin_loop(tsig_plugin_t *plugin, tsig_audio_cb_t cb, void *cb_data) {
+  struct sigaction sa = {.sa_handler = &plugin_signal_handler};
+  uint32_t size = plugin->params.period_size;
+  const tsig_sink_t *sink = plugin->sink;
+  tsig_log_t *log = plugin->log;
+  tsig_audio_sample_t *cb_buf;
+  tsig_sink_anchor_t anchor;
+  tsig_sink_block_t block;
+  struct sigaction sa_alrm;
+  struct sigaction sa_term;
+  struct sigaction sa_int;
+  bool is_get_block_err = false;
+  uint8_t *buf = NULL;
+  uint64_t frame = 0;
+  int sig;
+  int err;
+
+  cb_buf = malloc(sizeof(*cb_buf) * size);
+  if (!cb_buf) {
+    tsig_log_err("Failed to allocate generated sample buffer");
+    return -ENOMEM;
+  }
+
+  /* Sinks that lend memory for blocks don't need a buffer of our own. */
+  if (!sink->get_block) {
+    buf = malloc(plugin->stride * size);
+    if (!buf) {
+      tsig_log_err("Failed to allocate block buffer");
+      err = -ENOMEM;
+      goto out_free_bufs;
+    }
+  }
+
+  /* Install signal handler and set user timeout. */
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, &sa_int);
+  sigaction(SIGTERM, &sa, &sa_term);
+  sigaction(SIGALRM, &sa, &sa_alrm);
+  alarm(plugin->timeout);
+
+  for (;;) {
+    block = (tsig_sink_block_t){.buf = buf, .size = size, .frame = frame};
+
+    if (sink->get_block) {
+      err = sink->get_block(plugin->sink_data, &block);
+
+      /* Other signals, e.g. SIGUSR2, interrupt the sink but not the loop. */
+      if (err == -EINTR && !plugin_is_stopping())
+        continue;
+
+      if (err >= 0 && !block.buf)
+        err = -EINVAL;
+      if (err < 0) {
+        is_get_block_err = true;
+        break;
+      }
+    }
+
+    /* Generate one period's worth of 1ch samples. */
+    block.timestamp = plugin_now();
+    cb(cb_data, cb_buf, size);
+
+    if (plugin->station)
+      block.station_time = plugin_station_time(plugin->station, size);
+
+    /* Convert the generated samples directly into the block. */
+    if (plugin->profile)
+      tsig_profile_begin(plugin->profile, TSIG_PROFILE_FILL);
+
+    tsig_audio_fill_buffer(plugin->audio_format, plugin->params.channels, size,
+                           block.buf, cb_buf);
+
+    if (plugin->profile) {
+      tsig_profile_end(plugin->profile, TSIG_PROFILE_FILL, size);
+      tsig_profile_begin(plugin->profile, TSIG_PROFILE_WRITE);
+    }
+
+    memset(&anchor, 0, sizeof(anchor));
+
+    err = sink->put_block(plugin->sink_data, &block, &anchor);
+    tsig_recorder_event(TSIG_RECORDER_WRITE, size, err);
+
+    if (plugin->profile)
+      tsig_profile_end(plugin->profile, TSIG_PROFILE_WRITE, size);
+
+    /* Other signals, e.g. SIGUSR2, interrupt the sink but not the loop. */
+    if (err == -EINTR && !plugin_is_stopping())
+      err = 0;
+
+    if (err < 0)
+      break;
+
+    frame += size;
+
+    /* Report playback timing for edge timing measurement and coherence. */
+    if (plugin->jitter && anchor.timestamp)
+      tsig_jitter_anchor(plugin->jitter, anchor.timestamp, anchor.delay);
+
+    if (plugin->coherent && anchor.timestamp)
+      tsig_coherent_anchor(plugin->coherent, anchor.timestamp, anchor.delay);
+
+    err = plugin_got_signal();
+    if (err)
+      goto out_restore_signals;
+  }
+
+  /* The sink may have failed only because a signal interrupted it. */
+  sig = plugin_got_signal();
+  if (sig)
+    err = sig;
+  else if (is_get_block_err)
+    tsig_log_err("Failed to get block from sink plugin %s with get_block(): %s",
+                 plugin->path, strerror(-err));
+  else
+    tsig_log_err("Failed to write to sink plugin %s: %s", plugin->path,
+                 strerror(-err));
+
+out_restore_signals:
+  sigaction(SIGALRM, &sa_alrm, NULL);
+  sigaction(SIGTERM, &sa_term, NULL);
+  sigaction(SIGINT, &sa_int, NULL);
+  alarm(0);
+
+out_free_bufs:
+  free(buf);
+  free(cb_buf);
+
+  return err;
+}
+
+/**
+ * Deinitialize output sink plugin context.
+ *
+ * @param plugin Initialized output sink plugin context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_plugin_deinit(tsig_plugin_t *plugin) {
+  tsig_log_t *log = plugin->log;
+
+  plugin->sink->close(plugin->sink_data);
+
+  if (!plugin->lib || !dlclose(plugin->lib))
+    return 0;
+
+  tsig_log_err("Failed to unload sink plugin %s: %s", plugin->path, dlerror());
+
+  return -EINVAL;
+}
+
+/**
+ * Deinitialize output sink plugins.
+ *
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_plugin_lib_deinit(tsig_log_t *log) {
+  (void)log; /* Suppress unused parameter warning. */
+
+  return 0;
+}
@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * profile.c: Pipeline stage profiling facilities.
+ *
+ * Profiling on a machine where perf can't be installed is done from within.
+ * The thread generating audio opens its own perf_event counters (task clock,
+ * cycles, instructions, and cache misses) and reads them before and after
+ * each pipeline stage. The differences are accumulated per stage, and their
+ * costs per frame (or per call, for stages that process no frames) are logged
+ * every 10 minutes and on exit.
+ *
+ * Hardware counters are often unavailable in virtual machines, in which case
+ * only the task clock is counted. If perf_event_open() isn't allowed at all,
+ * the thread CPU time clock stands in for the task clock.
+ *
+ * Stages may nest, e.g. the sample loop includes any minute updates within it.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "profile.h"
+
+#include "log.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/** perf_event counter type and configuration. */
+typedef struct profile_event {
+  uint32_t type;   /** perf_event type. */
+  uint64_t config; /** perf_event type-specific configuration. */
+} profile_event_t;
+
+/** Counters, in the order they are opened and read. */
+static const profile_event_t profile_events[TSIG_PROFILE_COUNTERS] = {
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},   /* TASK_CLOCK */
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},   /* CYCLES */
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}, /* INSTRUCTIONS */
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}, /* CACHE_MISSES */
+};
+
+/** Stage names. */
+static const char *profile_stage_names[] = {
+    "update_cb",   /* TSIG_PROFILE_UPDATE */
+    "samples",     /* TSIG_PROFILE_SAMPLES */
+    "fill_buffer", /* TSIG_PROFILE_FILL */
+    "write",       /* TSIG_PROFILE_WRITE */
+};
+
+/** Interval between logged summaries in ns. */
+static const int64_t profile_report_interval = 600000000000;
+
+/** Nanoseconds per second. */
+static const int64_t profile_nsecs_sec = 1000000000;
+
+/** Close any open counters. */
+static void profile_close(tsig_profile_t *profile) {
+  for (uint32_t i = 0; i < profile->counters; i++)
+    close(profile->fds[i]);
+
+  profile->counters = 0;
+}
+
+/** Open a group of counters for the calling thread. */
+static int profile_open_group(tsig_profile_t *profile, uint32_t counters,
+                              bool exclude_kernel) {
+  struct perf_event_attr attr;
+  int err;
+  int fd;
+
+  for (uint32_t i = 0; i < counters; i++) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = profile_events[i].type;
+    attr.config = profile_events[i].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+
+    /* Every counter joins the task clock's group, so one read gets them all. */
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, i ? profile->fds[0] : -1,
+                 PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+      err = -errno;
+      profile_close(profile);
+      return err;
+    }
+
+    profile->fds[i] = fd;
+    profile->counters = i + 1;
+  }
+
+  return 0;
+}
+
+/** Open as many counters as possible, counting kernel time if allowed. */
+static int profile_open_counters(tsig_profile_t *profile, uint32_t counters) {
+  int err;
+
+  err = profile_open_group(profile, counters, false);
+  if (err == -EACCES || err == -EPERM)
+    err = profile_open_group(profile, counters, true);
+
+  return err;
+}
+
+/** Open counters for the calling thread, falling back as needed. */
+static void profile_open(tsig_profile_t *profile) {
+  tsig_log_t *log = profile->log;
+  int err;
+
+  err = profile_open_counters(profile, TSIG_PROFILE_COUNTERS);
+  if (!err) {
+    profile->mode = TSIG_PROFILE_MODE_HARDWARE;
+    tsig_log_dbg("Profiling with hardware counters.");
+    return;
+  }
+
+  tsig_log_note("Failed to open hardware counters, profiling CPU time only: %s",
+                strerror(-err));
+
+  err = profile_open_counters(profile, 1);
+  if (!err) {
+    profile->mode = TSIG_PROFILE_MODE_SOFTWARE;
+    return;
+  }
+
+  tsig_log_note("Failed to open task clock, using thread CPU time: %s",
+                strerror(-err));
+
+  profile->mode = TSIG_PROFILE_MODE_CPUTIME;
+  profile->counters = 1;
+}
+
+/** Read the current counter values. */
+static bool profile_read(const tsig_profile_t *profile, uint64_t values[]) {
+  uint64_t buf[1 + TSIG_PROFILE_COUNTERS];
+  size_t size = (1 + profile->counters) * sizeof(*buf);
+  struct timespec ts;
+
+  if (profile->mode == TSIG_PROFILE_MODE_CPUTIME) {
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+      return false;
+
+    values[TSIG_PROFILE_TASK_CLOCK] =
+        ts.tv_sec * profile_nsecs_sec + ts.tv_nsec;
+    return true;
+  }
+
+  /* A group reads as a count followed by each value in the order opened. */
+  if (read(profile->fds[0], buf, size) != (ssize_t)size)
+    return false;
+
+  memcpy(values, &buf[1], profile->counters * sizeof(*values));
+
+  return true;
+}
+
+/** Log a one-line summary of a stage. */
+static void profile_summary(const tsig_profile_t *profile,
+                            tsig_profile_stage_t stage) {
+  const tsig_profile_stat_t *stat = &profile->stats[stage];
+  const char *name = profile_stage_names[stage];
+  tsig_log_t *log = profile->log;
+  const char *per = stat->frames ? "frame" : "call";
+  double n = stat->frames ? stat->frames : stat->calls;
+  double nsecs = stat->counts[TSIG_PROFILE_TASK_CLOCK] / n;
+  double cycles = stat->counts[TSIG_PROFILE_CYCLES] / n;
+  double insns = stat->counts[TSIG_PROFILE_INSTRUCTIONS] / n;
+  double misses = stat->counts[TSIG_PROFILE_CACHE_MISSES] / n;
+
+  if (profile->mode != TSIG_PROFILE_MODE_HARDWARE) {
+    tsig_log("Profile: %-11s %" PRIu64 " calls, %" PRIu64 " frames, "
+             "%.1f ns per %s.",
+             name, stat->calls, stat->frames, nsecs, per);
+    return;
+  }
+
+  tsig_log("Profile: %-11s %" PRIu64 " calls, %" PRIu64 " frames, "
+           "%.1f ns, %.1f cycles, %.1f insns (%.2f IPC), "
+           "%.3f cache misses per %s.",
+           name, stat->calls, stat->frames, nsecs, cycles, insns,
+           cycles ? insns / cycles : 0.0, misses, per);
+}
+
+/**
+ * Initialize a pipeline stage profiling context.
+ *
+ * Counters are opened upon first use, by the thread generating audio.
+ *
+ * @param profile Uninitialized pipeline stage profiling context.
+ * @param log Initialized logging context.
+ */
+void tsig_profile_init(tsig_profile_t *profile, tsig_log_t *log) {
+  memset(profile, 0, sizeof(*profile));
+
+  profile->log = log;
+}
+
+/**
+ * Start measuring a pipeline stage.
+ *
+ * @param profile Initialized pipeline stage profiling context.
+ * @param stage Pipeline stage.
+ */
+void tsig_profile_begin(tsig_profile_t *profile, tsig_profile_stage_t stage) {
+  tsig_profile_stat_t *stat = &profile->stats[stage];
+
+  /* Counters count only the thread that opens them. */
+  if (profile->mode == TSIG_PROFILE_MODE_NONE)
+    profile_open(profile);
+
+  stat->is_started = profile_read(profile, stat->started);
+}
+
+/**
+ * Finish measuring a pipeline stage.
+ *
+ * @param profile Initialized pipeline stage profiling context.
+ * @param stage Pipeline stage.
+ * @param frames Count of frames processed, or 0 if not applicable.
+ */
+void tsig_profile_end(tsig_profile_t *profile, tsig_profile_stage_t stage,
+                      uint32_t frames) {
+  tsig_profile_stat_t *stat = &profile->stats[stage];
+  uint64_t values[TSIG_PROFILE_COUNTERS];
+  struct timespec ts;
+  int64_t now;
+
+  if (!stat->is_started || !profile_read(profile, values))
+    return;
+
+  stat->is_started = false;
+  stat->calls++;
+  stat->frames += frames;
+
+  for (uint32_t i = 0; i < profile->counters; i++)
+    stat->counts[i] += values[i] - stat->started[i];
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return;
+
+  now = ts.tv_sec * profile_nsecs_sec + ts.tv_nsec;
+
+  if (!profile->next_report) {
+    profile->next_report = now + profile_report_interval;
+  } else if (now >= profile->next_report) {
+    profile->next_report += profile_report_interval;
+    tsig_profile_print(profile);
+  }
+}
+
+/**
+ * Log a summary of each measured pipeline stage.
+ *
+ * @param profile Initialized pipeline stage profiling context.
+ */
+void tsig_profile_print(const tsig_profile_t *profile) {
+  tsig_log_t *log = profile->log;
+  bool is_measured = false;
+
+  for (uint32_t i = 0; i < TSIG_PROFILE_STAGES; i++) {
+    if (!profile->stats[i].calls)
+      continue;
+
+    profile_summary(profile, i);
+    is_measured = true;
+  }
+
+  if (!is_measured)
+    tsig_log("Profile: no stages measured.");
+}
+
+/**
+ * Deinitialize a pipeline stage profiling context.
+ *
+ * @param profile Initialized pipeline stage profiling context.
+ */
+void tsig_profile_deinit(tsig_profile_t *profile) {
+  /* The thread CPU time clock has no file descriptor. */
+  if (profile->mode == TSIG_PROFILE_MODE_CPUTIME)
+    profile->counters = 0;
+
+  profile_close(profile);
+
+  profile->mode = TSIG_PROFILE_MODE_NONE;
+}
@@ -11,9 +11,14 @@
 
 #include "audio.h"
 #include "cfg.h"
+#include "coherent.h"
 #include "defaults.h"
+#include "governor.h"
+#include "jitter.h"
 #include "log.h"
 #include "mapping.h"
+#include "profile.h"
+#include "recorder.h"
 
 #include <pulse/pulseaudio.h>
 
@@ -24,6 +29,7 @@
 #include <inttypes.h>
 #include <signal.h>
 #include <stdint.h>
+#include <time.h>
 
 /** PulseAudio library shared object name. */
 static const char *pulse_lib_soname = "libpulse.so.0";
@@ -50,7 +56,9 @@ static void (*pulse_pa_signal_done)(void);
 static int (*pulse_pa_signal_init)(pa_mainloop_api *api);
 static pa_signal_event *(*pulse_pa_signal_new)(int sig, pa_signal_cb_t callback, void *userdata);
 static int (*pulse_pa_stream_connect_playback)(pa_stream *s, const char *dev, const pa_buffer_attr *attr, pa_stream_flags_t flags, const pa_cvolume *volume, pa_stream *sync_stream);
+static int (*pulse_pa_stream_get_latency)(pa_stream *s, pa_usec_t *r_usec, int *negative);
 static pa_stream *(*pulse_pa_stream_new)(pa_context *c, const char *name, const pa_sample_spec *ss, const pa_channel_map *map);
+static void (*pulse_pa_stream_set_underflow_callback)(pa_stream *p, pa_stream_notify_cb_t cb, void *userdata);
 static void (*pulse_pa_stream_set_write_callback)(pa_stream *p, pa_stream_request_cb_t cb, void *userdata);
 static int (*pulse_pa_stream_write)(pa_stream *p, const void *data, size_t nbytes, pa_free_cb_t free_cb, int64_t offset, pa_seek_mode_t seek);
 static size_t (*pulse_pa_usec_to_bytes)(pa_usec_t t, const pa_sample_spec *spec);
@@ -64,6 +72,7 @@ static const uint64_t pulse_period_time = 100000;
 
 /** Time conversions. */
 static const uint64_t pulse_usecs_sec = 1000000;
+static const int64_t pulse_nsecs_sec = 1000000000;
 
 /** Sample format map. */
 static const tsig_mapping_nn_t pulse_format_map[] = {
@@ -81,6 +90,9 @@ static const tsig_mapping_nn_t pulse_format_map[] = {
     {TSIG_AUDIO_FORMAT_FLOAT_LE, PA_SAMPLE_FLOAT32LE},
     {TSIG_AUDIO_FORMAT_FLOAT_BE, PA_SAMPLE_FLOAT32BE},
     /* NOTE: 64-bit float formats are not supported. */
+    {TSIG_AUDIO_FORMAT_S24_3, PA_SAMPLE_S24NE},
+    {TSIG_AUDIO_FORMAT_S24_3LE, PA_SAMPLE_S24LE},
+    {TSIG_AUDIO_FORMAT_S24_3BE, PA_SAMPLE_S24BE},
     {0, 0},
 };
 
@@ -106,6 +118,34 @@ static void pulse_context_state_cb(pa_context *ctx, void *data) {
   pulse->state = pulse_pa_context_get_state(ctx);
 }
 
+/** Report playback timing for edge timing measurement and coherence. */
+static void pulse_anchor(tsig_pulse_t *pulse, pa_stream *stream) {
+  struct timespec ts;
+  pa_usec_t latency;
+  int64_t timestamp;
+  int64_t delay;
+  int negative;
+
+  /* Timing info arrives asynchronously, so there may not be any yet. */
+  if (pulse_pa_stream_get_latency(stream, &latency, &negative) < 0)
+    return;
+
+  /* The latency is interpolated to now for the next frame to be written. */
+  if (clock_gettime(CLOCK_MONOTONIC, &ts))
+    return;
+
+  timestamp = ts.tv_sec * pulse_nsecs_sec + ts.tv_nsec;
+  delay = latency * pulse->rate / pulse_usecs_sec;
+  if (negative)
+    delay = -delay;
+
+  if (pulse->jitter)
+    tsig_jitter_anchor(pulse->jitter, timestamp, delay);
+
+  if (pulse->coherent)
+    tsig_coherent_anchor(pulse->coherent, timestamp, delay);
+}
+
 /** PulseAudio stream write callback. */
 static void pulse_stream_write_cb(pa_stream *stream, size_t length,
                                   void *data) {
@@ -121,11 +161,37 @@ static void pulse_stream_write_cb(pa_stream *stream, size_t length,
   pulse->cb(pulse->cb_data, pulse->cb_buf, size);
 
   /* Fill the output buffer with the generated samples. */
+  if (pulse->profile)
+    tsig_profile_begin(pulse->profile, TSIG_PROFILE_FILL);
+
   tsig_audio_fill_buffer(pulse->audio_format, pulse->channels, size, pulse->buf,
                          pulse->cb_buf);
 
+  if (pulse->profile) {
+    tsig_profile_end(pulse->profile, TSIG_PROFILE_FILL, size);
+    tsig_profile_begin(pulse->profile, TSIG_PROFILE_WRITE);
+  }
+
   /* Write the output buffer to the PulseAudio stream. */
   pulse_pa_stream_write(stream, pulse->buf, length, NULL, 0, PA_SEEK_RELATIVE);
+
+  if (pulse->profile)
+    tsig_profile_end(pulse->profile, TSIG_PROFILE_WRITE, size);
+
+  if (pulse->jitter || pulse->coherent)
+    pulse_anchor(pulse, stream);
+}
+
+/** PulseAudio stream underflow callback. */
+static void pulse_stream_underflow_cb(pa_stream *stream, void *data) {
+  tsig_pulse_t *pulse = data;
+  (void)stream; /* Suppress unused parameter warning. */
+
+  tsig_recorder_event(TSIG_RECORDER_XRUN, -EPIPE, 0);
+  tsig_recorder_dump("xrun");
+
+  if (pulse->governor)
+    tsig_governor_xrun(pulse->governor);
 }
 
 #ifdef TSIG_DEBUG
@@ -148,6 +214,10 @@ static void pulse_print(tsig_pulse_t *pulse) {
   tsig_log_dbg("  .size         = %" PRIu32 ",", pulse->size);
   tsig_log_dbg("  .audio_format = %s,", audio_format);
   tsig_log_dbg("  .timeout      = %u,", pulse->timeout);
+  tsig_log_dbg("  .jitter       = %p,", pulse->jitter);
+  tsig_log_dbg("  .coherent     = %p,", pulse->coherent);
+  tsig_log_dbg("  .profile      = %p,", pulse->profile);
+  tsig_log_dbg("  .governor     = %p,", pulse->governor);
   tsig_log_dbg("  .log          = %p,", log);
   tsig_log_dbg("};");
 }
@@ -193,7 +263,9 @@ int tsig_pulse_lib_init(tsig_log_t *log) {
   pulse_dlsym_assign(pa_signal_init);
   pulse_dlsym_assign(pa_signal_new);
   pulse_dlsym_assign(pa_stream_connect_playback);
+  pulse_dlsym_assign(pa_stream_get_latency);
   pulse_dlsym_assign(pa_stream_new);
+  pulse_dlsym_assign(pa_stream_set_underflow_callback);
   pulse_dlsym_assign(pa_stream_set_write_callback);
   pulse_dlsym_assign(pa_stream_write);
   pulse_dlsym_assign(pa_usec_to_bytes);
@@ -295,6 +367,8 @@ int tsig_pulse_init(tsig_pulse_t *pulse, tsig_cfg_t *cfg, tsig_log_t *log) {
     goto out_deinit;
   }
   pulse_pa_stream_set_write_callback(stream, pulse_stream_write_cb, pulse);
+  pulse_pa_stream_set_underflow_callback(stream, pulse_stream_underflow_cb,
+                                         pulse);
 
   attr = (pa_buffer_attr){
       .fragsize = (uint32_t)-1,
@@ -326,7 +400,7 @@ int tsig_pulse_init(tsig_pulse_t *pulse, tsig_cfg_t *cfg, tsig_log_t *log) {
    * buffer, which should be about twice as large as we'll ever need.
    */
 
-  pulse->cb_buf = malloc(buffer_size * sizeof(double));
+  pulse->cb_buf = malloc(buffer_size * sizeof(*pulse->cb_buf));
   if (!pulse->cb_buf) {
     tsig_log_err("Failed to allocate generated sample buffer");
     err = -ENOMEM;
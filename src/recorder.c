@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * recorder.c: Flight recorder facilities.
+ *
+ * Glitches in the field are rare and seldom reproducible, and by the time one
+ * is logged, whatever led up to it is gone. The flight recorder is an always-on
+ * in-memory ring of fine-grained events (callback sizes and durations, clock
+ * readings and drift, minute frame updates, writes, and xruns), each costing a
+ * clock read and a few relaxed stores.
+ *
+ * The last few seconds of events are appended to a dump file as text upon an
+ * xrun, a resync, a fatal signal, or SIGUSR2. Dumps only use async-signal-safe
+ * functions so that they also work from a signal handler. Each dump looks like:
+ *
+ *   # Flight recorder dump (xrun) at 1234.567890123, realtime 1735689608.1
+ *   # time event a b
+ *   1226.012345678 clock  1735689592123 0
+ *   1226.012350000 cb     4800 4321000
+ *   ...
+ *
+ * Events from concurrent threads, or a dump interrupting an event from a
+ * signal handler, may rarely clobber an event. That's an acceptable price for
+ * diagnostic data that never slows down the audio path.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "recorder.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/** Buffer sizes. */
+#define TSIG_RECORDER_LINE_SIZE 128
+#define TSIG_RECORDER_DUMP_SIZE 4096
+
+/** Count of signals upon which to dump. */
+#define TSIG_RECORDER_SIGNALS 6
+
+/** Flight recorder event. */
+typedef struct recorder_event {
+  int64_t time;  /** CLOCK_MONOTONIC timestamp in ns. */
+  int64_t a;     /** First event value. */
+  int64_t b;     /** Second event value. */
+  uint32_t type; /** Event type. */
+} recorder_event_t;
+
+/** Flight recorder ring. */
+static recorder_event_t recorder_events[TSIG_RECORDER_EVENTS];
+
+/** Index of next event, not wrapped. */
+static atomic_uint recorder_head;
+
+/** Dump file path. Dumps are disabled if empty. */
+static char recorder_path[PATH_MAX];
+
+/** Dump state. */
+static volatile sig_atomic_t recorder_is_dumping = 0;
+static volatile sig_atomic_t recorder_dumps = 0;
+
+/** Signals upon which to dump. All but SIGUSR2 are fatal. */
+static const int recorder_signals[TSIG_RECORDER_SIGNALS] = {
+    SIGUSR2, SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT,
+};
+
+/** Signal dispositions before initialization. */
+static struct sigaction recorder_sa_old[TSIG_RECORDER_SIGNALS];
+
+/** Whether signal handlers were installed. */
+static bool recorder_have_signals = false;
+
+/** Nanoseconds per second. */
+static const int64_t recorder_nsecs_sec = 1000000000;
+
+/** Age of the oldest event in a dump in seconds. */
+static const int64_t recorder_dump_secs = 10;
+
+/** Event type names. */
+static const char *recorder_names[] = {
+    "none",   /* TSIG_RECORDER_NONE, unused */
+    "clock",  /* TSIG_RECORDER_CLOCK */
+    "cb",     /* TSIG_RECORDER_CB */
+    "update", /* TSIG_RECORDER_UPDATE */
+    "resync", /* TSIG_RECORDER_RESYNC */
+    "write",  /* TSIG_RECORDER_WRITE */
+    "xrun",   /* TSIG_RECORDER_XRUN */
+    "signal", /* TSIG_RECORDER_SIGNAL */
+};
+
+/** Get a timestamp in ns. */
+static inline int64_t recorder_now(clockid_t clock) {
+  struct timespec ts;
+
+  if (clock_gettime(clock, &ts))
+    return 0;
+
+  return ts.tv_sec * recorder_nsecs_sec + ts.tv_nsec;
+}
+
+/** Write a string into a buffer. */
+static size_t recorder_put_str(char buf[], const char *str) {
+  size_t len = strlen(str);
+
+  memcpy(buf, str, len);
+
+  return len;
+}
+
+/** Write an integer into a buffer, zero-padded to a width. */
+static size_t recorder_put_int(char buf[], int64_t value, int width) {
+  uint64_t u = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  char digits[24];
+  size_t len = 0;
+  int n = 0;
+
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+
+  while (n < width)
+    digits[n++] = '0';
+
+  if (value < 0)
+    buf[len++] = '-';
+
+  while (n)
+    buf[len++] = digits[--n];
+
+  return len;
+}
+
+/** Write a timestamp in ns into a buffer as seconds. */
+static size_t recorder_put_time(char buf[], int64_t time) {
+  size_t len;
+
+  len = recorder_put_int(buf, time / recorder_nsecs_sec, 0);
+  buf[len++] = '.';
+  len += recorder_put_int(&buf[len], time % recorder_nsecs_sec, 9);
+
+  return len;
+}
+
+/** Write an event into a buffer as a line of text. */
+static size_t recorder_put_event(char buf[], const recorder_event_t *event) {
+  size_t name_len;
+  size_t len;
+
+  len = recorder_put_time(buf, event->time);
+  buf[len++] = ' ';
+
+  /* Pad out event type names for readability. */
+  name_len = recorder_put_str(&buf[len], recorder_names[event->type]);
+  len += name_len;
+  do
+    buf[len++] = ' ';
+  while (++name_len < 7);
+
+  len += recorder_put_int(&buf[len], event->a, 0);
+  buf[len++] = ' ';
+
+  /* Callback durations were recorded as start times. */
+  if (event->type == TSIG_RECORDER_CB)
+    len += recorder_put_int(&buf[len], event->time - event->b, 0);
+  else
+    len += recorder_put_int(&buf[len], event->b, 0);
+
+  buf[len++] = '\n';
+
+  return len;
+}
+
+/** Write a whole buffer to a file. */
+static void recorder_write(int fd, const char buf[], size_t len) {
+  ssize_t ret;
+
+  while (len) {
+    ret = write(fd, buf, len);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return;
+
+    buf += ret;
+    len -= ret;
+  }
+}
+
+/** Signal handler. */
+static void recorder_signal_handler(int signal) {
+  int saved_errno = errno;
+
+  tsig_recorder_event(TSIG_RECORDER_SIGNAL, signal, 0);
+  tsig_recorder_dump(signal == SIGUSR2 ? "SIGUSR2" : "fatal signal");
+
+  /* The default disposition was restored, so this terminates us. */
+  if (signal != SIGUSR2)
+    raise(signal);
+
+  errno = saved_errno;
+}
+
+/**
+ * Initialize the flight recorder.
+ *
+ * Events are always recorded. Dumps are enabled by providing a dump file.
+ *
+ * @param path Dump file path, or an empty string.
+ */
+void tsig_recorder_init(const char *path) {
+  struct sigaction sa = {.sa_handler = &recorder_signal_handler};
+
+  strncpy(recorder_path, path, sizeof(recorder_path));
+  recorder_path[sizeof(recorder_path) - 1] = '\0';
+
+  if (!recorder_path[0] || recorder_have_signals)
+    return;
+
+  /* Fatal signals get their default disposition back once handled. */
+  sigemptyset(&sa.sa_mask);
+
+  for (int i = 0; i < TSIG_RECORDER_SIGNALS; i++) {
+    sa.sa_flags = recorder_signals[i] == SIGUSR2 ? SA_RESTART : SA_RESETHAND;
+    sigaction(recorder_signals[i], &sa, &recorder_sa_old[i]);
+  }
+
+  recorder_have_signals = true;
+}
+
+/**
+ * Record a flight recorder event.
+ *
+ * @param type Event type.
+ * @param a First event value.
+ * @param b Second event value.
+ * @return CLOCK_MONOTONIC timestamp of the event in ns.
+ */
+int64_t tsig_recorder_event(tsig_recorder_type_t type, int64_t a, int64_t b) {
+  unsigned i = atomic_load_explicit(&recorder_head, memory_order_relaxed);
+  recorder_event_t *event = &recorder_events[i % TSIG_RECORDER_EVENTS];
+  int64_t time = recorder_now(CLOCK_MONOTONIC);
+
+  atomic_store_explicit(&recorder_head, i + 1, memory_order_relaxed);
+
+  event->time = time;
+  event->a = a;
+  event->b = b;
+  event->type = type;
+
+  return time;
+}
+
+/**
+ * Dump recent flight recorder events to the dump file, if any.
+ *
+ * @note This function is async-signal-safe.
+ *
+ * @param reason Reason for the dump.
+ */
+void tsig_recorder_dump(const char *reason) {
+  char buf[TSIG_RECORDER_DUMP_SIZE];
+  const recorder_event_t *event;
+  size_t len = 0;
+  unsigned head;
+  int64_t now;
+  int fd;
+
+  if (!recorder_path[0] || recorder_is_dumping ||
+      recorder_dumps >= TSIG_RECORDER_DUMPS_MAX)
+    return;
+
+  recorder_is_dumping = 1;
+  recorder_dumps++;
+
+  fd = open(recorder_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+    goto out_done;
+
+  now = recorder_now(CLOCK_MONOTONIC);
+
+  len += recorder_put_str(&buf[len], "# Flight recorder dump (");
+  len += recorder_put_str(&buf[len], reason);
+  len += recorder_put_str(&buf[len], ") at ");
+  len += recorder_put_time(&buf[len], now);
+  len += recorder_put_str(&buf[len], ", realtime ");
+  len += recorder_put_time(&buf[len], recorder_now(CLOCK_REALTIME));
+  len += recorder_put_str(&buf[len], "\n# time event a b\n");
+
+  head = atomic_load_explicit(&recorder_head, memory_order_relaxed);
+
+  /* Oldest events first. Unused slots are zeroed. */
+  for (unsigned i = 0; i < TSIG_RECORDER_EVENTS; i++) {
+    event = &recorder_events[(head + i) % TSIG_RECORDER_EVENTS];
+
+    if (event->type == TSIG_RECORDER_NONE ||
+        event->type > TSIG_RECORDER_SIGNAL ||
+        now - event->time > recorder_dump_secs * recorder_nsecs_sec)
+      continue;
+
+    if (len > sizeof(buf) - TSIG_RECORDER_LINE_SIZE) {
+      recorder_write(fd, buf, len);
+      len = 0;
+    }
+
+    len += recorder_put_event(&buf[len], event);
+  }
+
+  buf[len++] = '\n';
+  recorder_write(fd, buf, len);
+
+  close(fd);
+
+out_done:
+  recorder_is_dumping = 0;
+}
+
+/** Deinitialize the flight recorder. */
+void tsig_recorder_deinit(void) {
+  if (recorder_have_signals)
+    for (int i = 0; i < TSIG_RECORDER_SIGNALS; i++)
+      sigaction(recorder_signals[i], &recorder_sa_old[i], NULL);
+
+  recorder_have_signals = false;
+  recorder_path[0] = '\0';
+}
@@ -0,0 +1,485 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * server.c: Minute-frame server facilities.
+ *
+ * Some transmitters synthesize the carrier themselves and only need to know
+ * what to transmit during each minute. Serve them the output of the station
+ * encoders as fixed-size binary records, one minute ahead of time, either
+ * over a Unix socket or over a pseudo-TTY that can be bridged to a serial port.
+ *
+ * Each record is 184 bytes, with all multibyte fields in little-endian order:
+ *
+ *   Offset  Size  Field
+ *        0     4  Magic "TSFR"
+ *        4     1  Record version (1)
+ *        5     1  Station ID (0 BPC, 1 DCF77, 2 JJY, 3 JJY60, 4 MSF, 5 WWVB)
+ *        6     1  Flags (bit 0 DST, bit 1 DST change pending, bit 2 JJY Morse)
+ *        7     1  Reserved (0)
+ *        8     8  System time at start of station minute in ms since epoch
+ *       16     8  Station time at start of station minute in ms since epoch
+ *       24     4  Station frequency in Hz
+ *       28     2  DUT1 value in ms (signed)
+ *       30     2  Low gain in [0-32768]
+ *       32   150  Transmit level bitfield (1200 50-ms ticks, LSB first)
+ *      182     2  CRC-16/CCITT-FALSE of bytes 0-181
+ *
+ * During a JJY/JJY60 callsign announcement, low gain is 0 from 40.550 to
+ * 49.000 seconds after the minute regardless of the low gain field.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#define _GNU_SOURCE /* accept4(), posix_openpt() */
+
+#include "server.h"
+
+#include "cfg.h"
+#include "log.h"
+#include "station.h"
+#include "util.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Signal status flags. */
+static volatile sig_atomic_t server_got_sigint = 0;
+static volatile sig_atomic_t server_got_sigalrm = 0;
+static volatile sig_atomic_t server_got_sigterm = 0;
+
+/** Record magic. */
+static const uint8_t server_magic[4] = {'T', 'S', 'F', 'R'};
+
+/** Record version. */
+static const uint8_t server_version = 1;
+
+/** Number of milliseconds in a minute. */
+static const int64_t server_msecs_min = 60000;
+
+/** Clock jump threshold in ms. */
+static const int64_t server_drift_threshold = 500;
+
+/** Signal handler. */
+static void server_signal_handler(int signal) {
+  if (signal == SIGINT)
+    server_got_sigint = 1;
+  else if (signal == SIGALRM)
+    server_got_sigalrm = 1;
+  else if (signal == SIGTERM)
+    server_got_sigterm = 1;
+}
+
+/** Check signal status flags. */
+static int server_got_signal(void) {
+  if (server_got_sigint) {
+    server_got_sigint = 0;
+    return SIGINT;
+  } else if (server_got_sigalrm) {
+    server_got_sigalrm = 0;
+    return SIGALRM;
+  } else if (server_got_sigterm) {
+    server_got_sigterm = 0;
+    return SIGTERM;
+  }
+  return 0;
+}
+
+/** Store an integer in little-endian order. */
+static void server_put_le(uint8_t buf[], uint64_t value, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++, value >>= 8)
+    buf[i] = value & 0xff;
+}
+
+/** Encode a station minute into a record. */
+static void server_encode(tsig_station_t *station, int64_t timestamp,
+                          uint8_t record[]) {
+  tsig_station_frame_t frame;
+
+  tsig_station_encode(station, timestamp, &frame);
+  tsig_server_pack(record, &frame);
+}
+
+/** Open a pseudo-TTY whose slave side may be bridged to a serial port. */
+static int server_open_pty(tsig_server_t *server) {
+  tsig_log_t *log = server->log;
+  struct termios termios;
+  char *name;
+  int err;
+  int fd;
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to open pseudo-TTY: %s", strerror(-err));
+    return err;
+  }
+
+  if (grantpt(fd) < 0 || unlockpt(fd) < 0 || !(name = ptsname(fd))) {
+    tsig_log_err("Failed to unlock pseudo-TTY: %s", strerror(errno));
+    goto out_close;
+  }
+
+  /* Records are binary, so keep the line discipline out of the way. */
+  if (tcgetattr(fd, &termios) < 0) {
+    tsig_log_err("Failed to get pseudo-TTY attributes: %s", strerror(errno));
+    goto out_close;
+  }
+
+  cfmakeraw(&termios);
+
+  if (tcsetattr(fd, TCSANOW, &termios) < 0) {
+    tsig_log_err("Failed to set pseudo-TTY attributes: %s", strerror(errno));
+    goto out_close;
+  }
+
+  strncpy(server->path, name, sizeof(server->path));
+  server->path[sizeof(server->path) - 1] = '\0';
+  server->pty_fd = fd;
+
+  tsig_log("Serving minute frames on pseudo-TTY %s.", server->path);
+
+  return 0;
+
+out_close:
+  close(fd);
+  return -EINVAL;
+}
+
+/** Open a listening Unix socket. */
+static int server_open_socket(tsig_server_t *server, const char *path) {
+  struct sockaddr_un addr = {.sun_family = AF_UNIX};
+  tsig_log_t *log = server->log;
+  struct stat st;
+  int err;
+  int fd;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    tsig_log_err("Failed to use socket path \"%s\": name too long", path);
+    return -ENAMETOOLONG;
+  }
+
+  strcpy(addr.sun_path, path);
+
+  /* Remove a stale socket left behind by a previous run. */
+  if (!lstat(path, &st) && S_ISSOCK(st.st_mode))
+    unlink(path);
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to create socket: %s", strerror(-err));
+    return err;
+  }
+
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    err = -errno;
+    tsig_log_err("Failed to bind socket %s: %s", path, strerror(errno));
+    goto out_close;
+  }
+
+  if (listen(fd, TSIG_SERVER_CLIENTS) < 0) {
+    err = -errno;
+    tsig_log_err("Failed to listen on socket %s: %s", path, strerror(errno));
+    unlink(path);
+    goto out_close;
+  }
+
+  strcpy(server->path, path);
+  server->listen_fd = fd;
+
+  tsig_log("Serving minute frames on socket %s.", server->path);
+
+  return 0;
+
+out_close:
+  close(fd);
+  return err;
+}
+
+/** Send a record to a client, disconnecting it upon error. */
+static void server_send(tsig_server_t *server, int *fd,
+                        const uint8_t record[]) {
+  tsig_log_t *log = server->log;
+  ssize_t sent;
+
+  sent = send(*fd, record, TSIG_SERVER_RECORD_SIZE, MSG_NOSIGNAL);
+  if (sent == TSIG_SERVER_RECORD_SIZE)
+    return;
+
+  /* A client that can't keep up with one record per minute is gone. */
+  tsig_log_dbg("Disconnected client %d: %s", *fd,
+               sent < 0 ? strerror(errno) : "short write");
+  close(*fd);
+  *fd = -1;
+}
+
+/** Write a record to the pseudo-TTY, dropping any stale unread records. */
+static void server_write_pty(tsig_server_t *server, const uint8_t record[]) {
+  tsig_log_t *log = server->log;
+  ssize_t written;
+
+  written = write(server->pty_fd, record, TSIG_SERVER_RECORD_SIZE);
+  if (written < 0 && errno == EAGAIN) {
+    tcflush(server->pty_fd, TCOFLUSH);
+    written = write(server->pty_fd, record, TSIG_SERVER_RECORD_SIZE);
+  }
+
+  if (written != TSIG_SERVER_RECORD_SIZE)
+    tsig_log_dbg("Failed to write record to pseudo-TTY: %s",
+                 written < 0 ? strerror(errno) : "short write");
+}
+
+/** Send a record to all clients. */
+static void server_broadcast(tsig_server_t *server, const uint8_t record[]) {
+  if (server->pty_fd >= 0)
+    server_write_pty(server, record);
+
+  for (uint32_t i = 0; i < TSIG_SERVER_CLIENTS; i++)
+    if (server->client_fds[i] >= 0)
+      server_send(server, &server->client_fds[i], record);
+}
+
+/** Accept a new client and bring it up to date. */
+static void server_accept(tsig_server_t *server,
+                          uint8_t records[][TSIG_SERVER_RECORD_SIZE]) {
+  tsig_log_t *log = server->log;
+  uint32_t i;
+  int fd;
+
+  fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0)
+    return;
+
+  for (i = 0; i < TSIG_SERVER_CLIENTS; i++)
+    if (server->client_fds[i] < 0)
+      break;
+
+  if (i == TSIG_SERVER_CLIENTS) {
+    tsig_log_warn("Failed to accept client, too many clients");
+    close(fd);
+    return;
+  }
+
+  tsig_log_dbg("Connected client %d.", fd);
+
+  server->client_fds[i] = fd;
+  server_send(server, &server->client_fds[i], records[0]);
+  if (server->client_fds[i] >= 0)
+    server_send(server, &server->client_fds[i], records[1]);
+}
+
+/** Drain a readable client, disconnecting it upon hangup. */
+static void server_drain(tsig_server_t *server, int *fd) {
+  tsig_log_t *log = server->log;
+  uint8_t buf[256];
+  ssize_t got;
+
+  /* Clients have nothing to tell us, so discard anything they send. */
+  do
+    got = recv(*fd, buf, sizeof(buf), 0);
+  while (got > 0);
+
+  if (got < 0 && errno == EAGAIN)
+    return;
+
+  tsig_log_dbg("Disconnected client %d.", *fd);
+  close(*fd);
+  *fd = -1;
+}
+
+/**
+ * Pack an encoded station minute into a minute-frame record.
+ *
+ * @param[out] record Output buffer TSIG_SERVER_RECORD_SIZE bytes in size.
+ * @param frame Encoded station minute.
+ */
+void tsig_server_pack(uint8_t record[], const tsig_station_frame_t *frame) {
+  memcpy(&record[0], server_magic, sizeof(server_magic));
+  record[4] = server_version;
+  record[5] = frame->station;
+  record[6] = frame->flags;
+  record[7] = 0;
+  server_put_le(&record[8], frame->utc_timestamp, 8);
+  server_put_le(&record[16], frame->timestamp, 8);
+  server_put_le(&record[24], frame->freq, 4);
+  server_put_le(&record[28], (uint16_t)frame->dut1, 2);
+  server_put_le(&record[30], frame->xmit_low, 2);
+  memcpy(&record[32], frame->xmit_level, sizeof(frame->xmit_level));
+  server_put_le(&record[182], tsig_util_crc16(record, 182), 2);
+}
+
+/**
+ * Initialize minute-frame server context.
+ *
+ * @param server Uninitialized minute-frame server context.
+ * @param cfg Initialized program configuration.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_server_init(tsig_server_t *server, tsig_cfg_t *cfg, tsig_log_t *log) {
+  *server = (tsig_server_t){
+      .listen_fd = -1,
+      .pty_fd = -1,
+      .path = {""},
+      .timeout = cfg->timeout,
+      .log = log,
+  };
+
+  for (uint32_t i = 0; i < TSIG_SERVER_CLIENTS; i++)
+    server->client_fds[i] = -1;
+
+  if (!strcmp(cfg->serve, TSIG_SERVER_PTY))
+    return server_open_pty(server);
+
+  return server_open_socket(server, cfg->serve);
+}
+
+/**
+ * Minute-frame server loop.
+ *
+ * @param server Initialized minute-frame server context.
+ * @param station Initialized station waveform generator context.
+ * @return Signal value if loop exited normally,
+ *  negative error code upon error.
+ */
+int tsig_server_loop(tsig_server_t *server, tsig_station_t *station) {
+  struct sigaction sa = {.sa_handler = &server_signal_handler};
+  struct pollfd pfds[1 + TSIG_SERVER_CLIENTS];
+  uint8_t records[2][TSIG_SERVER_RECORD_SIZE];
+  int *fds[1 + TSIG_SERVER_CLIENTS];
+  tsig_log_t *log = server->log;
+  struct sigaction sa_alrm;
+  struct sigaction sa_term;
+  struct sigaction sa_int;
+  bool is_synced = false;
+  int64_t next_min = 0;
+  int64_t timestamp;
+  int64_t min;
+  nfds_t nfds;
+  int err;
+
+  /* Install signal handler and set user timeout. */
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, &sa_int);
+  sigaction(SIGTERM, &sa, &sa_term);
+  sigaction(SIGALRM, &sa, &sa_alrm);
+  alarm(server->timeout);
+
+  for (;;) {
+    err = server_got_signal();
+    if (err)
+      break;
+
+    timestamp = tsig_station_get_timestamp(station);
+
+    /*
+     * Clients always hold the records for the current and next station
+     * minutes. Resync on first run or clock jump (e.g. NTP) and send both,
+     * otherwise send one new record at each minute boundary.
+     */
+
+    if (!is_synced || timestamp < next_min - server_msecs_min ||
+        timestamp > next_min + server_drift_threshold) {
+      min = timestamp - timestamp % server_msecs_min;
+      server_encode(station, min, records[0]);
+      server_encode(station, min + server_msecs_min, records[1]);
+
+      if (is_synced)
+        tsig_log_note("Resynced minute frames (delta %s%" PRIi64 " ms).",
+                      timestamp < next_min ? "-" : "+",
+                      timestamp < next_min ? next_min - timestamp
+                                           : timestamp - next_min);
+
+      server_broadcast(server, records[0]);
+      server_broadcast(server, records[1]);
+
+      next_min = min + server_msecs_min;
+      is_synced = true;
+    } else if (timestamp >= next_min) {
+      memcpy(records[0], records[1], sizeof(records[1]));
+      server_encode(station, next_min + server_msecs_min, records[1]);
+      server_broadcast(server, records[1]);
+
+      next_min += server_msecs_min;
+    }
+
+    /* Wait for the next minute boundary or for client activity. */
+    nfds = 0;
+
+    if (server->listen_fd >= 0) {
+      fds[nfds] = &server->listen_fd;
+      pfds[nfds++] = (struct pollfd){.fd = server->listen_fd, .events = POLLIN};
+    }
+
+    for (uint32_t i = 0; i < TSIG_SERVER_CLIENTS; i++) {
+      if (server->client_fds[i] < 0)
+        continue;
+      fds[nfds] = &server->client_fds[i];
+      pfds[nfds++] =
+          (struct pollfd){.fd = server->client_fds[i], .events = POLLIN};
+    }
+
+    err = poll(pfds, nfds, next_min - timestamp);
+    if (err < 0) {
+      if (errno == EINTR)
+        continue;
+      err = -errno;
+      tsig_log_err("Failed to wait for poll: %s", strerror(errno));
+      break;
+    }
+
+    for (nfds_t i = 0; err && i < nfds; i++) {
+      if (!pfds[i].revents)
+        continue;
+      else if (fds[i] == &server->listen_fd)
+        server_accept(server, records);
+      else
+        server_drain(server, fds[i]);
+    }
+  }
+
+  sigaction(SIGALRM, &sa_alrm, NULL);
+  sigaction(SIGTERM, &sa_term, NULL);
+  sigaction(SIGINT, &sa_int, NULL);
+  alarm(0);
+
+  return err;
+}
+
+/**
+ * Deinitialize minute-frame server context.
+ *
+ * @param server Initialized minute-frame server context.
+ */
+void tsig_server_deinit(tsig_server_t *server) {
+  for (uint32_t i = 0; i < TSIG_SERVER_CLIENTS; i++) {
+    if (server->client_fds[i] >= 0)
+      close(server->client_fds[i]);
+    server->client_fds[i] = -1;
+  }
+
+  if (server->listen_fd >= 0) {
+    close(server->listen_fd);
+    unlink(server->path);
+    server->listen_fd = -1;
+  }
+
+  if (server->pty_fd >= 0) {
+    close(server->pty_fd);
+    server->pty_fd = -1;
+  }
+}
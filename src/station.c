@@ -9,10 +9,16 @@
 
 #include "station.h"
 
+#include "archive.h"
 #include "cfg.h"
+#include "coherent.h"
 #include "datetime.h"
+#include "governor.h"
+#include "jitter.h"
 #include "log.h"
 #include "mapping.h"
+#include "profile.h"
+#include "recorder.h"
 
 #include <syslog.h>
 
@@ -29,13 +35,28 @@ static const uint64_t station_first_run = UINT64_MAX;
 /** Maximum allowed time drift in milliseconds. */
 static const uint64_t station_drift_threshold = 500;
 
+/** Maximum allowed time drift in microseconds, if coherent. */
+static const uint64_t station_coherent_threshold = 250;
+
 /** Time conversions. */
+#if defined(TSIG_HAVE_DCF77) || defined(TSIG_HAVE_MSF)
 static const uint32_t station_msecs_hour = 3600000;
+#endif /* TSIG_HAVE_DCF77, TSIG_HAVE_MSF */
 static const uint32_t station_msecs_min = 60000;
-
-/** Output gain smoothing. */
+static const int64_t station_nsecs_sec = 1000000000;
+static const int64_t station_nsecs_msec = 1000000;
+static const uint64_t station_usecs_sec = 1000000;
+
+/** Output gain smoothing, in Q15 fixed-point if samples are. */
+#ifdef TSIG_USE_FIXED_POINT
+static const int32_t station_gain_one = 1 << 15;
+static const int32_t station_lerp_rate = 492;      /* ~0.015 */
+static const int32_t station_lerp_min_delta = 164; /* ~0.005 */
+#else
+static const double station_gain_one = 1.0;
 static const double station_lerp_rate = 0.015;
 static const double station_lerp_min_delta = 0.005;
+#endif /* TSIG_USE_FIXED_POINT */
 
 /** Sync marker for transmit level flags. */
 static const uint8_t station_sync_marker = 0xff;
@@ -62,11 +83,13 @@ static const uint32_t station_jjy_morse_end_tick =
     station_jjy_morse_end_sec * TSIG_STATION_TICKS_SEC;
 
 /** Duration of Morse code symbols as ticks. */
+#if defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60)
 static const uint32_t station_ticks_per_dit = 2;
 static const uint32_t station_ticks_per_dah = 5;
 static const uint32_t station_ticks_per_ieg = 1;  /* Inter-element gap. */
 static const uint32_t station_ticks_per_icg = 6;  /* Inter-character gap. */
 static const uint32_t station_ticks_per_iwg = 10; /* Inter-word gap. */
+#endif /* TSIG_HAVE_JJY, TSIG_HAVE_JJY60 */
 
 /** TTY inverse and reset. */
 static const char *station_tty_inverse = "\x1b[7m";
@@ -81,20 +104,48 @@ typedef void (*station_status_cb_t)(tsig_station_t *station,
                                     int64_t utc_timestamp);
 
 /** Functions that update state every minute. */
+#ifdef TSIG_HAVE_BPC
 static void station_update_bpc(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_BPC */
+
+#ifdef TSIG_HAVE_DCF77
 static void station_update_dcf77(tsig_station_t *station,
                                  int64_t utc_timestamp);
+#endif /* TSIG_HAVE_DCF77 */
+
+#if defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60)
 static void station_update_jjy(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_JJY, TSIG_HAVE_JJY60 */
+
+#ifdef TSIG_HAVE_MSF
 static void station_update_msf(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_MSF */
+
+#ifdef TSIG_HAVE_WWVB
 static void station_update_wwvb(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_WWVB */
 
 /** Functions that log status every second. */
+#ifdef TSIG_HAVE_BPC
 static void station_status_bpc(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_BPC */
+
+#ifdef TSIG_HAVE_DCF77
 static void station_status_dcf77(tsig_station_t *station,
                                  int64_t utc_timestamp);
+#endif /* TSIG_HAVE_DCF77 */
+
+#if defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60)
 static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_JJY, TSIG_HAVE_JJY60 */
+
+#ifdef TSIG_HAVE_MSF
 static void station_status_msf(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_MSF */
+
+#ifdef TSIG_HAVE_WWVB
 static void station_status_wwvb(tsig_station_t *station, int64_t utc_timestamp);
+#endif /* TSIG_HAVE_WWVB */
 
 /** Characteristics of a real time station's signal. */
 typedef struct station_info {
@@ -116,8 +167,9 @@ typedef struct station_status_info {
   uint8_t bounds_morse[8];       /** `bounds` during JJY announcement. */
 } station_status_info_t;
 
-static station_info_t station_info[] = {
+static const station_info_t station_info[] = {
 
+#ifdef TSIG_HAVE_BPC
     [TSIG_STATION_ID_BPC] =
         {
             .update_cb = station_update_bpc,
@@ -126,6 +178,8 @@ static station_info_t station_info[] = {
             .freq = 68500,                           /* 68.5 KHz */
             .xmit_low = 3.162277660168379411765e-01, /* -10 dB */
         },
+#endif /* TSIG_HAVE_BPC */
+#ifdef TSIG_HAVE_DCF77
     [TSIG_STATION_ID_DCF77] =
         {
             .update_cb = station_update_dcf77,
@@ -134,6 +188,8 @@ static station_info_t station_info[] = {
             .freq = 77500,                           /* 77.5 KHz */
             .xmit_low = 1.496235656094433430496e-01, /* -16.5 dB */
         },
+#endif /* TSIG_HAVE_DCF77 */
+#ifdef TSIG_HAVE_JJY
     [TSIG_STATION_ID_JJY] =
         {
             .update_cb = station_update_jjy,
@@ -142,6 +198,8 @@ static station_info_t station_info[] = {
             .freq = 40000,                           /* 40 KHz */
             .xmit_low = 3.162277660168379411765e-01, /* -10 dB */
         },
+#endif /* TSIG_HAVE_JJY */
+#ifdef TSIG_HAVE_JJY60
     [TSIG_STATION_ID_JJY60] =
         {
             .update_cb = station_update_jjy,
@@ -150,6 +208,8 @@ static station_info_t station_info[] = {
             .freq = 60000,                           /* 60 KHz */
             .xmit_low = 3.162277660168379411765e-01, /* -10 dB */
         },
+#endif /* TSIG_HAVE_JJY60 */
+#ifdef TSIG_HAVE_MSF
     [TSIG_STATION_ID_MSF] =
         {
             .update_cb = station_update_msf,
@@ -158,6 +218,8 @@ static station_info_t station_info[] = {
             .freq = 60000,            /* 60 KHz */
             .xmit_low = 0.0,          /* On-off keying */
         },
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_WWVB
     [TSIG_STATION_ID_WWVB] =
         {
             .update_cb = station_update_wwvb,
@@ -166,11 +228,13 @@ static station_info_t station_info[] = {
             .freq = 60000,                           /* 60 KHz */
             .xmit_low = 1.412537544622754492885e-01, /* -17 dB */
         },
+#endif /* TSIG_HAVE_WWVB */
 
 };
 
-static station_status_info_t station_status_info[] = {
+static const station_status_info_t station_status_info[] = {
     /* clang-format off */
+#ifdef TSIG_HAVE_BPC
     [TSIG_STATION_ID_BPC] =
         {
             .status_cb = station_status_bpc,
@@ -178,6 +242,8 @@ static station_status_info_t station_status_info[] = {
             .sections = "secs hour   minute dow  pm dom    mon  year",
             .bounds = {4, 10, 16, 20, 22, 28, 32},
         },
+#endif /* TSIG_HAVE_BPC */
+#ifdef TSIG_HAVE_DCF77
     [TSIG_STATION_ID_DCF77] =
         {
             .status_cb = station_status_dcf77,
@@ -185,6 +251,8 @@ static station_status_info_t station_status_info[] = {
             .sections = "civil warning   flags minute    hour    dom    dow month year",
             .bounds = {15, 20, 29, 36, 42, 45, 50},
         },
+#endif /* TSIG_HAVE_DCF77 */
+#ifdef TSIG_HAVE_JJY
     [TSIG_STATION_ID_JJY] =
         {
             .status_cb = station_status_jjy,
@@ -195,6 +263,8 @@ static station_status_info_t station_status_info[] = {
             .sections_morse = "minute    hour       day of year     parity morsecode status",
             .bounds_morse = {9, 19, 34, 40, 49},
         },
+#endif /* TSIG_HAVE_JJY */
+#ifdef TSIG_HAVE_JJY60
     [TSIG_STATION_ID_JJY60] =
         {
             .status_cb = station_status_jjy,
@@ -205,6 +275,8 @@ static station_status_info_t station_status_info[] = {
             .sections_morse = "minute    hour       day of year     parity morsecode status",
             .bounds_morse = {9, 19, 34, 40, 49},
         },
+#endif /* TSIG_HAVE_JJY60 */
+#ifdef TSIG_HAVE_MSF
     [TSIG_STATION_ID_MSF] =
         {
             .status_cb = station_status_msf,
@@ -212,6 +284,8 @@ static station_status_info_t station_status_info[] = {
             .sections = "dut1              year     month dom    dow hour   minute  minmark",
             .bounds = {17, 25, 30, 36, 39, 45, 52},
         },
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_WWVB
     [TSIG_STATION_ID_WWVB] =
         {
             .status_cb = station_status_wwvb,
@@ -219,17 +293,59 @@ static station_status_info_t station_status_info[] = {
             .sections = "minute    hour       day of year     dut1       year       flags",
             .bounds = {9, 19, 34, 44, 54},
         },
+#endif /* TSIG_HAVE_WWVB */
     /* clang-format on */
 };
 
 /** Recognized time stations. */
 static const tsig_mapping_t station_ids[] = {
-    {"BPC", TSIG_STATION_ID_BPC},     {"DCF77", TSIG_STATION_ID_DCF77},
-    {"JJY", TSIG_STATION_ID_JJY},     {"JJY40", TSIG_STATION_ID_JJY},
-    {"JJY60", TSIG_STATION_ID_JJY60}, {"MSF", TSIG_STATION_ID_MSF},
-    {"WWVB", TSIG_STATION_ID_WWVB},   {NULL, 0},
+#ifdef TSIG_HAVE_BPC
+    {"BPC", TSIG_STATION_ID_BPC},
+#endif /* TSIG_HAVE_BPC */
+
+#ifdef TSIG_HAVE_DCF77
+    {"DCF77", TSIG_STATION_ID_DCF77},
+#endif /* TSIG_HAVE_DCF77 */
+
+#ifdef TSIG_HAVE_JJY
+    {"JJY", TSIG_STATION_ID_JJY},
+    {"JJY40", TSIG_STATION_ID_JJY},
+#endif /* TSIG_HAVE_JJY */
+
+#ifdef TSIG_HAVE_JJY60
+    {"JJY60", TSIG_STATION_ID_JJY60},
+#endif /* TSIG_HAVE_JJY60 */
+
+#ifdef TSIG_HAVE_MSF
+    {"MSF", TSIG_STATION_ID_MSF},
+#endif /* TSIG_HAVE_MSF */
+
+#ifdef TSIG_HAVE_WWVB
+    {"WWVB", TSIG_STATION_ID_WWVB},
+#endif /* TSIG_HAVE_WWVB */
+
+    {NULL, 0},
 };
 
+/**
+ * Time station ID of a context. This is a constant in a single-station build,
+ * so that table lookups and station-specific branches are folded away.
+ */
+#ifdef TSIG_STATION_ONLY
+#define station_id_of(station) TSIG_STATION_ONLY
+#else
+#define station_id_of(station) ((station)->station)
+#endif /* TSIG_STATION_ONLY */
+
+#ifdef TSIG_USE_FIXED_POINT
+/** Perform linear interpolation between two Q15 fixed-point values. */
+static int32_t station_lerp(int32_t target_gain, int32_t gain) {
+  int32_t diff = target_gain - gain;
+  return diff > station_lerp_min_delta || diff < -station_lerp_min_delta
+             ? gain + ((diff * station_lerp_rate) >> 15)
+             : target_gain;
+}
+#else
 /** Perform linear interpolation between two doubles. */
 static double station_lerp(double target_gain, double gain) {
   double diff = target_gain > gain ? target_gain - gain : gain - target_gain;
@@ -237,7 +353,10 @@ static double station_lerp(double target_gain, double gain) {
                                              station_lerp_rate * target_gain
                                        : target_gain;
 }
+#endif /* TSIG_USE_FIXED_POINT */
 
+#if defined(TSIG_HAVE_BPC) || defined(TSIG_HAVE_DCF77) || \
+    defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60) || defined(TSIG_HAVE_MSF)
 /** Compute even parity over a memory region. */
 static uint8_t station_even_parity(uint8_t data[], uint32_t lo, uint32_t hi) {
   uint8_t parity = 0;
@@ -246,12 +365,17 @@ static uint8_t station_even_parity(uint8_t data[], uint32_t lo, uint32_t hi) {
       parity = !parity;
   return parity;
 }
+#endif /* TSIG_HAVE_BPC, TSIG_HAVE_DCF77, TSIG_HAVE_JJY, TSIG_HAVE_JJY60,
+          TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_MSF
 /** Compute odd parity over a memory region. */
 static uint8_t station_odd_parity(uint8_t data[], uint32_t lo, uint32_t hi) {
   return !station_even_parity(data, lo, hi);
 }
+#endif /* TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_BPC
 /** Per-minute state update callback for BPC. */
 static void station_update_bpc(tsig_station_t *station, int64_t utc_timestamp) {
   uint8_t bits[20] = {[0] = station_sync_marker};
@@ -259,6 +383,8 @@ static void station_update_bpc(tsig_station_t *station, int64_t utc_timestamp) {
   tsig_datetime_t datetime = tsig_datetime_parse_timestamp(
       utc_timestamp + station_info[TSIG_STATION_ID_BPC].utc_offset);
 
+  station->flags = 0;
+
   uint8_t hour_12h = datetime.hour % 12;
   bits[3] = (hour_12h >> 2) & 0x3;
   bits[4] = hour_12h & 0x3;
@@ -323,7 +449,9 @@ static void station_update_bpc(tsig_station_t *station, int64_t utc_timestamp) {
     }
   }
 }
+#endif /* TSIG_HAVE_BPC */
 
+#ifdef TSIG_HAVE_DCF77
 /** Per-minute state update callback for DCF77. */
 static void station_update_dcf77(tsig_station_t *station,
                                  int64_t utc_timestamp) {
@@ -341,7 +469,10 @@ static void station_update_dcf77(tsig_station_t *station,
   bits[17] = is_xmit_cest;
   bits[18] = !is_xmit_cest;
 
-  station_info_t *info = &station_info[TSIG_STATION_ID_DCF77];
+  station->flags = (is_xmit_cest ? TSIG_STATION_FLAG_DST : 0) |
+                   (is_chg ? TSIG_STATION_FLAG_DST_CHANGE : 0);
+
+  const station_info_t *info = &station_info[TSIG_STATION_ID_DCF77];
   uint32_t civil_offset = is_xmit_cest ? info->utc_st_offset : info->utc_offset;
   int64_t timestamp = utc_timestamp + civil_offset + station_msecs_min;
   tsig_datetime_t datetime = tsig_datetime_parse_timestamp(timestamp);
@@ -439,7 +570,9 @@ static void station_update_dcf77(tsig_station_t *station,
       station->xmit_level[j / CHAR_BIT] |= 1 << (j % CHAR_BIT);
   }
 }
+#endif /* TSIG_HAVE_DCF77 */
 
+#if defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60)
 /** Insert high transmit level flags for JJY/JJY60 callsign announcements. */
 static void station_xmit_jjy_morse_pulse(uint8_t xmit_level[], uint32_t *k,
                                          uint32_t ticks) {
@@ -490,7 +623,7 @@ static void station_update_jjy(tsig_station_t *station, int64_t utc_timestamp) {
   };
 
   tsig_datetime_t datetime = tsig_datetime_parse_timestamp(
-      utc_timestamp + station_info[TSIG_STATION_ID_JJY].utc_offset);
+      utc_timestamp + station_info[station_id_of(station)].utc_offset);
 
   uint8_t min_10 = datetime.min / 10;
   bits[1] = min_10 & 4;
@@ -534,6 +667,8 @@ static void station_update_jjy(tsig_station_t *station, int64_t utc_timestamp) {
 
   bool is_announce = datetime.min == station_jjy_morse_min ||
                      datetime.min == station_jjy_morse_min2;
+  station->flags = is_announce ? TSIG_STATION_FLAG_MORSE : 0;
+
   if (is_announce) {
     /* clang-format off */
     sprintf(station->meaning,
@@ -571,9 +706,10 @@ static void station_update_jjy(tsig_station_t *station, int64_t utc_timestamp) {
     /* clang-format on */
   }
 
-  char *template = is_announce
-                       ? station_status_info[TSIG_STATION_ID_JJY].template_morse
-                       : station_status_info[TSIG_STATION_ID_JJY].template;
+  const station_status_info_t *status_info =
+      &station_status_info[station_id_of(station)];
+  char *template =
+      is_announce ? status_info->template_morse : status_info->template;
   for (uint32_t i = 0; i < sizeof(bits); i++)
     station->xmit[i] = template[i] == '0' && bits[i] ? '1' : template[i];
 
@@ -594,7 +730,9 @@ static void station_update_jjy(tsig_station_t *station, int64_t utc_timestamp) {
       station->xmit_level[j / CHAR_BIT] &= ~((1 << (j % CHAR_BIT)));
   }
 }
+#endif /* TSIG_HAVE_JJY, TSIG_HAVE_JJY60 */
 
+#ifdef TSIG_HAVE_MSF
 /** Per-minute state update callback for MSF. */
 static void station_update_msf(tsig_station_t *station, int64_t utc_timestamp) {
   uint8_t bits[60] = {[0] = station_sync_marker};
@@ -620,7 +758,10 @@ static void station_update_msf(tsig_station_t *station, int64_t utc_timestamp) {
   bool is_xmit_bst = is_bst ^ (in_mins == 1);
   bool is_chg = 1 <= in_mins && in_mins <= 61;
 
-  station_info_t *info = &station_info[TSIG_STATION_ID_MSF];
+  station->flags = (is_xmit_bst ? TSIG_STATION_FLAG_DST : 0) |
+                   (is_chg ? TSIG_STATION_FLAG_DST_CHANGE : 0);
+
+  const station_info_t *info = &station_info[TSIG_STATION_ID_MSF];
   uint32_t civil_offset = is_xmit_bst ? info->utc_st_offset : info->utc_offset;
   int64_t timestamp = utc_timestamp + civil_offset + station_msecs_min;
   tsig_datetime_t datetime = tsig_datetime_parse_timestamp(timestamp);
@@ -748,7 +889,9 @@ static void station_update_msf(tsig_station_t *station, int64_t utc_timestamp) {
       station->xmit_level[j / CHAR_BIT] |= 1 << (j % CHAR_BIT);
   }
 }
+#endif /* TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_WWVB
 /** Per-minute state update callback for WWVB. */
 static void station_update_wwvb(tsig_station_t *station,
                                 int64_t utc_timestamp) {
@@ -832,6 +975,9 @@ static void station_update_wwvb(tsig_station_t *station,
   bits[57] = is_dst_end;
   bits[58] = is_dst;
 
+  station->flags = (is_dst ? TSIG_STATION_FLAG_DST : 0) |
+                   (is_dst != is_dst_end ? TSIG_STATION_FLAG_DST_CHANGE : 0);
+
   char *template = station_status_info[TSIG_STATION_ID_WWVB].template;
   for (uint32_t i = 0; i < sizeof(bits); i++)
     station->xmit[i] = template[i] == '0' && bits[i] ? '1' : template[i];
@@ -861,12 +1007,16 @@ static void station_update_wwvb(tsig_station_t *station,
       station->xmit_level[j / CHAR_BIT] |= 1 << (j % CHAR_BIT);
   }
 }
+#endif /* TSIG_HAVE_WWVB */
 
+#if defined(TSIG_HAVE_DCF77) || defined(TSIG_HAVE_JJY) || \
+    defined(TSIG_HAVE_JJY60) || defined(TSIG_HAVE_MSF) ||  \
+    defined(TSIG_HAVE_WWVB)
 /** Write bit readout to a buffer with highlighting and spacing.  */
 static void station_status_write_xmit_readout(char buf[], uint8_t sec,
                                               char xmit[],
-                                              uint8_t xmit_bounds[]) {
-  uint8_t *bounds = xmit_bounds;
+                                              const uint8_t xmit_bounds[]) {
+  const uint8_t *bounds = xmit_bounds;
   char *wr = buf;
   for (uint8_t i = 0; i < 60; i++) {
     if (i == *bounds) {
@@ -881,13 +1031,16 @@ static void station_status_write_xmit_readout(char buf[], uint8_t sec,
   }
   *wr = '\0';
 }
+#endif /* TSIG_HAVE_DCF77, TSIG_HAVE_JJY, TSIG_HAVE_JJY60, TSIG_HAVE_MSF,
+          TSIG_HAVE_WWVB */
 
+#ifdef TSIG_HAVE_BPC
 /** Per-second status logging callback for BPC. */
 static void station_status_bpc(tsig_station_t *station, int64_t utc_timestamp) {
-  station_info_t *info = &station_info[TSIG_STATION_ID_BPC];
+  const station_info_t *info = &station_info[TSIG_STATION_ID_BPC];
   tsig_datetime_t datetime =
       tsig_datetime_parse_timestamp(utc_timestamp + info->utc_offset);
-  station_status_info_t *status_info =
+  const station_status_info_t *status_info =
       &station_status_info[TSIG_STATION_ID_BPC];
   char buf[TSIG_STATION_MESSAGE_SIZE];
   char cur[TSIG_STATION_MESSAGE_SIZE];
@@ -930,7 +1083,8 @@ static void station_status_bpc(tsig_station_t *station, int64_t utc_timestamp) {
     sprintf(cur, "0%s%c%s", inverse, xmit[xj], reset);
   else
     sprintf(cur, "%s%c%c%s", inverse, xmit[xi], xmit[xj], reset);
-  tsig_log_status(1, "BPC     %s, transmitting %s", buf, cur);
+  tsig_log_status(1, "BPC     %s, transmitting %s%s", buf, cur,
+                  station->is_archived ? " from archive" : "");
 
   if (!station->verbose) {
     tsig_log_status_print();
@@ -941,7 +1095,7 @@ static void station_status_bpc(tsig_station_t *station, int64_t utc_timestamp) {
   tsig_log_status(2, "meaning %s", meaning);
 
   /* e.g. "MM00 XX0000 000000 X000 00 X00000 0000 00000000" */
-  uint8_t *bounds = status_info->bounds;
+  const uint8_t *bounds = status_info->bounds;
   char *wr = buf;
   for (uint8_t i = 0, j = 1; i < 40; i += 2, j += 2) {
     if (i == *bounds) {
@@ -965,13 +1119,15 @@ static void station_status_bpc(tsig_station_t *station, int64_t utc_timestamp) {
 
   tsig_log_status_print();
 }
+#endif /* TSIG_HAVE_BPC */
 
+#ifdef TSIG_HAVE_DCF77
 /** Per-second status logging callback for DCF77. */
 static void station_status_dcf77(tsig_station_t *station,
                                  int64_t utc_timestamp) {
   tsig_datetime_t utc_datetime = tsig_datetime_parse_timestamp(utc_timestamp);
-  station_info_t *info = &station_info[TSIG_STATION_ID_DCF77];
-  station_status_info_t *status_info =
+  const station_info_t *info = &station_info[TSIG_STATION_ID_DCF77];
+  const station_status_info_t *status_info =
       &station_status_info[TSIG_STATION_ID_DCF77];
   char buf[TSIG_STATION_MESSAGE_SIZE];
   char cur[TSIG_STATION_MESSAGE_SIZE];
@@ -1007,7 +1163,8 @@ static void station_status_dcf77(tsig_station_t *station,
     sprintf(cur, sec == 20 ? "1" : "0");
   else
     sprintf(cur, "%s%c%s", inverse, xmit[sec], reset);
-  tsig_log_status(1, "DCF77   %s, transmitting %s", buf, cur);
+  tsig_log_status(1, "DCF77   %s, transmitting %s%s", buf, cur,
+                  station->is_archived ? " from archive" : "");
 
   if (!station->verbose) {
     tsig_log_status_print();
@@ -1026,12 +1183,14 @@ static void station_status_dcf77(tsig_station_t *station,
 
   tsig_log_status_print();
 }
+#endif /* TSIG_HAVE_DCF77 */
 
+#if defined(TSIG_HAVE_JJY) || defined(TSIG_HAVE_JJY60)
 /** Per-second status logging callback for JJY. */
 static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp) {
-  station_info_t *info = &station_info[TSIG_STATION_ID_JJY];
-  station_status_info_t *status_info =
-      &station_status_info[TSIG_STATION_ID_JJY];
+  const station_info_t *info = &station_info[station_id_of(station)];
+  const station_status_info_t *status_info =
+      &station_status_info[station_id_of(station)];
   char buf[TSIG_STATION_MESSAGE_SIZE];
   char cur[TSIG_STATION_MESSAGE_SIZE];
   tsig_log_t *log = station->log;
@@ -1061,7 +1220,7 @@ static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp) {
   /* e.g. "JJY60   2112-12-31 01:45:41 JST, transmitting JJY in Morse code" */
   const char *inverse = station->verbose ? station_tty_inverse : "";
   const char *reset = station->verbose ? station_tty_reset : "";
-  bool is_jjy60 = station->station == TSIG_STATION_ID_JJY60;
+  bool is_jjy60 = station_id_of(station) == TSIG_STATION_ID_JJY60;
   const char *callsign = is_jjy60 ? "JJY60" : "JJY";
   if (is_morse)
     sprintf(cur, "JJY in Morse code");
@@ -1071,7 +1230,8 @@ static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp) {
     sprintf(cur, "0");
   else
     sprintf(cur, "%s%c%s", inverse, xmit[sec], reset);
-  tsig_log_status(1, "%-8s%s, transmitting %s", callsign, buf, cur);
+  tsig_log_status(1, "%-8s%s, transmitting %s%s", callsign, buf, cur,
+                  station->is_archived ? " from archive" : "");
 
   if (!station->verbose) {
     tsig_log_status_print();
@@ -1084,7 +1244,7 @@ static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp) {
 
   /* e.g. "   bits M000X0000 MXX00X0000 MXX00X0000M0000 XX00XM X00000000 M000 00XXXXM" */
   /* e.g. "   bits M000X0000 MXX00X0000 MXX00X0000M0000 XX00XM -JJY-JJY- M000000XXXM" */
-  uint8_t *bounds =
+  const uint8_t *bounds =
       is_announce ? status_info->bounds_morse : status_info->bounds;
   station_status_write_xmit_readout(buf, sec, xmit, bounds);
   tsig_log_status(3, "   bits %s", buf);
@@ -1097,12 +1257,14 @@ static void station_status_jjy(tsig_station_t *station, int64_t utc_timestamp) {
 
   tsig_log_status_print();
 }
+#endif /* TSIG_HAVE_JJY, TSIG_HAVE_JJY60 */
 
+#ifdef TSIG_HAVE_MSF
 /** Per-second status logging callback for MSF. */
 static void station_status_msf(tsig_station_t *station, int64_t utc_timestamp) {
   tsig_datetime_t utc_datetime = tsig_datetime_parse_timestamp(utc_timestamp);
-  station_info_t *info = &station_info[TSIG_STATION_ID_MSF];
-  station_status_info_t *status_info =
+  const station_info_t *info = &station_info[TSIG_STATION_ID_MSF];
+  const station_status_info_t *status_info =
       &station_status_info[TSIG_STATION_ID_MSF];
   char buf[TSIG_STATION_MESSAGE_SIZE];
   char cur[TSIG_STATION_MESSAGE_SIZE];
@@ -1146,7 +1308,8 @@ static void station_status_msf(tsig_station_t *station, int64_t utc_timestamp) {
             xmit[sec]);
   else /* sec == 52 || sec == 59 */
     sprintf(cur, "00");
-  tsig_log_status(1, "MSF     %s, transmitting %s", buf, cur);
+  tsig_log_status(1, "MSF     %s, transmitting %s%s", buf, cur,
+                  station->is_archived ? " from archive" : "");
 
   if (!station->verbose) {
     tsig_log_status_print();
@@ -1165,12 +1328,14 @@ static void station_status_msf(tsig_station_t *station, int64_t utc_timestamp) {
 
   tsig_log_status_print();
 }
+#endif /* TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_WWVB
 /** Per-second status logging callback for WWVB. */
 static void station_status_wwvb(tsig_station_t *station,
                                 int64_t utc_timestamp) {
-  station_info_t *info = &station_info[TSIG_STATION_ID_WWVB];
-  station_status_info_t *status_info =
+  const station_info_t *info = &station_info[TSIG_STATION_ID_WWVB];
+  const station_status_info_t *status_info =
       &station_status_info[TSIG_STATION_ID_WWVB];
   char buf[TSIG_STATION_MESSAGE_SIZE];
   char cur[TSIG_STATION_MESSAGE_SIZE];
@@ -1201,7 +1366,8 @@ static void station_status_wwvb(tsig_station_t *station,
     sprintf(cur, "0");
   else
     sprintf(cur, "%s%c%s", inverse, xmit[sec], reset);
-  tsig_log_status(1, "WWVB    %s, transmitting %s", buf, cur);
+  tsig_log_status(1, "WWVB    %s, transmitting %s%s", buf, cur,
+                  station->is_archived ? " from archive" : "");
 
   if (!station->verbose) {
     tsig_log_status_print();
@@ -1220,6 +1386,7 @@ static void station_status_wwvb(tsig_station_t *station,
 
   tsig_log_status_print();
 }
+#endif /* TSIG_HAVE_WWVB */
 
 /** Print station information. */
 static void station_init_print(tsig_log_t *log, tsig_station_id_t station_id,
@@ -1312,8 +1479,10 @@ void station_print(tsig_station_t *station) {
   tsig_log_dbg("  .xmit           = %p,", station->xmit);
   tsig_log_dbg("  .meaning        = %p,", station->meaning);
   tsig_log_dbg("  .base_offset    = %" PRIi64 ",", station->base_offset);
+  tsig_log_dbg("  .base_offset_ns = %" PRIi64 ",", station->base_offset_ns);
   tsig_log_dbg("  .timestamp      = %" PRIu64 ",", station->timestamp);
   tsig_log_dbg("  .next_timestamp = %" PRIu64 ",", station->next_timestamp);
+  tsig_log_dbg("  .is_freerun     = %d,", station->is_freerun);
   tsig_log_dbg("  .samples_tick   = %" PRIu64 ",", station->samples_tick);
   tsig_log_dbg("  .samples        = %" PRIu64 ",", station->samples);
   tsig_log_dbg("  .next_tick      = %" PRIu64 ",", station->next_tick);
@@ -1332,13 +1501,249 @@ void station_print(tsig_station_t *station) {
   tsig_log_dbg("    .y1      = %f,", station->iir.y1);
   tsig_log_dbg("  },");
   tsig_log_dbg("  .freq           = %" PRIu32 ",", station->freq);
-  tsig_log_dbg("  .gain           = %f,", station->gain);
+  tsig_log_dbg("  .gain           = %f,",
+               (double)station->gain / station_gain_one);
+  tsig_log_dbg("  .xmit_low       = %f,",
+               (double)station->xmit_low / station_gain_one);
   tsig_log_dbg("  .verbose        = %d,", station->verbose);
   tsig_log_dbg("  .log            = %p,", station->log);
   tsig_log_dbg("};");
 }
 #endif /* TSIG_DEBUG */
 
+/** Apply the output quality level chosen by the governor for a minute. */
+static void station_govern(tsig_station_t *station) {
+  tsig_governor_t *governor = station->governor;
+  tsig_governor_level_t level = station->level;
+  uint32_t levels = 0;
+  tsig_iir_t iir;
+
+  if (station->smooth)
+    levels |= 1 << TSIG_GOVERNOR_NO_SMOOTH;
+
+  if (station->iir.period <= TSIG_GOVERNOR_CACHE_SIZE)
+    levels |= 1 << TSIG_GOVERNOR_CACHED;
+
+  station->level = tsig_governor_update(governor, levels);
+
+  /* Refill the table every minute, as a resync may have changed the phase. */
+  if (station->level == TSIG_GOVERNOR_CACHED) {
+    iir = station->iir;
+    tsig_iir_seek(&iir, 0);
+
+    for (uint32_t i = 0; i < iir.period; i++) {
+#ifdef TSIG_USE_FIXED_POINT
+      governor->cache[i] = tsig_iir_next_q15(&iir);
+#else
+      governor->cache[i] = tsig_iir_next(&iir);
+#endif /* TSIG_USE_FIXED_POINT */
+    }
+  }
+
+  /* Generators don't share state, so pick up where the last one left off. */
+  if (station->level != level)
+    tsig_iir_seek(&station->iir, station->iir.sample);
+}
+
+/**
+ * Encode a station minute, from an archive if possible.
+ *
+ * Only the encoded minute in the context is written, so this may be run on a
+ * copy of a context.
+ *
+ * @return Whether the minute is from an archive.
+ */
+static bool station_encode(tsig_station_t *station, int64_t utc_timestamp) {
+  if (station->archive &&
+      tsig_archive_lookup(station->archive, utc_timestamp, station->xmit_level,
+                          &station->flags))
+    return true;
+
+  station_info[station_id_of(station)].update_cb(station, utc_timestamp);
+
+  return false;
+}
+
+/**
+ * Fill in the bit readout and meaning for a minute from an archive.
+ *
+ * Archives hold only transmit levels, so the encoder is run on a copy of the
+ * context for the readout and meaning, which are then checked second by second
+ * against the archived levels. Seconds that differ are shown as '?'.
+ */
+static void station_archive_readout(tsig_station_t *station,
+                                    int64_t utc_timestamp) {
+  tsig_station_id_t station_id = station_id_of(station);
+  tsig_station_t scratch = *station;
+  bool is_bpc = station_id == TSIG_STATION_ID_BPC;
+  uint32_t xi;
+  uint32_t j;
+
+  station_info[station_id].update_cb(&scratch, utc_timestamp);
+  memcpy(station->xmit, scratch.xmit, sizeof(station->xmit));
+  memcpy(station->meaning, scratch.meaning, sizeof(station->meaning));
+
+  for (uint32_t sec = 0; sec < 60; sec++) {
+    for (j = sec * TSIG_STATION_TICKS_SEC;
+         j < (sec + 1) * TSIG_STATION_TICKS_SEC; j++)
+      if ((station->xmit_level[j / CHAR_BIT] ^
+           scratch.xmit_level[j / CHAR_BIT]) &
+          (1 << (j % CHAR_BIT)))
+        break;
+
+    if (j == (sec + 1) * TSIG_STATION_TICKS_SEC)
+      continue;
+
+    /* BPC repeats a 20-second frame with two bits per second. */
+    xi = is_bpc ? (2 * sec) % 40 : sec;
+    station->xmit[xi] = '?';
+    if (is_bpc)
+      station->xmit[xi + 1] = '?';
+  }
+
+  if (station->flags != scratch.flags)
+    sprintf(station->meaning, "unknown, archived flags %#" PRIx8 " differ",
+            station->flags);
+}
+
+/** Update state for a station minute, from an archive if possible. */
+static void station_update(tsig_station_t *station, int64_t utc_timestamp) {
+  tsig_log_t *log = station->log;
+
+  tsig_recorder_event(TSIG_RECORDER_UPDATE, utc_timestamp, 0);
+
+  if (station->governor)
+    station_govern(station);
+
+  if (station->profile)
+    tsig_profile_begin(station->profile, TSIG_PROFILE_UPDATE);
+
+  station->is_archived = station_encode(station, utc_timestamp);
+
+  if (station->profile)
+    tsig_profile_end(station->profile, TSIG_PROFILE_UPDATE, 0);
+
+  /* Warn once for each run of minutes missing from the archive. */
+  if (station->is_archived) {
+    station->is_archive_gap = false;
+    if (log->have_status)
+      station_archive_readout(station, utc_timestamp);
+  } else if (station->archive && !station->is_archive_gap) {
+    tsig_log_warn("Failed to find minute in archive, fallback to encoder");
+    station->is_archive_gap = true;
+  }
+}
+
+/** Log status for a station second. */
+static void station_status(tsig_station_t *station, int64_t utc_timestamp) {
+  station_status_info[station_id_of(station)].status_cb(station,
+                                                        utc_timestamp);
+}
+
+/** Note a transmit level change at a tick for edge timing measurement. */
+static void station_jitter_edge(tsig_station_t *station, uint32_t offset,
+                                uint64_t timestamp) {
+  /* Ticks are counted in whole samples, so round to the intended tick. */
+  uint64_t tick = (timestamp + TSIG_STATION_MSECS_TICK / 2) /
+                  TSIG_STATION_MSECS_TICK * TSIG_STATION_MSECS_TICK;
+
+  tsig_jitter_edge(station->jitter, offset,
+                   (int64_t)tick - station->base_offset);
+}
+
+/** Generate a sample at the current output quality level. */
+static tsig_audio_sample_t station_next(tsig_station_t *station) {
+  tsig_audio_sample_t sample;
+
+  switch (station->level) {
+    case TSIG_GOVERNOR_SQUARE:
+      return tsig_iir_next_square(&station->iir) * station->gain;
+    case TSIG_GOVERNOR_CACHED:
+      sample = station->governor->cache[tsig_iir_next_index(&station->iir)];
+      break;
+    default:
+#ifdef TSIG_USE_FIXED_POINT
+      sample = tsig_iir_next_q15(&station->iir);
+#else
+      sample = tsig_iir_next(&station->iir);
+#endif /* TSIG_USE_FIXED_POINT */
+      break;
+  }
+
+#ifdef TSIG_USE_FIXED_POINT
+  return (sample * station->gain) >> 15;
+#else
+  return sample * station->gain;
+#endif /* TSIG_USE_FIXED_POINT */
+}
+
+/** Get the station time in ns at which the next sample plays, if coherent. */
+static int64_t station_coherent_time(tsig_station_t *station) {
+  int64_t time = tsig_coherent_next(station->coherent);
+
+  /* As in tsig_station_get_timestamp(), but exact to the ns. */
+  if (!station->has_base_offset) {
+    station->base_offset_ns =
+        station->base != TSIG_STATION_BASE_SYSTEM
+            ? (station->base + station->offset) * station_nsecs_msec - time
+            : station->offset * station_nsecs_msec;
+    station->base_offset = station->base_offset_ns / station_nsecs_msec;
+    station->has_base_offset = true;
+  }
+
+  return time + station->base_offset_ns;
+}
+
+/** Find the index since epoch of the sample playing at a station time. */
+static uint64_t station_coherent_sample(tsig_station_t *station, int64_t time) {
+  return (uint64_t)(time / station_nsecs_sec) * station->rate +
+         (uint64_t)(time % station_nsecs_sec) * station->rate /
+             station_nsecs_sec;
+}
+
+/** Find how far the next sample is from where it should be, in samples. */
+static int64_t station_coherent_slip(tsig_station_t *station,
+                                     uint64_t sample) {
+  /* Coherent syncs are to a tick, so this is exact. */
+  uint64_t expected = station->timestamp * station->rate / 1000;
+  return (int64_t)(sample - (expected + station->samples));
+}
+
+/** Sync to the sample grid such that the next sample is the one given. */
+static void station_coherent_sync(tsig_station_t *station, uint64_t sample,
+                                  uint32_t iir_freq) {
+  uint64_t ticks = sample / station->samples_tick;
+
+  station->timestamp = ticks * TSIG_STATION_MSECS_TICK;
+  station->samples = sample % station->samples_tick;
+  station->next_tick = station->samples_tick;
+  station->tick = ticks % TSIG_STATION_TICKS_MIN;
+
+  /*
+   * The carrier phase is a function of the sample index alone. As the period
+   * of the generator divides the sample rate, each minute still begins at a
+   * rising zero crossing.
+   */
+
+  tsig_iir_init(&station->iir, iir_freq, station->rate,
+                (int)(sample % station->rate));
+}
+
+/** Check if JJY/JJY60 is announcing its callsign at the current tick. */
+static bool station_is_morse(tsig_station_t *station, uint8_t min) {
+  return (min == station_jjy_morse_min || min == station_jjy_morse_min2) &&
+         station_jjy_morse_tick <= station->tick &&
+         station->tick < station_jjy_morse_end_tick;
+}
+
+/** Find the index since epoch of the minute whose state is in effect. */
+static uint64_t station_coherent_minute(tsig_station_t *station) {
+  /* Coherent syncs are to a tick, and ticks begin every samples_tick. */
+  uint64_t ticks = station->timestamp / TSIG_STATION_MSECS_TICK +
+                   station->next_tick / station->samples_tick - 1;
+  return ticks / TSIG_STATION_TICKS_MIN;
+}
+
 /**
  * Time station waveform generator callback function.
  *
@@ -1347,79 +1752,107 @@ void station_print(tsig_station_t *station) {
  *
  * @param cb_data Initialized station waveform generator context.
  *  This is a `tsig_station_t *` intentionally passed as a `void *`.
- * @param[out] out_cb_buf Buffer to be filled with 1ch 64-bit float samples.
+ * @param[out] out_cb_buf Buffer to be filled with 1ch generated samples.
  * @param size Count of samples to be generated.
  */
-void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
+void tsig_station_cb(void *cb_data, tsig_audio_sample_t *out_cb_buf,
+                     uint32_t size) {
   tsig_station_t *station = cb_data;
 
-  station_status_info_t *status_info = &station_status_info[station->station];
-  station_info_t *info = &station_info[station->station];
-  bool is_jjy = station->station == TSIG_STATION_ID_JJY ||
-                station->station == TSIG_STATION_ID_JJY60;
-  uint64_t timestamp = tsig_datetime_get_timestamp();
+  bool is_jjy = station_id_of(station) == TSIG_STATION_ID_JJY ||
+                station_id_of(station) == TSIG_STATION_ID_JJY60;
   uint64_t expected = station->next_timestamp;
+  bool is_synced = expected && expected != station_first_run;
+  uint32_t iir_freq = station->audible ? station_audible_freq : station->freq;
   char msg[TSIG_STATION_MESSAGE_SIZE];
   tsig_log_t *log = station->log;
+  bool is_coherent = false;
   tsig_datetime_t datetime;
   uint64_t elapsed_msecs;
+  uint64_t timestamp;
+  uint64_t sample = 0;
+  bool is_slip = false;
+  uint64_t minute;
   uint64_t drift;
+  int64_t slip = 0;
+  int64_t start;
+
+  /* Once synced, a freerunning station ignores the system clock. */
+  if (station->is_freerun && is_synced) {
+    timestamp = expected;
+  } else if (station->coherent) {
+    sample = station_coherent_sample(station, station_coherent_time(station));
+    timestamp = sample * 1000 / station->rate;
+    is_coherent = true;
+  } else {
+    timestamp = tsig_station_get_timestamp(station);
+  }
 
-  /*
-   * On first run, calculate the offset to apply to the system time such
-   * that we start transmitting from the configured time base + user offset.
-   */
+  start = tsig_recorder_event(TSIG_RECORDER_CLOCK, timestamp,
+                              (int64_t)(timestamp - expected));
 
-  if (expected == station_first_run)
-    station->base_offset =
-        station->base != TSIG_STATION_BASE_SYSTEM
-            ? station->base - (int64_t)timestamp + station->offset
-            : station->offset;
-
-  /*
-   * This calculation may overflow if the time base is close to the start
-   * of the epoch and the user offset is negative and/or the system clock
-   * is set (far) backward during runtime. Resolution: worksforme, wontfix~
-   */
-
-  timestamp += station->base_offset;
+  if (station->governor)
+    tsig_governor_begin(station->governor);
 
   /* Resync on first run, sample rate change, or clock drift (e.g. NTP). */
   drift = timestamp > expected ? timestamp - expected : expected - timestamp;
-  if (drift > station_drift_threshold) {
+
+  /* Coherent output also slips a few samples to stay on the sample grid. */
+  if (is_coherent && drift <= station_drift_threshold) {
+    slip = station_coherent_slip(station, sample);
+    is_slip = (uint64_t)(slip < 0 ? -slip : slip) * station_usecs_sec >
+              station_coherent_threshold * station->rate;
+  }
+
+  if (is_slip) {
+    /* Only realign, unless the slip crosses into another minute. */
+    minute = station_coherent_minute(station);
+    station_coherent_sync(station, sample, iir_freq);
+
+    datetime = tsig_datetime_parse_timestamp(timestamp);
+    station->is_morse = is_jjy && station_is_morse(station, datetime.min);
+
+    if (station_coherent_minute(station) != minute) {
+      station_update(station, timestamp);
+      station_status(station, timestamp);
+    }
+
+    tsig_log_dbg("Slipped %" PRIi64 " samples to stay coherent.", slip);
+  } else if (drift > station_drift_threshold) {
     datetime = tsig_datetime_parse_timestamp(timestamp);
 
-    uint32_t msecs_since_tick = datetime.msec % TSIG_STATION_MSECS_TICK;
-    uint32_t msecs_to_tick = TSIG_STATION_MSECS_TICK - msecs_since_tick;
-    uint32_t msecs_since_min = 1000 * datetime.sec + datetime.msec;
-
-    station->timestamp = timestamp;
-    station->samples = 0;
-    station->next_tick = msecs_to_tick * station->rate / 1000;
-    station->tick = msecs_since_min / TSIG_STATION_MSECS_TICK;
-    station->is_morse = is_jjy &&
-                        (datetime.min == station_jjy_morse_min ||
-                         datetime.min == station_jjy_morse_min2) &&
-                        station_jjy_morse_tick <= station->tick &&
-                        station->tick < station_jjy_morse_end_tick;
-
-    /*
-     * Per DCF77's signal format specification, each minute and each transmit
-     * power change occurs at a rising zero crossing. We don't have enough
-     * control over what actually gets transmitted to reliably emulate this,
-     * and it's almost certainly not necessary for our purposes. Still,
-     * there's no particular reason not to try, so adjust the initial phase
-     * of the waveform such that the beginning of the next minute occurs at
-     * such a crossing. The phase change shouldn't matter for other stations.
-     */
-
-    uint32_t iir_freq = station->audible ? station_audible_freq : station->freq;
-    uint32_t msecs_to_min = station_msecs_min - msecs_since_min;
-    int32_t to_min = msecs_to_min * station->rate / 1000;
-    tsig_iir_init(&station->iir, iir_freq, station->rate, -to_min);
-
-    info->update_cb(station, timestamp);
-    status_info->status_cb(station, timestamp);
+    if (is_coherent) {
+      station_coherent_sync(station, sample, iir_freq);
+    } else {
+      uint32_t msecs_since_tick = datetime.msec % TSIG_STATION_MSECS_TICK;
+      uint32_t msecs_to_tick = TSIG_STATION_MSECS_TICK - msecs_since_tick;
+      uint32_t msecs_since_min = 1000 * datetime.sec + datetime.msec;
+
+      station->timestamp = timestamp;
+      station->samples = 0;
+      station->next_tick = msecs_to_tick * station->rate / 1000;
+      station->tick = msecs_since_min / TSIG_STATION_MSECS_TICK;
+
+      /*
+       * Per DCF77's signal format specification, each minute and each
+       * transmit power change occurs at a rising zero crossing. We don't have
+       * enough control over what actually gets transmitted to reliably
+       * emulate this, and it's almost certainly not necessary for our
+       * purposes. Still, there's no particular reason not to try, so adjust
+       * the initial phase of the waveform such that the beginning of the next
+       * minute occurs at such a crossing. The phase change shouldn't matter
+       * for other stations.
+       */
+
+      uint32_t msecs_to_min = station_msecs_min - msecs_since_min;
+      int32_t to_min = msecs_to_min * station->rate / 1000;
+      tsig_iir_init(&station->iir, iir_freq, station->rate, -to_min);
+    }
+
+    station->is_morse = is_jjy && station_is_morse(station, datetime.min);
+
+    station_update(station, timestamp);
+    station_status(station, timestamp);
 
     /* clang-format off */
     sprintf(msg, /* "%04hu-%02hhu-%02hhu %02hhu:%02hhu:%02hhu.%03hu" */
@@ -1429,11 +1862,15 @@ void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
             datetime.hour, datetime.min, datetime.sec, datetime.msec);
     /* clang-format on */
 
-    if (expected && expected != station_first_run)
+    if (is_synced) {
       tsig_log_note("Resynced to %s UTC (delta %s%" PRIu64 " ms).", msg,
                     timestamp < expected ? "-" : "+", drift);
-    else
+      tsig_recorder_event(TSIG_RECORDER_RESYNC, timestamp,
+                          (int64_t)(timestamp - expected));
+      tsig_recorder_dump("resync");
+    } else {
       tsig_log("Synced to %s UTC.", msg);
+    }
 
 #ifdef TSIG_DEBUG
     station_print(station);
@@ -1443,6 +1880,10 @@ void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
   /* Fill the output buffer. */
   uint8_t xmit_bit = xmit_bit = 1 << (station->tick % CHAR_BIT);
   uint8_t xmit_i = station->tick / CHAR_BIT;
+  bool is_xmit_high = station->xmit_level[xmit_i] & xmit_bit;
+
+  if (station->profile)
+    tsig_profile_begin(station->profile, TSIG_PROFILE_SAMPLES);
 
   for (uint32_t i = 0; i < size; i++) {
     /* Update state on each tick. */
@@ -1455,7 +1896,7 @@ void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
       station->tick = (station->tick + 1) % TSIG_STATION_TICKS_MIN;
 
       if (!station->tick) {
-        info->update_cb(station, timestamp);
+        station_update(station, timestamp);
 
         /* clang-format off */
         if (!datetime.min)
@@ -1473,7 +1914,7 @@ void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
       }
 
       if (!(station->tick % TSIG_STATION_TICKS_SEC))
-        status_info->status_cb(station, timestamp);
+        station_status(station, timestamp);
 
       /*
        * Using a public WebSDR, it was determined that if JJY is doing an
@@ -1493,29 +1934,48 @@ void tsig_station_cb(void *cb_data, double *out_cb_buf, uint32_t size) {
 
       xmit_bit = (xmit_bit << 1) | (xmit_bit >> 7);
       xmit_i = station->tick / CHAR_BIT;
+
+      /* Note transmit level changes for edge timing measurement. */
+      if (station->jitter &&
+          is_xmit_high != !!(station->xmit_level[xmit_i] & xmit_bit))
+        station_jitter_edge(station, i, timestamp);
     }
 
     /* Find the nominal gain for this sample. */
-    bool is_xmit_high = station->xmit_level[xmit_i] & xmit_bit;
-    double target_gain = is_xmit_high        ? 1.0
-                         : station->is_morse ? 0.0
-                                             : info->xmit_low;
+    is_xmit_high = station->xmit_level[xmit_i] & xmit_bit;
+    tsig_audio_sample_t target_gain = is_xmit_high ? station_gain_one
+                                      : station->is_morse ? 0
+                                                          : station->xmit_low;
 
     /* Interpolate a rapid gain change if needed. */
-    if (station->smooth)
+    if (station->smooth && station->level < TSIG_GOVERNOR_NO_SMOOTH)
       station->gain = station_lerp(target_gain, station->gain);
     else
       station->gain = target_gain;
 
     /* Generate a sample. */
-    out_cb_buf[i] = tsig_iir_next(&station->iir) * station->gain;
+    out_cb_buf[i] = station_next(station);
 
     station->samples++;
   }
 
+  if (station->profile)
+    tsig_profile_end(station->profile, TSIG_PROFILE_SAMPLES, size);
+
+  if (station->jitter)
+    tsig_jitter_advance(station->jitter, size);
+
+  if (station->coherent)
+    tsig_coherent_advance(station->coherent, size);
+
+  if (station->governor)
+    tsig_governor_end(station->governor, size);
+
   /* Compute the next timestamp at which this callback will be invoked. */
   elapsed_msecs = station->samples * 1000 / station->rate;
   station->next_timestamp = station->timestamp + elapsed_msecs;
+
+  tsig_recorder_event(TSIG_RECORDER_CB, size, start);
 }
 
 /**
@@ -1578,6 +2038,7 @@ void tsig_station_init(tsig_station_t *station, tsig_cfg_t *cfg,
       .next_timestamp = station_first_run,
       .samples_tick = rate * TSIG_STATION_MSECS_TICK / 1000,
       .freq = freq / subharmonic,
+      .xmit_low = station_info[station_id].xmit_low * station_gain_one,
       .verbose = verbose,
       .log = log,
   };
@@ -1586,6 +2047,70 @@ void tsig_station_init(tsig_station_t *station, tsig_cfg_t *cfg,
                      audible, freq, subharmonic);
 }
 
+/**
+ * Get the current station time.
+ *
+ * @param station Initialized station waveform generator context.
+ * @return Current station time in milliseconds since epoch.
+ */
+int64_t tsig_station_get_timestamp(tsig_station_t *station) {
+  uint64_t timestamp = tsig_datetime_get_timestamp();
+
+  /*
+   * On first use, calculate the offset to apply to the system time such
+   * that we start transmitting from the configured time base + user offset.
+   */
+
+  if (!station->has_base_offset) {
+    station->base_offset =
+        station->base != TSIG_STATION_BASE_SYSTEM
+            ? station->base - (int64_t)timestamp + station->offset
+            : station->offset;
+    station->has_base_offset = true;
+  }
+
+  /*
+   * This calculation may overflow if the time base is close to the start
+   * of the epoch and the user offset is negative and/or the system clock
+   * is set (far) backward during runtime. Resolution: worksforme, wontfix~
+   */
+
+  return timestamp + station->base_offset;
+}
+
+/**
+ * Encode one station minute for an external transmitter.
+ *
+ * The station encoders write their output into a waveform generator context,
+ * so they are run on a copy to leave the audio path undisturbed. Nothing is
+ * logged or recorded, as the minute isn't the one being played.
+ *
+ * @param station Initialized station waveform generator context.
+ * @param timestamp Station time within the station minute to encode.
+ * @param[out] frame Encoded station minute.
+ */
+void tsig_station_encode(tsig_station_t *station, int64_t timestamp,
+                         tsig_station_frame_t *frame) {
+  const station_info_t *info = &station_info[station_id_of(station)];
+  tsig_station_t scratch = *station;
+
+  timestamp -= timestamp % station_msecs_min;
+
+  station_encode(&scratch, timestamp);
+
+  *frame = (tsig_station_frame_t){
+      .station = station_id_of(station),
+      .flags = scratch.flags,
+      .dut1 = station->dut1,
+      .freq = info->freq,
+      .xmit_low = info->xmit_low * (1 << 15) + 0.5,
+      .utc_timestamp = timestamp - station->base_offset,
+      .timestamp = timestamp,
+  };
+
+  memcpy(frame->xmit_level, scratch.xmit_level, sizeof(frame->xmit_level));
+}
+
 /**
  * Set the sample rate for a time station waveform generator context.
  *
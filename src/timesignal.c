@@ -7,10 +7,19 @@
  * Copyright © 2025 James Seo <james@equiv.tech>
  */
 
+#include "archive.h"
 #include "backend.h"
+#include "binlog.h"
 #include "cfg.h"
+#include "coherent.h"
 #include "defaults.h"
+#include "governor.h"
+#include "jitter.h"
 #include "log.h"
+#include "plan.h"
+#include "profile.h"
+#include "recorder.h"
+#include "server.h"
 #include "station.h"
 
 #ifdef TSIG_HAVE_ALSA
@@ -25,6 +34,15 @@
 #include "pulse.h"
 #endif /* TSIG_HAVE_PULSE */
 
+#ifdef TSIG_HAVE_PLUGIN
+#include "plugin.h"
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+#include "file.h"
+#endif /* TSIG_HAVE_FILE */
+
+#include <errno.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -34,6 +52,9 @@
 /** Buffer size. */
 #define TSIG_TIMESIGNAL_MSG_SIZE 128
 
+/** Number of minutes in a day. */
+static const uint32_t timesignal_mins_day = 1440;
+
 /* Module globals. */
 #ifdef TSIG_HAVE_PIPEWIRE
 static tsig_pipewire_t timesignal_pipewire;
@@ -47,6 +68,20 @@ static tsig_pulse_t timesignal_pulse;
 static tsig_alsa_t timesignal_alsa;
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_PLUGIN
+static tsig_plugin_t timesignal_plugin;
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+static tsig_file_t timesignal_file;
+#endif /* TSIG_HAVE_FILE */
+
+static tsig_archive_t timesignal_archive;
+static tsig_coherent_t timesignal_coherent;
+static tsig_governor_t timesignal_governor;
+static tsig_jitter_t timesignal_jitter;
+static tsig_profile_t timesignal_profile;
+static tsig_server_t timesignal_server;
 static tsig_station_t timesignal_station;
 static tsig_cfg_t timesignal_cfg;
 static tsig_log_t timesignal_log;
@@ -92,6 +127,32 @@ static tsig_backend_info_t timesignal_backends[] = {
         },
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_PLUGIN
+    [TSIG_BACKEND_PLUGIN] =
+        {
+            .backend = TSIG_BACKEND_PLUGIN,
+            .data = &timesignal_plugin,
+            .lib_init = (tsig_backend_lib_init_t)&tsig_plugin_lib_init,
+            .init = (tsig_backend_init_t)&tsig_plugin_init,
+            .loop = (tsig_backend_loop_t)&tsig_plugin_loop,
+            .deinit = (tsig_backend_deinit_t)&tsig_plugin_deinit,
+            .lib_deinit = (tsig_backend_lib_deinit_t)&tsig_plugin_lib_deinit,
+        },
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+    [TSIG_BACKEND_FILE] =
+        {
+            .backend = TSIG_BACKEND_FILE,
+            .data = &timesignal_file,
+            .lib_init = (tsig_backend_lib_init_t)&tsig_file_lib_init,
+            .init = (tsig_backend_init_t)&tsig_file_init,
+            .loop = (tsig_backend_loop_t)&tsig_file_loop,
+            .deinit = (tsig_backend_deinit_t)&tsig_file_deinit,
+            .lib_deinit = (tsig_backend_lib_deinit_t)&tsig_file_lib_deinit,
+        },
+#endif /* TSIG_HAVE_FILE */
+
     {.backend = TSIG_BACKEND_UNKNOWN},
 };
 
@@ -108,6 +169,18 @@ static void timesignal_find_backend_order(tsig_cfg_t *cfg, tsig_log_t *log) {
   }
 #endif /* TSIG_HAVE_BACKENDS */
 
+#ifdef TSIG_HAVE_PLUGIN
+  /* Output sink plugins are used only when explicitly configured. */
+  if (cfg->backend == TSIG_BACKEND_UNKNOWN)
+    backend[TSIG_BACKEND_PLUGIN].backend = TSIG_BACKEND_UNKNOWN;
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  /* Neither are raw output files. */
+  if (cfg->backend == TSIG_BACKEND_UNKNOWN)
+    backend[TSIG_BACKEND_FILE].backend = TSIG_BACKEND_UNKNOWN;
+#endif /* TSIG_HAVE_FILE */
+
   for (; backend->backend != TSIG_BACKEND_UNKNOWN; backend++)
     len += sprintf(&order[len], "%s%s", len ? " " : "",
                    tsig_backend_name(backend->backend));
@@ -115,6 +188,228 @@ static void timesignal_find_backend_order(tsig_cfg_t *cfg, tsig_log_t *log) {
   tsig_log_dbg("Output method order: %s", order);
 }
 
+/** Measure edge timing against the playback position a backend reports. */
+static void timesignal_init_jitter(tsig_backend_info_t *backend,
+                                   tsig_station_t *station, tsig_log_t *log) {
+  tsig_jitter_t *jitter = &timesignal_jitter;
+
+  (void)backend; /* Suppress unused parameter warning. */
+
+  tsig_jitter_init(jitter, station->rate, log);
+  station->jitter = jitter;
+
+#ifdef TSIG_HAVE_PIPEWIRE
+  if (backend->backend == TSIG_BACKEND_PIPEWIRE)
+    timesignal_pipewire.jitter = jitter;
+#endif /* TSIG_HAVE_PIPEWIRE */
+
+#ifdef TSIG_HAVE_PULSE
+  if (backend->backend == TSIG_BACKEND_PULSE)
+    timesignal_pulse.jitter = jitter;
+#endif /* TSIG_HAVE_PULSE */
+
+#ifdef TSIG_HAVE_ALSA
+  if (backend->backend == TSIG_BACKEND_ALSA)
+    timesignal_alsa.jitter = jitter;
+#endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  if (backend->backend == TSIG_BACKEND_PLUGIN)
+    timesignal_plugin.jitter = jitter;
+#endif /* TSIG_HAVE_PLUGIN */
+}
+
+/** Tie output to absolute time, compensating for the latency reported. */
+static void timesignal_init_coherent(tsig_backend_info_t *backend,
+                                     tsig_station_t *station,
+                                     tsig_log_t *log) {
+  tsig_coherent_t *coherent = &timesignal_coherent;
+
+  (void)backend; /* Suppress unused parameter warning. */
+
+  tsig_coherent_init(coherent, station->rate, log);
+  station->coherent = coherent;
+
+  /* Raw output files have no latency, only a time base. */
+#ifdef TSIG_HAVE_PIPEWIRE
+  if (backend->backend == TSIG_BACKEND_PIPEWIRE)
+    timesignal_pipewire.coherent = coherent;
+#endif /* TSIG_HAVE_PIPEWIRE */
+
+#ifdef TSIG_HAVE_PULSE
+  if (backend->backend == TSIG_BACKEND_PULSE)
+    timesignal_pulse.coherent = coherent;
+#endif /* TSIG_HAVE_PULSE */
+
+#ifdef TSIG_HAVE_ALSA
+  if (backend->backend == TSIG_BACKEND_ALSA)
+    timesignal_alsa.coherent = coherent;
+#endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  if (backend->backend == TSIG_BACKEND_PLUGIN)
+    timesignal_plugin.coherent = coherent;
+#endif /* TSIG_HAVE_PLUGIN */
+}
+
+/** Choose the fastest sample conversion kernel for a backend's stream. */
+static void timesignal_plan(tsig_backend_info_t *backend, tsig_cfg_t *cfg,
+                            tsig_log_t *log) {
+  tsig_audio_format_t format = cfg->format;
+  uint32_t channels = cfg->channels;
+
+  (void)backend; /* Suppress unused parameter warning. */
+
+#ifdef TSIG_HAVE_PIPEWIRE
+  if (backend->backend == TSIG_BACKEND_PIPEWIRE) {
+    format = timesignal_pipewire.audio_format;
+    channels = timesignal_pipewire.channels;
+  }
+#endif /* TSIG_HAVE_PIPEWIRE */
+
+#ifdef TSIG_HAVE_PULSE
+  if (backend->backend == TSIG_BACKEND_PULSE) {
+    format = timesignal_pulse.audio_format;
+    channels = timesignal_pulse.channels;
+  }
+#endif /* TSIG_HAVE_PULSE */
+
+#ifdef TSIG_HAVE_ALSA
+  if (backend->backend == TSIG_BACKEND_ALSA) {
+    format = timesignal_alsa.audio_format;
+    channels = timesignal_alsa.channels;
+  }
+#endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  if (backend->backend == TSIG_BACKEND_PLUGIN) {
+    format = timesignal_plugin.audio_format;
+    channels = timesignal_plugin.params.channels;
+  }
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  if (backend->backend == TSIG_BACKEND_FILE) {
+    format = timesignal_file.audio_format;
+    channels = timesignal_file.channels;
+  }
+#endif /* TSIG_HAVE_FILE */
+
+  tsig_audio_set_kernel(tsig_plan(format, channels, cfg->wisdom, log));
+}
+
+/** Profile pipeline stages in the thread a backend generates audio in. */
+static void timesignal_init_profile(tsig_backend_info_t *backend,
+                                    tsig_station_t *station, tsig_log_t *log) {
+  tsig_profile_t *profile = &timesignal_profile;
+
+  (void)backend; /* Suppress unused parameter warning. */
+
+  tsig_profile_init(profile, log);
+  station->profile = profile;
+
+#ifdef TSIG_HAVE_PIPEWIRE
+  if (backend->backend == TSIG_BACKEND_PIPEWIRE)
+    timesignal_pipewire.profile = profile;
+#endif /* TSIG_HAVE_PIPEWIRE */
+
+#ifdef TSIG_HAVE_PULSE
+  if (backend->backend == TSIG_BACKEND_PULSE)
+    timesignal_pulse.profile = profile;
+#endif /* TSIG_HAVE_PULSE */
+
+#ifdef TSIG_HAVE_ALSA
+  if (backend->backend == TSIG_BACKEND_ALSA)
+    timesignal_alsa.profile = profile;
+#endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  if (backend->backend == TSIG_BACKEND_PLUGIN)
+    timesignal_plugin.profile = profile;
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  if (backend->backend == TSIG_BACKEND_FILE)
+    timesignal_file.profile = profile;
+#endif /* TSIG_HAVE_FILE */
+}
+
+/** Adapt output quality to CPU starvation and xruns a backend reports. */
+static void timesignal_init_governor(tsig_backend_info_t *backend,
+                                     tsig_station_t *station, tsig_log_t *log) {
+  tsig_governor_t *governor = &timesignal_governor;
+
+  (void)backend; /* Suppress unused parameter warning. */
+
+  tsig_governor_init(governor, station->rate, log);
+  station->governor = governor;
+
+  /* PipeWire streams and plugins don't report xruns. */
+
+#ifdef TSIG_HAVE_PULSE
+  if (backend->backend == TSIG_BACKEND_PULSE)
+    timesignal_pulse.governor = governor;
+#endif /* TSIG_HAVE_PULSE */
+
+#ifdef TSIG_HAVE_ALSA
+  if (backend->backend == TSIG_BACKEND_ALSA)
+    timesignal_alsa.governor = governor;
+#endif /* TSIG_HAVE_ALSA */
+}
+
+/** Log why a loop exited. */
+static void timesignal_log_exit(tsig_log_t *log, int err) {
+  if (err == SIGINT)
+    tsig_log_note("Exiting on interrupt.");
+  else if (err == SIGALRM)
+    tsig_log("Exiting as scheduled.");
+  else if (err == SIGTERM)
+    tsig_log_warn("Exiting on SIGTERM!");
+  else if (err < 0)
+    tsig_log_err("Failed to cleanly exit output loop!");
+}
+
+/** Serve minute frames instead of playing audio. */
+static int timesignal_serve(tsig_station_t *station, tsig_cfg_t *cfg,
+                            tsig_log_t *log) {
+  tsig_server_t *server = &timesignal_server;
+  int err;
+
+  err = tsig_server_init(server, cfg, log);
+  if (err < 0)
+    return err;
+
+  err = tsig_server_loop(server, station);
+  timesignal_log_exit(log, err);
+
+  tsig_server_deinit(server);
+
+  return err;
+}
+
+/** Write a minute-frame archive instead of playing audio. */
+static int timesignal_write_archive(tsig_station_t *station, tsig_cfg_t *cfg,
+                                    tsig_log_t *log) {
+  if (!cfg->archive[0]) {
+    tsig_log_err("Failed to write archive, no archive file given");
+    return -EINVAL;
+  }
+
+  return tsig_archive_write(station, cfg->archive,
+                            tsig_station_get_timestamp(station),
+                            cfg->archive_days * timesignal_mins_day, log);
+}
+
+/** Print a binary log instead of playing audio. */
+static int timesignal_print_binlog(tsig_cfg_t *cfg, tsig_log_t *log) {
+  if (!cfg->binlog[0]) {
+    tsig_log_err("Failed to print binary log, no binary log file given");
+    return -EINVAL;
+  }
+
+  return tsig_binlog_print(cfg->binlog, stdout, log);
+}
+
 int main(int argc, char *argv[]) {
   tsig_backend_info_t *backend = timesignal_backends;
   tsig_station_t *station = &timesignal_station;
@@ -131,6 +426,14 @@ int main(int argc, char *argv[]) {
   else if (err == TSIG_CFG_INIT_HELP)
     exit(EXIT_SUCCESS);
 
+  if (cfg->print_binlog) {
+    err = timesignal_print_binlog(cfg, log);
+    tsig_log_deinit(log);
+    exit(err < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  tsig_recorder_init(cfg->recorder);
+
   tsig_log_tty("%s %s <%s>", TSIG_DEFAULTS_NAME, TSIG_DEFAULTS_VERSION,
                TSIG_DEFAULTS_URL);
   tsig_log_tty("%s", TSIG_DEFAULTS_DESCRIPTION);
@@ -138,6 +441,26 @@ int main(int argc, char *argv[]) {
 
   tsig_station_init(station, cfg, log);
 
+  if (cfg->archive_days) {
+    err = timesignal_write_archive(station, cfg, log);
+    tsig_log_deinit(log);
+    exit(err < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
+  if (cfg->archive[0]) {
+    err = tsig_archive_open(&timesignal_archive, cfg->archive, station, log);
+    if (err < 0)
+      exit(EXIT_FAILURE);
+    station->archive = &timesignal_archive;
+  }
+
+  if (cfg->serve[0]) {
+    err = timesignal_serve(station, cfg, log);
+    tsig_archive_close(&timesignal_archive);
+    tsig_log_deinit(log);
+    exit(err < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
   timesignal_find_backend_order(cfg, log);
 
   for (; !is_done && backend->backend != TSIG_BACKEND_UNKNOWN; backend++) {
@@ -161,19 +484,50 @@ int main(int argc, char *argv[]) {
       tsig_station_set_rate(station, timesignal_alsa.rate);
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_FILE
+    /* Raw output files are rendered faster than the system clock runs. */
+    if (backend->backend == TSIG_BACKEND_FILE)
+      station->is_freerun = true;
+#endif /* TSIG_HAVE_FILE */
+
+#ifdef TSIG_HAVE_PLUGIN
+    /* Sink plugins are told the station time of each block. */
+    if (backend->backend == TSIG_BACKEND_PLUGIN)
+      timesignal_plugin.station = station;
+#endif /* TSIG_HAVE_PLUGIN */
+
+    /* The backend may not have given us the format or channels requested. */
+    timesignal_plan(backend, cfg, log);
+
+    if (cfg->jitter)
+      timesignal_init_jitter(backend, station, log);
+
+    if (cfg->coherent)
+      timesignal_init_coherent(backend, station, log);
+
+    if (cfg->profile)
+      timesignal_init_profile(backend, station, log);
+
+    if (cfg->governor)
+      timesignal_init_governor(backend, station, log);
+
     /* NOTE: TTY echo will not turn back on if we terminate abnormally. */
     if (log->have_status && !atexit(tsig_log_tty_enable_echo))
       tsig_log_tty_disable_echo();
 
     err = backend->loop(backend->data, tsig_station_cb, (void *)station);
-    if (err == SIGINT)
-      tsig_log_note("Exiting on interrupt.");
-    else if (err == SIGALRM)
-      tsig_log("Exiting as scheduled.");
-    else if (err == SIGTERM)
-      tsig_log_warn("Exiting on SIGTERM!");
-    else if (err < 0)
-      tsig_log_err("Failed to cleanly exit output loop!");
+    timesignal_log_exit(log, err);
+
+    if (station->jitter)
+      tsig_jitter_print(station->jitter);
+
+    if (station->profile) {
+      tsig_profile_print(station->profile);
+      tsig_profile_deinit(station->profile);
+    }
+
+    if (station->governor)
+      tsig_governor_print(station->governor);
 
     is_done = true;
 
@@ -188,6 +542,8 @@ int main(int argc, char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
+  tsig_recorder_deinit();
+  tsig_archive_close(&timesignal_archive);
   tsig_log_deinit(log);
 
   exit(EXIT_SUCCESS);
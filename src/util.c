@@ -74,3 +74,36 @@ int tsig_util_strcasecmp(const char *s1, const char *s2) {
 
   return *s1 - *s2;
 }
+
+/**
+ * Update a CRC-16/CCITT-FALSE checksum.
+ *
+ * Polynomial 0x1021, no reflection, no final XOR.
+ * Cheap enough to verify bit-by-bit on a microcontroller.
+ *
+ * @param crc Checksum so far, initially 0xffff.
+ * @param data Input buffer.
+ * @param size Size of input buffer in bytes.
+ * @return Updated checksum.
+ */
+uint16_t tsig_util_crc16_update(uint16_t crc, const uint8_t data[],
+                                size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i] << 8;
+    for (int j = 0; j < 8; j++)
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+
+  return crc;
+}
+
+/**
+ * Compute a CRC-16/CCITT-FALSE checksum.
+ *
+ * @param data Input buffer.
+ * @param size Size of input buffer in bytes.
+ * @return Checksum.
+ */
+uint16_t tsig_util_crc16(const uint8_t data[], size_t size) {
+  return tsig_util_crc16_update(0xffff, data, size);
+}
@@ -0,0 +1,594 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * writer.c: Asynchronous file writing facilities.
+ *
+ * Rendering to a file at high rates and channel counts for hours produces
+ * tens of GB, and writing it synchronously from the thread generating it
+ * would leave the CPU idle during I/O and vice versa. Instead, frames are
+ * generated into a small ring of large aligned buffers, and each buffer is
+ * handed off for writing once full while generation continues into the next.
+ *
+ * Buffers are written through io_uring, registered with the kernel if allowed.
+ * If io_uring is unavailable, e.g. in an older kernel or a container that
+ * forbids it, a writer thread does the same job with pwrite().
+ *
+ * Generation only waits when every buffer is still in flight, i.e. when the
+ * storage is slower than the CPU, and throughput is limited by the slower of
+ * the two. With O_DIRECT, the page cache is bypassed for all but the unaligned
+ * tail written upon deinitialization.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#define _GNU_SOURCE /* O_DIRECT */
+
+#include "writer.h"
+
+#include "log.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** File mode for a newly created file. */
+static const mode_t writer_file_mode = 0644;
+
+/** Write a whole buffer at a file offset, retrying short writes. */
+static int writer_pwrite(int fd, const uint8_t *data, size_t size,
+                         uint64_t offset) {
+  ssize_t res;
+
+  while (size) {
+    res = pwrite(fd, data, size, offset);
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res <= 0)
+      return res < 0 ? -errno : -EIO;
+
+    data += res;
+    size -= res;
+    offset += res;
+  }
+
+  return 0;
+}
+
+/** Record the first write error. */
+static void writer_fail(tsig_writer_t *writer, int err) {
+  if (!writer->err)
+    writer->err = err;
+}
+
+#ifdef SYS_io_uring_setup
+/** Submit a buffer, or what remains of it, through io_uring. */
+static void writer_uring_submit(tsig_writer_t *writer, uint32_t i) {
+  tsig_writer_uring_t *uring = &writer->uring;
+  tsig_writer_buf_t *buf = &writer->bufs[i];
+  uint32_t tail = *uring->sq_tail;
+  uint32_t index = tail & *uring->sq_mask;
+  struct io_uring_sqe *sqe = &((struct io_uring_sqe *)uring->sqes)[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = uring->is_registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+  sqe->fd = writer->fd;
+  sqe->addr = (uintptr_t)&buf->data[buf->done];
+  sqe->len = buf->size - buf->done;
+  sqe->off = buf->offset + buf->done;
+  sqe->buf_index = i;
+  sqe->user_data = i;
+
+  uring->sq_array[index] = index;
+  __atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  /* The queue has an entry per buffer, so it can't be full. */
+  while (syscall(SYS_io_uring_enter, uring->fd, 1, 0, 0, NULL, 0) < 0) {
+    if (errno != EINTR) {
+      writer_fail(writer, -errno);
+      buf->is_busy = false;
+      return;
+    }
+  }
+}
+
+/** Reap io_uring completions, waiting for at least one. */
+static int writer_uring_reap(tsig_writer_t *writer) {
+  tsig_writer_uring_t *uring = &writer->uring;
+  struct io_uring_cqe *cqe;
+  tsig_writer_buf_t *buf;
+  uint32_t head;
+  uint32_t tail;
+
+  if (syscall(SYS_io_uring_enter, uring->fd, 0, 1, IORING_ENTER_GETEVENTS,
+              NULL, 0) < 0 &&
+      errno != EINTR)
+    return -errno;
+
+  head = *uring->cq_head;
+  tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+  for (; head != tail; head++) {
+    cqe = &((struct io_uring_cqe *)uring->cqes)[head & *uring->cq_mask];
+    buf = &writer->bufs[cqe->user_data];
+
+    if (cqe->res <= 0) {
+      writer_fail(writer, cqe->res < 0 ? cqe->res : -EIO);
+      buf->is_busy = false;
+      continue;
+    }
+
+    /* Regular files are rarely written short, but it can happen. */
+    buf->done += cqe->res;
+    if (buf->done < buf->size)
+      writer_uring_submit(writer, cqe->user_data);
+    else
+      buf->is_busy = false;
+  }
+
+  __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+  return 0;
+}
+
+/** Set up an io_uring instance. */
+static int writer_uring_init(tsig_writer_t *writer) {
+  tsig_writer_uring_t *uring = &writer->uring;
+  struct iovec iovs[TSIG_WRITER_BUFS];
+  struct io_uring_params params;
+  uint8_t *sq_ring;
+  uint8_t *cq_ring;
+
+  memset(&params, 0, sizeof(params));
+
+  uring->fd = syscall(SYS_io_uring_setup, TSIG_WRITER_BUFS, &params);
+  if (uring->fd < 0)
+    return -errno;
+
+  /* IORING_OP_WRITE arrived together with this feature in Linux 5.6. */
+  if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    return -ENOSYS;
+
+  uring->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  uring->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (uring->cq_ring_size > uring->sq_ring_size)
+      uring->sq_ring_size = uring->cq_ring_size;
+    uring->cq_ring_size = 0;
+  }
+
+  uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, uring->fd,
+                        IORING_OFF_SQ_RING);
+  if (uring->sq_ring == MAP_FAILED) {
+    uring->sq_ring = NULL;
+    return -errno;
+  }
+
+  if (uring->cq_ring_size) {
+    uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, uring->fd,
+                          IORING_OFF_CQ_RING);
+    if (uring->cq_ring == MAP_FAILED) {
+      uring->cq_ring = NULL;
+      return -errno;
+    }
+  } else {
+    uring->cq_ring = uring->sq_ring;
+  }
+
+  uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+  if (uring->sqes == MAP_FAILED) {
+    uring->sqes = NULL;
+    return -errno;
+  }
+
+  sq_ring = uring->sq_ring;
+  cq_ring = uring->cq_ring;
+  uring->sq_tail = (uint32_t *)&sq_ring[params.sq_off.tail];
+  uring->sq_mask = (uint32_t *)&sq_ring[params.sq_off.ring_mask];
+  uring->sq_array = (uint32_t *)&sq_ring[params.sq_off.array];
+  uring->cq_head = (uint32_t *)&cq_ring[params.cq_off.head];
+  uring->cq_tail = (uint32_t *)&cq_ring[params.cq_off.tail];
+  uring->cq_mask = (uint32_t *)&cq_ring[params.cq_off.ring_mask];
+  uring->cqes = &cq_ring[params.cq_off.cqes];
+
+  /* Registered buffers are pinned, which RLIMIT_MEMLOCK may not allow. */
+  for (uint32_t i = 0; i < TSIG_WRITER_BUFS; i++)
+    iovs[i] = (struct iovec){writer->bufs[i].data, TSIG_WRITER_BUF_SIZE};
+
+  uring->is_registered =
+      !syscall(SYS_io_uring_register, uring->fd, IORING_REGISTER_BUFFERS, iovs,
+               TSIG_WRITER_BUFS);
+
+  return 0;
+}
+#else
+/** Submit a buffer through io_uring, which this system doesn't have. */
+static void writer_uring_submit(tsig_writer_t *writer, uint32_t i) {
+  (void)i; /* Suppress unused parameter warning. */
+
+  writer_fail(writer, -ENOSYS);
+}
+
+/** Reap io_uring completions, which this system doesn't have. */
+static int writer_uring_reap(tsig_writer_t *writer) {
+  (void)writer; /* Suppress unused parameter warning. */
+
+  return -ENOSYS;
+}
+
+/** Set up an io_uring instance, which this system doesn't have. */
+static int writer_uring_init(tsig_writer_t *writer) {
+  (void)writer; /* Suppress unused parameter warning. */
+
+  return -ENOSYS;
+}
+#endif /* SYS_io_uring_setup */
+
+/** Tear down an io_uring instance, even if partially set up. */
+static void writer_uring_deinit(tsig_writer_t *writer) {
+  tsig_writer_uring_t *uring = &writer->uring;
+
+  if (uring->sqes)
+    munmap(uring->sqes, uring->sqes_size);
+  if (uring->cq_ring && uring->cq_ring != uring->sq_ring)
+    munmap(uring->cq_ring, uring->cq_ring_size);
+  if (uring->sq_ring)
+    munmap(uring->sq_ring, uring->sq_ring_size);
+
+  /* Closing the instance also unregisters buffers. */
+  if (uring->fd >= 0)
+    close(uring->fd);
+
+  memset(uring, 0, sizeof(*uring));
+  uring->fd = -1;
+}
+
+/** Write buffers in the order they are submitted. */
+static void *writer_thread(void *arg) {
+  tsig_writer_t *writer = arg;
+  tsig_writer_buf_t *buf;
+  int err;
+
+  pthread_mutex_lock(&writer->lock);
+
+  for (;;) {
+    buf = &writer->bufs[writer->next];
+    while (!buf->is_busy && !writer->is_stopping)
+      pthread_cond_wait(&writer->cond, &writer->lock);
+
+    if (!buf->is_busy)
+      break;
+
+    /* Buffers in flight belong to this thread until no longer busy. */
+    pthread_mutex_unlock(&writer->lock);
+    err = writer_pwrite(writer->fd, buf->data, buf->size, buf->offset);
+    pthread_mutex_lock(&writer->lock);
+
+    if (err < 0)
+      writer_fail(writer, err);
+
+    buf->done = buf->size;
+    buf->is_busy = false;
+    writer->next = (writer->next + 1) % TSIG_WRITER_BUFS;
+    pthread_cond_broadcast(&writer->cond);
+  }
+
+  pthread_mutex_unlock(&writer->lock);
+
+  return NULL;
+}
+
+/** Start a writer thread. */
+static int writer_thread_init(tsig_writer_t *writer) {
+  sigset_t mask;
+  sigset_t old;
+  int err;
+
+  pthread_mutex_init(&writer->lock, NULL);
+  pthread_cond_init(&writer->cond, NULL);
+
+  /* Signals are for the thread generating audio. */
+  sigfillset(&mask);
+  pthread_sigmask(SIG_BLOCK, &mask, &old);
+  err = pthread_create(&writer->thread, NULL, &writer_thread, writer);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (err) {
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+    return -err;
+  }
+
+  return 0;
+}
+
+/** Stop a writer thread once it has written everything submitted. */
+static void writer_thread_deinit(tsig_writer_t *writer) {
+  pthread_mutex_lock(&writer->lock);
+  writer->is_stopping = true;
+  pthread_cond_broadcast(&writer->cond);
+  pthread_mutex_unlock(&writer->lock);
+
+  pthread_join(writer->thread, NULL);
+
+  pthread_cond_destroy(&writer->cond);
+  pthread_mutex_destroy(&writer->lock);
+}
+
+/** Wait until a buffer is no longer in flight. */
+static int writer_wait(tsig_writer_t *writer, uint32_t i) {
+  tsig_writer_buf_t *buf = &writer->bufs[i];
+  int err;
+
+  if (writer->mode == TSIG_WRITER_MODE_THREAD) {
+    pthread_mutex_lock(&writer->lock);
+    while (buf->is_busy)
+      pthread_cond_wait(&writer->cond, &writer->lock);
+    err = writer->err;
+    pthread_mutex_unlock(&writer->lock);
+
+    return err;
+  }
+
+  while (buf->is_busy) {
+    err = writer_uring_reap(writer);
+    if (err < 0) {
+      writer_fail(writer, err);
+      return err;
+    }
+  }
+
+  return writer->err;
+}
+
+/** Submit the buffer being filled, then wait for the next to be free. */
+static int writer_submit(tsig_writer_t *writer) {
+  tsig_writer_buf_t *buf = &writer->bufs[writer->cur];
+  uint32_t i = writer->cur;
+  int err;
+
+  buf->done = 0;
+  buf->offset = writer->offset;
+  writer->offset += buf->size;
+
+  if (writer->mode == TSIG_WRITER_MODE_THREAD) {
+    pthread_mutex_lock(&writer->lock);
+    buf->is_busy = true;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+  } else {
+    buf->is_busy = true;
+    writer_uring_submit(writer, i);
+  }
+
+  writer->cur = (i + 1) % TSIG_WRITER_BUFS;
+
+  err = writer_wait(writer, writer->cur);
+  writer->bufs[writer->cur].size = 0;
+
+  return err;
+}
+
+/**
+ * Initialize asynchronous file writing context.
+ *
+ * @param writer Uninitialized asynchronous file writing context.
+ * @param path Path to a file to create or truncate.
+ * @param is_direct Whether to open the file with O_DIRECT.
+ * @param log Initialized logging context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_writer_init(tsig_writer_t *writer, const char *path, bool is_direct,
+                     tsig_log_t *log) {
+  int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+  int err;
+
+  memset(writer, 0, sizeof(*writer));
+  writer->path = path;
+  writer->uring.fd = -1;
+  writer->log = log;
+
+  writer->fd = open(path, flags | (is_direct ? O_DIRECT : 0), writer_file_mode);
+
+  /* Not every filesystem supports O_DIRECT, e.g. tmpfs. */
+  if (writer->fd < 0 && is_direct && errno == EINVAL) {
+    tsig_log_note("Failed to open \"%s\" with O_DIRECT, opening without",
+                  path);
+    is_direct = false;
+    writer->fd = open(path, flags, writer_file_mode);
+  }
+
+  if (writer->fd < 0) {
+    err = -errno;
+    tsig_log_err("Failed to open \"%s\": %s", path, strerror(errno));
+    return err;
+  }
+  writer->is_direct = is_direct;
+
+  for (uint32_t i = 0; i < TSIG_WRITER_BUFS; i++) {
+    err = -posix_memalign((void **)&writer->bufs[i].data, TSIG_WRITER_ALIGN,
+                          TSIG_WRITER_BUF_SIZE);
+    if (err < 0) {
+      tsig_log_err("Failed to allocate write buffers");
+      goto out_free_bufs;
+    }
+  }
+
+  err = writer_uring_init(writer);
+  if (!err) {
+    writer->mode = TSIG_WRITER_MODE_URING;
+    tsig_log_dbg("Writing \"%s\" through io_uring%s%s.", path,
+                 writer->uring.is_registered ? ", registered buffers" : "",
+                 is_direct ? ", O_DIRECT" : "");
+    return 0;
+  }
+
+  tsig_log_note("Failed to set up io_uring, using a writer thread: %s",
+                strerror(-err));
+  writer_uring_deinit(writer);
+
+  err = writer_thread_init(writer);
+  if (err < 0) {
+    tsig_log_err("Failed to start writer thread: %s", strerror(-err));
+    goto out_free_bufs;
+  }
+
+  writer->mode = TSIG_WRITER_MODE_THREAD;
+  tsig_log_dbg("Writing \"%s\" through a writer thread%s.", path,
+               is_direct ? ", O_DIRECT" : "");
+
+  return 0;
+
+out_free_bufs:
+  for (uint32_t i = 0; i < TSIG_WRITER_BUFS; i++)
+    free(writer->bufs[i].data);
+
+  close(writer->fd);
+
+  return err;
+}
+
+/**
+ * Lend memory in the buffer being filled.
+ *
+ * Data can be generated directly into it instead of being copied by
+ * tsig_writer_write(). It remains valid until tsig_writer_put_buf().
+ *
+ * @param writer Initialized asynchronous file writing context.
+ * @param[out] out_size Size of the memory in bytes, never 0.
+ * @return Memory lent.
+ */
+void *tsig_writer_get_buf(tsig_writer_t *writer, size_t *out_size) {
+  tsig_writer_buf_t *buf = &writer->bufs[writer->cur];
+
+  /* A full buffer is submitted at once, so there is always some room. */
+  *out_size = TSIG_WRITER_BUF_SIZE - buf->size;
+
+  return &buf->data[buf->size];
+}
+
+/**
+ * Write to a file from memory lent by tsig_writer_get_buf().
+ *
+ * @param writer Initialized asynchronous file writing context.
+ * @param size Count of bytes filled, at most the size of the memory lent.
+ * @return 0 upon success, negative error code upon error, possibly from
+ *  writing earlier data.
+ */
+int tsig_writer_put_buf(tsig_writer_t *writer, size_t size) {
+  tsig_writer_buf_t *buf = &writer->bufs[writer->cur];
+
+  buf->size += size;
+  if (buf->size == TSIG_WRITER_BUF_SIZE)
+    return writer_submit(writer);
+
+  return 0;
+}
+
+/**
+ * Write to a file.
+ *
+ * Data is copied, and is written at some later time.
+ *
+ * @param writer Initialized asynchronous file writing context.
+ * @param data Data to write.
+ * @param size Size of data in bytes.
+ * @return 0 upon success, negative error code upon error, possibly from
+ *  writing earlier data.
+ */
+int tsig_writer_write(tsig_writer_t *writer, const void *data, size_t size) {
+  const uint8_t *p = data;
+  uint8_t *out;
+  size_t len;
+  int err;
+
+  while (size) {
+    out = tsig_writer_get_buf(writer, &len);
+    if (len > size)
+      len = size;
+
+    memcpy(out, p, len);
+    p += len;
+    size -= len;
+
+    err = tsig_writer_put_buf(writer, len);
+    if (err < 0)
+      return err;
+  }
+
+  return 0;
+}
+
+/**
+ * Deinitialize asynchronous file writing context.
+ *
+ * Everything is written before the file is closed.
+ *
+ * @param writer Initialized asynchronous file writing context.
+ * @return 0 upon success, negative error code upon error.
+ */
+int tsig_writer_deinit(tsig_writer_t *writer) {
+  tsig_writer_buf_t *tail = &writer->bufs[writer->cur];
+  tsig_log_t *log = writer->log;
+  int flags;
+  int err;
+
+  for (uint32_t i = 0; i < TSIG_WRITER_BUFS; i++)
+    if (i != writer->cur)
+      writer_wait(writer, i);
+
+  if (writer->mode == TSIG_WRITER_MODE_THREAD)
+    writer_thread_deinit(writer);
+  else
+    writer_uring_deinit(writer);
+
+  err = writer->err;
+
+  /* The tail is written synchronously, and without O_DIRECT if unaligned. */
+  if (!err && tail->size) {
+    if (writer->is_direct && tail->size % TSIG_WRITER_ALIGN) {
+      flags = fcntl(writer->fd, F_GETFL);
+      if (flags >= 0)
+        fcntl(writer->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    err = writer_pwrite(writer->fd, tail->data, tail->size, writer->offset);
+    if (!err)
+      writer->offset += tail->size;
+  }
+
+  if (close(writer->fd) && !err)
+    err = -errno;
+
+  for (uint32_t i = 0; i < TSIG_WRITER_BUFS; i++)
+    free(writer->bufs[i].data);
+
+  if (err < 0) {
+    tsig_log_err("Failed to write \"%s\": %s", writer->path, strerror(-err));
+    return err;
+  }
+
+  tsig_log_dbg("Wrote %" PRIu64 " bytes to \"%s\".", writer->offset,
+               writer->path);
+
+  return 0;
+}
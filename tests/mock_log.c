@@ -20,13 +20,15 @@ void __wrap_tsig_log_init(tsig_log_t *log) {
   (void)log; /* Suppress unused parameter warning. */
 }
 
-void __wrap_tsig_log_finish_init(tsig_log_t *log, char log_file[], bool syslog,
-                                 bool verbose, bool quiet) {
-  (void)log;      /* Suppress unused parameter warning. */
-  (void)log_file; /* Suppress unused parameter warning. */
-  (void)syslog;   /* Suppress unused parameter warning. */
-  (void)verbose;  /* Suppress unused parameter warning. */
-  (void)quiet;    /* Suppress unused parameter warning. */
+void __wrap_tsig_log_finish_init(tsig_log_t *log, char log_file[],
+                                 char binlog_file[], bool syslog, bool verbose,
+                                 bool quiet) {
+  (void)log;         /* Suppress unused parameter warning. */
+  (void)log_file;    /* Suppress unused parameter warning. */
+  (void)binlog_file; /* Suppress unused parameter warning. */
+  (void)syslog;      /* Suppress unused parameter warning. */
+  (void)verbose;     /* Suppress unused parameter warning. */
+  (void)quiet;       /* Suppress unused parameter warning. */
 }
 
 void __wrap_tsig_log_msg(tsig_log_t *log, int level, const char *src_file,
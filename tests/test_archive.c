@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_archive.c: Test minute-frame archive facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "archive.c"
+
+#include "mock_log.c"
+
+#include "coherent.c"
+#include "datetime.c"
+#include "governor.c"
+#include "iir.c"
+#include "jitter.c"
+#include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
+#include "station.c"
+#include "util.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+static const char *test_archive_path = "test_archive.tsa";
+
+static void test_archive_symbol_bits(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  assert_int_equal(archive_symbol_bits(1), 1);
+  assert_int_equal(archive_symbol_bits(2), 1);
+  assert_int_equal(archive_symbol_bits(3), 2);
+  assert_int_equal(archive_symbol_bits(4), 2);
+  assert_int_equal(archive_symbol_bits(5), 4);
+  assert_int_equal(archive_symbol_bits(16), 4);
+  assert_int_equal(archive_symbol_bits(17), 8);
+  assert_int_equal(archive_symbol_bits(256), 8);
+  assert_int_equal(archive_record_size(2), 16);
+  assert_int_equal(archive_record_size(4), 31);
+}
+
+static void test_archive_get_put_symbol(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  uint8_t xmit_level[TSIG_STATION_TICKS_MIN / CHAR_BIT] = {0};
+
+  archive_put_symbol(xmit_level, 1, 0xffffc);
+  assert_int_equal(xmit_level[2], 0xc0);
+  assert_int_equal(xmit_level[3], 0xff);
+  assert_int_equal(xmit_level[4], 0xff);
+  assert_int_equal(xmit_level[5], 0x00);
+  assert_int_equal(archive_get_symbol(xmit_level, 1), 0xffffc);
+  assert_int_equal(archive_get_symbol(xmit_level, 0), 0);
+  assert_int_equal(archive_get_symbol(xmit_level, 2), 0);
+}
+
+static void test_tsig_archive_write(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_station_t dcf77 = {.station = TSIG_STATION_ID_DCF77};
+  tsig_station_t msf = {.station = TSIG_STATION_ID_MSF};
+  int64_t timestamp = 4078428000000; /* 2099-03-29 01:40:00 CET */
+  uint8_t xmit_level[sizeof(dcf77.xmit_level)];
+  tsig_station_frame_t frame;
+  tsig_archive_t archive;
+  tsig_log_t log;
+  uint8_t flags;
+  FILE *file;
+  int err;
+
+  err = tsig_archive_write(&dcf77, test_archive_path, timestamp + 12345, 120,
+                           &log);
+  assert_int_equal(err, 0);
+
+  err = tsig_archive_open(&archive, test_archive_path, &dcf77, &log);
+  assert_int_equal(err, 0);
+  assert_int_equal(archive.station, TSIG_STATION_ID_DCF77);
+  assert_int_equal(archive.timestamp, timestamp);
+  assert_int_equal(archive.minutes, 120);
+  assert_int_equal(archive.symbol_count, 3);
+  assert_int_equal(archive.symbol_bits, 2);
+  assert_int_equal(archive.size, TSIG_ARCHIVE_HEADER_SIZE + 3 * 4 + 120 * 16);
+
+  /* Lookups match the station encoders within the archived range only. */
+  for (int64_t i = 0; i < 120; i += 7) {
+    tsig_station_encode(&dcf77, timestamp + i * 60000, &frame);
+    assert_true(tsig_archive_lookup(&archive, timestamp + i * 60000 + 59999,
+                                    xmit_level, &flags));
+    assert_memory_equal(xmit_level, frame.xmit_level, sizeof(xmit_level));
+    assert_int_equal(flags, frame.flags);
+  }
+
+  assert_false(
+      tsig_archive_lookup(&archive, timestamp - 1, xmit_level, &flags));
+  assert_false(tsig_archive_lookup(&archive, timestamp + 120 * 60000,
+                                   xmit_level, &flags));
+
+  tsig_archive_close(&archive);
+
+  /* A station that doesn't match is rejected. */
+  err = tsig_archive_open(&archive, test_archive_path, &msf, &log);
+  assert_int_equal(err, -EINVAL);
+
+  /* A corrupted record is rejected. */
+  file = fopen(test_archive_path, "r+b");
+  assert_non_null(file);
+  fseek(file, -1, SEEK_END);
+  fputc(0xff, file);
+  fclose(file);
+
+  err = tsig_archive_open(&archive, test_archive_path, &dcf77, &log);
+  assert_int_equal(err, -EINVAL);
+
+  unlink(test_archive_path);
+}
+
+static void test_tsig_archive_station(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_log_t log = {0};
+  tsig_station_t station = {.station = TSIG_STATION_ID_JJY, .log = &log};
+  int64_t timestamp = 4512558000000; /* 2112-12-31 01:20:00 JST */
+  uint8_t xmit_level[sizeof(station.xmit_level)];
+  char meaning[sizeof(station.meaning)];
+  char xmit[sizeof(station.xmit)];
+  tsig_archive_t archive;
+  int err;
+
+  err = tsig_archive_write(&station, test_archive_path, timestamp, 30, &log);
+  assert_int_equal(err, 0);
+
+  err = tsig_archive_open(&archive, test_archive_path, &station, &log);
+  assert_int_equal(err, 0);
+
+  /* Callsign announcements need more symbols. */
+  assert_int_equal(archive.symbol_bits, 4);
+
+  /* The waveform generator takes minutes from the archive when it can. */
+  station_update(&station, timestamp + 25 * 60000);
+  assert_false(station.is_archived);
+  memcpy(xmit_level, station.xmit_level, sizeof(xmit_level));
+  memcpy(meaning, station.meaning, sizeof(meaning));
+  memcpy(xmit, station.xmit, sizeof(xmit));
+  assert_int_equal(station.flags, TSIG_STATION_FLAG_MORSE);
+
+  station.archive = &archive;
+  memset(station.xmit_level, 0, sizeof(station.xmit_level));
+  memset(station.meaning, 0, sizeof(station.meaning));
+  memset(station.xmit, 0, sizeof(station.xmit));
+  station.flags = 0;
+  log.have_status = true;
+
+  station_update(&station, timestamp + 25 * 60000);
+  assert_true(station.is_archived);
+  assert_false(station.is_archive_gap);
+  assert_memory_equal(station.xmit_level, xmit_level, sizeof(xmit_level));
+  assert_int_equal(station.flags, TSIG_STATION_FLAG_MORSE);
+
+  /* Archived minutes have the same readout and meaning as encoded ones. */
+  assert_string_equal(station.xmit, xmit);
+  assert_string_equal(station.meaning, meaning);
+
+  /* Seconds that don't match the encoder are shown as unknown. */
+  station.xmit_level[10 * TSIG_STATION_TICKS_SEC / CHAR_BIT] ^= 0x01;
+  station_archive_readout(&station, timestamp + 25 * 60000);
+  xmit[10] = '?';
+  assert_string_equal(station.xmit, xmit);
+  assert_string_equal(station.meaning, meaning);
+
+  station.flags = 0;
+  station_archive_readout(&station, timestamp + 25 * 60000);
+  assert_string_equal(station.meaning, "unknown, archived flags 0 differ");
+
+  /* Minutes past the end of the archive are noted once. */
+  station_update(&station, timestamp + 30 * 60000);
+  assert_false(station.is_archived);
+  assert_true(station.is_archive_gap);
+
+  station_update(&station, timestamp + 31 * 60000);
+  assert_true(station.is_archive_gap);
+
+  station_update(&station, timestamp + 29 * 60000);
+  assert_true(station.is_archived);
+  assert_false(station.is_archive_gap);
+
+  tsig_archive_close(&archive);
+  unlink(test_archive_path);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_archive_symbol_bits),
+      cmocka_unit_test(test_archive_get_put_symbol),
+      cmocka_unit_test(test_tsig_archive_write),
+      cmocka_unit_test(test_tsig_archive_station),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -18,6 +18,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <cmocka.h>
 
@@ -49,6 +50,12 @@ static void test_audio_format_is_float(void **state) {
   assert_true(audio_format_is_float(TSIG_AUDIO_FORMAT_FLOAT64));
   assert_true(audio_format_is_float(TSIG_AUDIO_FORMAT_FLOAT64_LE));
   assert_true(audio_format_is_float(TSIG_AUDIO_FORMAT_FLOAT64_BE));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_S24_3));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_S24_3LE));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_S24_3BE));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_U24_3));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_U24_3LE));
+  assert_false(audio_format_is_float(TSIG_AUDIO_FORMAT_U24_3BE));
 }
 
 static void test_audio_format_is_signed(void **state) {
@@ -79,6 +86,12 @@ static void test_audio_format_is_signed(void **state) {
   assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_FLOAT64));
   assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_FLOAT64_LE));
   assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_FLOAT64_BE));
+  assert_true(audio_format_is_signed(TSIG_AUDIO_FORMAT_S24_3));
+  assert_true(audio_format_is_signed(TSIG_AUDIO_FORMAT_S24_3LE));
+  assert_true(audio_format_is_signed(TSIG_AUDIO_FORMAT_S24_3BE));
+  assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_U24_3));
+  assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_U24_3LE));
+  assert_false(audio_format_is_signed(TSIG_AUDIO_FORMAT_U24_3BE));
 }
 
 static void test_audio_format_is_le(void **state) {
@@ -111,6 +124,12 @@ static void test_audio_format_is_le(void **state) {
   assert_int_equal(audio_format_is_le(TSIG_AUDIO_FORMAT_FLOAT64), b);
   assert_true(audio_format_is_le(TSIG_AUDIO_FORMAT_FLOAT64_LE));
   assert_false(audio_format_is_le(TSIG_AUDIO_FORMAT_FLOAT64_BE));
+  assert_int_equal(audio_format_is_le(TSIG_AUDIO_FORMAT_S24_3), b);
+  assert_true(audio_format_is_le(TSIG_AUDIO_FORMAT_S24_3LE));
+  assert_false(audio_format_is_le(TSIG_AUDIO_FORMAT_S24_3BE));
+  assert_int_equal(audio_format_is_le(TSIG_AUDIO_FORMAT_U24_3), b);
+  assert_true(audio_format_is_le(TSIG_AUDIO_FORMAT_U24_3LE));
+  assert_false(audio_format_is_le(TSIG_AUDIO_FORMAT_U24_3BE));
 }
 
 static void test_audio_format_width(void **state) {
@@ -141,6 +160,12 @@ static void test_audio_format_width(void **state) {
   assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_FLOAT64), 8);
   assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_FLOAT64_LE), 8);
   assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_FLOAT64_BE), 8);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_S24_3), 3);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_S24_3LE), 3);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_S24_3BE), 3);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_U24_3), 3);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_U24_3LE), 3);
+  assert_int_equal(audio_format_width(TSIG_AUDIO_FORMAT_U24_3BE), 3);
 }
 
 static void test_tsig_audio_format(void **state) {
@@ -175,6 +200,12 @@ static void test_tsig_audio_format(void **state) {
   assert_int_equal(tsig_audio_format("FLOAT64"), TSIG_AUDIO_FORMAT_FLOAT64);
   assert_int_equal(tsig_audio_format("FLOAT64_LE"), TSIG_AUDIO_FORMAT_FLOAT64_LE);
   assert_int_equal(tsig_audio_format("FLOAT64_BE"), TSIG_AUDIO_FORMAT_FLOAT64_BE);
+  assert_int_equal(tsig_audio_format("S24_3"), TSIG_AUDIO_FORMAT_S24_3);
+  assert_int_equal(tsig_audio_format("S24_3LE"), TSIG_AUDIO_FORMAT_S24_3LE);
+  assert_int_equal(tsig_audio_format("S24_3BE"), TSIG_AUDIO_FORMAT_S24_3BE);
+  assert_int_equal(tsig_audio_format("U24_3"), TSIG_AUDIO_FORMAT_U24_3);
+  assert_int_equal(tsig_audio_format("U24_3LE"), TSIG_AUDIO_FORMAT_U24_3LE);
+  assert_int_equal(tsig_audio_format("U24_3BE"), TSIG_AUDIO_FORMAT_U24_3BE);
   /* clang-format on */
 }
 
@@ -206,6 +237,12 @@ static void test_tsig_audio_format_name(void **state) {
   assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_FLOAT64), "FLOAT64");
   assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_FLOAT64_LE), "FLOAT64_LE");
   assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_FLOAT64_BE), "FLOAT64_BE");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_S24_3), "S24_3");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_S24_3LE), "S24_3LE");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_S24_3BE), "S24_3BE");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_U24_3), "U24_3");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_U24_3LE), "U24_3LE");
+  assert_string_equal(tsig_audio_format_name(TSIG_AUDIO_FORMAT_U24_3BE), "U24_3BE");
   /* clang-format on */
 }
 
@@ -238,6 +275,12 @@ static void test_tsig_audio_format_phys_width(void **state) {
   assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_FLOAT64), 8);
   assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_FLOAT64_LE), 8);
   assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_FLOAT64_BE), 8);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_S24_3), 3);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_S24_3LE), 3);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_S24_3BE), 3);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_U24_3), 3);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_U24_3LE), 3);
+  assert_int_equal(tsig_audio_format_phys_width(TSIG_AUDIO_FORMAT_U24_3BE), 3);
   /* clang-format on */
 }
 
@@ -316,6 +359,18 @@ static void test_tsig_audio_fill_buffer(void **state) {
   tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_FLOAT64_BE, 1, 1, buf, cb_buf);
   uint8_t ref_float64_be[] = {0xbf, 0xda, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00};
   assert_memory_equal(buf, ref_float64_be, 8);
+  tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S24_3LE, 1, 1, buf, cb_buf);
+  uint8_t ref_s24_3le[] = {0x00, 0xaf, 0xcb};
+  assert_memory_equal(buf, ref_s24_3le, 3);
+  tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S24_3BE, 1, 1, buf, cb_buf);
+  uint8_t ref_s24_3be[] = {0xcb, 0xaf, 0x00};
+  assert_memory_equal(buf, ref_s24_3be, 3);
+  tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_U24_3LE, 1, 1, buf, cb_buf);
+  uint8_t ref_u24_3le[] = {0x00, 0xaf, 0x4b};
+  assert_memory_equal(buf, ref_u24_3le, 3);
+  tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_U24_3BE, 1, 1, buf, cb_buf);
+  uint8_t ref_u24_3be[] = {0x4b, 0xaf, 0x00};
+  assert_memory_equal(buf, ref_u24_3be, 3);
 
   /* Multiple interleaved frames. */
   tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S16_LE, 2, 2, buf, cb_buf);
@@ -323,6 +378,121 @@ static void test_tsig_audio_fill_buffer(void **state) {
   assert_memory_equal(buf, ref_interleaved, 8);
 }
 
+static void test_tsig_audio_fill_buffer_packed(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  double cb_buf[] = {-1.0,  -0.40869600005658424, -0.1, 0.0, 0.1,
+                     0.25, 0.6852241982123343,   0.9,  1.0};
+  uint8_t buf_packed[256];
+  uint8_t ref_packed[256];
+  uint8_t buf[256];
+
+  /*
+   * Packed 24-bit output should match the significant bytes of 24-in-32
+   * output, for both whole groups of four samples and any left over.
+   */
+  for (uint32_t channels = 1; channels <= 3; channels++) {
+    for (uint32_t size = 1; size <= sizeof(cb_buf) / sizeof(*cb_buf); size++) {
+      uint32_t count = channels * size;
+
+      memset(buf_packed, 0xaa, sizeof(buf_packed));
+      memset(ref_packed, 0xaa, sizeof(ref_packed));
+
+      tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S24_LE, channels, size, buf,
+                             cb_buf);
+      for (uint32_t k = 0; k < count; k++)
+        memcpy(&ref_packed[3 * k], &buf[4 * k], 3);
+      tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S24_3LE, channels, size,
+                             buf_packed, cb_buf);
+      assert_memory_equal(buf_packed, ref_packed, sizeof(buf_packed));
+
+      /* Output may start anywhere, e.g. after an odd count of frames. */
+      tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S24_3LE, channels, size,
+                             &buf_packed[1], cb_buf);
+      assert_memory_equal(&buf_packed[1], ref_packed, 3 * count);
+      memset(buf_packed, 0xaa, sizeof(buf_packed));
+
+      tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_U24_BE, channels, size, buf,
+                             cb_buf);
+      for (uint32_t k = 0; k < count; k++)
+        memcpy(&ref_packed[3 * k], &buf[4 * k + 1], 3);
+      tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_U24_3BE, channels, size,
+                             buf_packed, cb_buf);
+      assert_memory_equal(buf_packed, ref_packed, sizeof(buf_packed));
+    }
+  }
+}
+
+static void test_tsig_audio_fill_buffer_q15(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  int32_t cb_q15[] = {-32768, -32767, -13392, -1, 0, 1, 22453, 32767, 32768};
+  size_t size = sizeof(cb_q15) / sizeof(*cb_q15);
+  double cb_f64[sizeof(cb_q15) / sizeof(*cb_q15)];
+  uint8_t buf_q15[256];
+  uint8_t buf_f64[256];
+
+  /* Output should be identical for samples exactly representable in Q15. */
+  for (size_t i = 0; i < size; i++)
+    cb_f64[i] = cb_q15[i] / 32768.0;
+
+  for (tsig_audio_format_t format = TSIG_AUDIO_FORMAT_S16;
+       format <= TSIG_AUDIO_FORMAT_U24_3BE; format++) {
+    memset(buf_q15, 0, sizeof(buf_q15));
+    memset(buf_f64, 0, sizeof(buf_f64));
+    tsig_audio_fill_buffer_q15(format, 2, size, buf_q15, cb_q15);
+    tsig_audio_fill_buffer_f64(format, 2, size, buf_f64, cb_f64);
+    assert_memory_equal(buf_q15, buf_f64, sizeof(buf_q15));
+  }
+}
+
+static void test_tsig_audio_fill_buffer_kernel(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  double cb_buf[] = {-1.0,  -0.40869600005658424, -0.1, 0.0, 0.1,
+                     0.25, 0.6852241982123343,   0.9,  1.0};
+  size_t size = sizeof(cb_buf) / sizeof(*cb_buf);
+  uint8_t buf_specialized[256];
+  uint8_t buf_generic[256];
+
+  /* Every format has a specialized kernel with identical output. */
+  for (tsig_audio_format_t format = TSIG_AUDIO_FORMAT_S16;
+       format <= TSIG_AUDIO_FORMAT_U24_3BE; format++) {
+    for (uint32_t channels = 1; channels <= 3; channels++) {
+      memset(buf_specialized, 0, sizeof(buf_specialized));
+      memset(buf_generic, 0, sizeof(buf_generic));
+      assert_true(tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_SPECIALIZED,
+                                                format, channels, size,
+                                                buf_specialized, cb_buf));
+      assert_true(tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_GENERIC,
+                                                format, channels, size,
+                                                buf_generic, cb_buf));
+      assert_memory_equal(buf_specialized, buf_generic, sizeof(buf_generic));
+    }
+  }
+
+  assert_false(tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_SPECIALIZED,
+                                             TSIG_AUDIO_FORMAT_UNKNOWN, 1, 1,
+                                             buf_specialized, cb_buf));
+  assert_false(tsig_audio_fill_buffer_kernel(TSIG_AUDIO_KERNEL_UNKNOWN,
+                                             TSIG_AUDIO_FORMAT_S16, 1, 1,
+                                             buf_specialized, cb_buf));
+
+  /* The kernel in use is the one last set. */
+  tsig_audio_set_kernel(TSIG_AUDIO_KERNEL_SPECIALIZED);
+  memset(buf_specialized, 0xaa, sizeof(buf_specialized));
+  tsig_audio_fill_buffer(TSIG_AUDIO_FORMAT_S16_BE, 1, 1, buf_specialized,
+                         cb_buf);
+  assert_memory_equal(buf_specialized, "\x80\x00\xaa", 3);
+  tsig_audio_set_kernel(TSIG_AUDIO_KERNEL_GENERIC);
+
+  assert_int_equal(tsig_audio_kernel("specialized"),
+                   TSIG_AUDIO_KERNEL_SPECIALIZED);
+  assert_int_equal(tsig_audio_kernel("invalid"), TSIG_AUDIO_KERNEL_UNKNOWN);
+  assert_string_equal(tsig_audio_kernel_name(TSIG_AUDIO_KERNEL_GENERIC),
+                      "generic");
+}
+
 static void test_tsig_is_cpu_le(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -343,6 +513,9 @@ int main(void) {
       cmocka_unit_test(test_tsig_audio_format_phys_width),
       cmocka_unit_test(test_tsig_audio_rate),
       cmocka_unit_test(test_tsig_audio_fill_buffer),
+      cmocka_unit_test(test_tsig_audio_fill_buffer_packed),
+      cmocka_unit_test(test_tsig_audio_fill_buffer_q15),
+      cmocka_unit_test(test_tsig_audio_fill_buffer_kernel),
       cmocka_unit_test(test_tsig_is_cpu_le),
   };
 
@@ -43,6 +43,16 @@ static void test_tsig_backend(void **state) {
   assert_int_equal(tsig_backend("AlSa"), TSIG_BACKEND_ALSA);
 #endif /* TSIG_HAVE_ALSA */
 
+#ifdef TSIG_HAVE_PLUGIN
+  assert_int_equal(tsig_backend("plugin"), TSIG_BACKEND_PLUGIN);
+  assert_int_equal(tsig_backend("PlUgIn"), TSIG_BACKEND_PLUGIN);
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  assert_int_equal(tsig_backend("file"), TSIG_BACKEND_FILE);
+  assert_int_equal(tsig_backend("FiLe"), TSIG_BACKEND_FILE);
+#endif /* TSIG_HAVE_FILE */
+
   assert_int_equal(tsig_backend(""), TSIG_BACKEND_UNKNOWN);
   assert_int_equal(tsig_backend(NULL), TSIG_BACKEND_UNKNOWN);
   assert_int_equal(tsig_backend("asdf"), TSIG_BACKEND_UNKNOWN);
@@ -62,6 +72,14 @@ static void test_tsig_backend_name(void **state) {
 #ifdef TSIG_HAVE_ALSA
   assert_string_equal(tsig_backend_name(TSIG_BACKEND_ALSA), "ALSA");
 #endif /* TSIG_HAVE_ALSA */
+
+#ifdef TSIG_HAVE_PLUGIN
+  assert_string_equal(tsig_backend_name(TSIG_BACKEND_PLUGIN), "plugin");
+#endif /* TSIG_HAVE_PLUGIN */
+
+#ifdef TSIG_HAVE_FILE
+  assert_string_equal(tsig_backend_name(TSIG_BACKEND_FILE), "file");
+#endif /* TSIG_HAVE_FILE */
 }
 
 int main(void) {
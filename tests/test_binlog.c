@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_binlog.c: Test binary logging facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "binlog.c"
+
+#include "mock_log.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+static const char *test_binlog_path = "test_binlog.tsb";
+
+static tsig_binlog_t test_binlog;
+
+/** Write a message to a binary log file. */
+static void test_binlog_write(tsig_binlog_t *binlog, int level,
+                              const char *fmt, ...) {
+  va_list params;
+
+  va_start(params, fmt);
+  tsig_binlog_write(binlog, level, fmt, params);
+  va_end(params);
+}
+
+/** Print a binary log file into a buffer, timestamps removed. */
+static void test_binlog_print(char buf[], size_t size) {
+  char line[TSIG_BINLOG_LINE_SIZE];
+  tsig_log_t log;
+  size_t len = 0;
+  FILE *file;
+  char *msg;
+
+  file = tmpfile();
+  assert_non_null(file);
+  assert_int_equal(tsig_binlog_print(test_binlog_path, file, &log), 0);
+  rewind(file);
+
+  buf[0] = '\0';
+  while (fgets(line, sizeof(line), file)) {
+    msg = strstr(line, "] | ");
+    assert_non_null(msg);
+    len += snprintf(&buf[len], size - len, "%s", &msg[4]);
+    assert_true(len < size);
+  }
+
+  fclose(file);
+}
+
+static void test_binlog_format_parse(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_binlog_format_t format;
+
+  assert_true(binlog_format_parse(
+      &format, "%d %5.2f %s %p %zu %hhx %-*.*s %% %Lg %c %lld"));
+  assert_int_equal(format.arg_count, 12);
+  assert_memory_equal(format.args, "idspzBiisDiq", 12);
+  assert_int_equal(format.arg_size, 10 * 8 + 2 * 2);
+
+  assert_true(binlog_format_parse(&format, "No arguments."));
+  assert_int_equal(format.arg_count, 0);
+
+  /* Some conversions can only be recorded preformatted. */
+  assert_false(binlog_format_parse(&format, "%n"));
+  assert_false(binlog_format_parse(&format, "%ls"));
+  assert_false(binlog_format_parse(&format, "%1$d"));
+  assert_false(binlog_format_parse(&format, "%hhhd"));
+  assert_false(binlog_format_parse(&format, "%d%%%"));
+}
+
+static void test_tsig_binlog_write(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static const char *fmt = "%s=%d %.3f %#x %c %5s|%-*s|%hhu";
+  char buf[1024];
+
+  unlink(test_binlog_path);
+  assert_int_equal(tsig_binlog_open(&test_binlog, test_binlog_path), 0);
+
+  test_binlog_write(&test_binlog, LOG_INFO, fmt, "a", -42, 1.5, 255, 'z', "b",
+                    4, "c", 258);
+  test_binlog_write(&test_binlog, LOG_WARNING, "%s", NULL);
+  test_binlog_write(&test_binlog, LOG_DEBUG, "%ls", L"wide");
+  tsig_binlog_close(&test_binlog);
+
+  test_binlog_print(buf, sizeof(buf));
+  assert_string_equal(buf,
+                      "a=-42 1.500 0xff z     b|c   |2\n"
+                      "warning: (null)\n"
+                      "debug: wide\n");
+
+  /* Format strings are recorded once and reused by a reopened file. */
+  assert_int_equal(tsig_binlog_open(&test_binlog, test_binlog_path), 0);
+  assert_int_equal(binlog_header(test_binlog.map)->dict_count, 2);
+
+  test_binlog_write(&test_binlog, LOG_ERR, "%s", "again");
+  assert_int_equal(binlog_header(test_binlog.map)->dict_count, 2);
+  tsig_binlog_close(&test_binlog);
+
+  test_binlog_print(buf, sizeof(buf));
+  assert_non_null(strstr(buf, "debug: wide\nerror: again\n"));
+
+  unlink(test_binlog_path);
+}
+
+static void test_tsig_binlog_write_wrap(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  char str[TSIG_BINLOG_RECORD_SIZE];
+  char line[TSIG_BINLOG_LINE_SIZE];
+  binlog_header_t *header;
+  uint32_t records;
+  uint32_t first = 0;
+  uint32_t count = 0;
+  tsig_log_t log;
+  uint32_t i;
+  FILE *file;
+
+  unlink(test_binlog_path);
+  assert_int_equal(tsig_binlog_open(&test_binlog, test_binlog_path), 0);
+  header = binlog_header(test_binlog.map);
+  records = header->ring_size / (sizeof(binlog_record_t) + sizeof(uint64_t));
+
+  /* Overlong strings are truncated to fit a record. */
+  memset(str, 'x', sizeof(str) - 1);
+  str[sizeof(str) - 1] = '\0';
+  test_binlog_write(&test_binlog, LOG_INFO, "%s %d", str, 1);
+  assert_int_equal(header->head, TSIG_BINLOG_RECORD_SIZE);
+
+  /* Write enough to wrap around the ring a few times. */
+  for (i = 0; i < 4 * records; i++) {
+    test_binlog_write(&test_binlog, LOG_INFO, "%" PRIu32, i);
+    assert_true(header->head - header->tail <= header->ring_size);
+  }
+
+  assert_true(header->head - header->tail >
+              header->ring_size - TSIG_BINLOG_RECORD_SIZE);
+  tsig_binlog_close(&test_binlog);
+
+  /* Only the newest records survive, oldest first. */
+  file = tmpfile();
+  assert_non_null(file);
+  assert_int_equal(tsig_binlog_print(test_binlog_path, file, &log), 0);
+  rewind(file);
+
+  while (fgets(line, sizeof(line), file)) {
+    if (!count)
+      first = strtoul(strstr(line, "] | ") + 4, NULL, 10);
+    assert_int_equal(strtoul(strstr(line, "] | ") + 4, NULL, 10),
+                     first + count);
+    count++;
+  }
+
+  fclose(file);
+
+  assert_int_equal(first + count, i);
+  assert_int_equal(count, records);
+
+  unlink(test_binlog_path);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_binlog_format_parse),
+      cmocka_unit_test(test_tsig_binlog_write),
+      cmocka_unit_test(test_tsig_binlog_write_wrap),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
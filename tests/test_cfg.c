@@ -11,11 +11,17 @@
 
 #include "mock_log.c"
 
+#include "archive.c"
 #include "audio.c"
 #include "backend.c"
+#include "coherent.c"
 #include "datetime.c"
+#include "governor.c"
 #include "iir.c"
+#include "jitter.c"
 #include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
 #include "station.c"
 #include "util.c"
 
@@ -302,6 +308,30 @@ static void test_cfg_set_dut1(void **state) {
   assert_int_equal(cfg.dut1, 12345);
 }
 
+static void test_cfg_set_coherent(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.coherent = false;
+  assert_true(cfg_set_coherent(&cfg, &log, NULL));
+  assert_true(cfg.coherent);
+  cfg.coherent = false;
+  assert_true(cfg_set_coherent(&cfg, &log, "On"));
+  assert_true(cfg.coherent);
+  cfg.coherent = true;
+  assert_true(cfg_set_coherent(&cfg, &log, "off"));
+  assert_false(cfg.coherent);
+
+  cfg.coherent = true;
+  assert_false(cfg_set_coherent(&cfg, &log, "invalid"));
+  assert_true(cfg.coherent);
+  cfg.coherent = true;
+  assert_false(cfg_set_coherent(&cfg, &log, ""));
+  assert_true(cfg.coherent);
+}
+
 static void test_cfg_set_timeout(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -370,12 +400,26 @@ static void test_cfg_set_backend(void **state) {
   assert_int_equal(cfg.backend, TSIG_BACKEND_ALSA);
   assert_true(cfg_set_backend(&cfg, &log, "AlSa"));
   assert_int_equal(cfg.backend, TSIG_BACKEND_ALSA);
+  assert_true(cfg_set_backend(&cfg, &log, "plugin:/usr/lib/sink.so"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_PLUGIN);
+  assert_string_equal(cfg.plugin, "/usr/lib/sink.so");
+  assert_true(cfg_set_backend(&cfg, &log, "file:/tmp/out.raw"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_FILE);
+  assert_string_equal(cfg.file, "/tmp/out.raw");
 
   cfg.backend = TSIG_BACKEND_PIPEWIRE;
   assert_false(cfg_set_backend(&cfg, &log, "WirePipe"));
   assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
   assert_false(cfg_set_backend(&cfg, &log, ""));
   assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
+  assert_false(cfg_set_backend(&cfg, &log, "plugin"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
+  assert_false(cfg_set_backend(&cfg, &log, "plugin:"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
+  assert_false(cfg_set_backend(&cfg, &log, "file"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
+  assert_false(cfg_set_backend(&cfg, &log, "file:"));
+  assert_int_equal(cfg.backend, TSIG_BACKEND_PIPEWIRE);
 }
 
 static void test_cfg_set_device(void **state) {
@@ -400,6 +444,54 @@ static void test_cfg_set_device(void **state) {
   assert_string_equal(cfg.device, "");
 }
 
+static void test_cfg_set_tsched(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.tsched = false;
+  assert_true(cfg_set_tsched(&cfg, &log, NULL));
+  assert_true(cfg.tsched);
+  cfg.tsched = false;
+  assert_true(cfg_set_tsched(&cfg, &log, "On"));
+  assert_true(cfg.tsched);
+  cfg.tsched = true;
+  assert_true(cfg_set_tsched(&cfg, &log, "off"));
+  assert_false(cfg.tsched);
+
+  cfg.tsched = true;
+  assert_false(cfg_set_tsched(&cfg, &log, "invalid"));
+  assert_true(cfg.tsched);
+  cfg.tsched = true;
+  assert_false(cfg_set_tsched(&cfg, &log, ""));
+  assert_true(cfg.tsched);
+}
+
+static void test_cfg_set_direct(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.direct = false;
+  assert_true(cfg_set_direct(&cfg, &log, NULL));
+  assert_true(cfg.direct);
+  cfg.direct = false;
+  assert_true(cfg_set_direct(&cfg, &log, "On"));
+  assert_true(cfg.direct);
+  cfg.direct = true;
+  assert_true(cfg_set_direct(&cfg, &log, "off"));
+  assert_false(cfg.direct);
+
+  cfg.direct = true;
+  assert_false(cfg_set_direct(&cfg, &log, "invalid"));
+  assert_true(cfg.direct);
+  cfg.direct = true;
+  assert_false(cfg_set_direct(&cfg, &log, ""));
+  assert_true(cfg.direct);
+}
+
 static void test_cfg_set_format(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -596,6 +688,30 @@ static void test_cfg_set_audible(void **state) {
   assert_true(cfg.audible);
 }
 
+static void test_cfg_set_governor(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.governor = false;
+  assert_true(cfg_set_governor(&cfg, &log, NULL));
+  assert_true(cfg.governor);
+  cfg.governor = false;
+  assert_true(cfg_set_governor(&cfg, &log, "on"));
+  assert_true(cfg.governor);
+  cfg.governor = true;
+  assert_true(cfg_set_governor(&cfg, &log, "OfF"));
+  assert_false(cfg.governor);
+
+  cfg.governor = true;
+  assert_false(cfg_set_governor(&cfg, &log, "invalid"));
+  assert_true(cfg.governor);
+  cfg.governor = true;
+  assert_false(cfg_set_governor(&cfg, &log, ""));
+  assert_true(cfg.governor);
+}
+
 static void test_cfg_set_log_file(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -690,6 +806,54 @@ static void test_cfg_set_quiet(void **state) {
   assert_true(cfg.quiet);
 }
 
+static void test_cfg_set_jitter(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.jitter = false;
+  assert_true(cfg_set_jitter(&cfg, &log, NULL));
+  assert_true(cfg.jitter);
+  cfg.jitter = false;
+  assert_true(cfg_set_jitter(&cfg, &log, "on"));
+  assert_true(cfg.jitter);
+  cfg.jitter = true;
+  assert_true(cfg_set_jitter(&cfg, &log, "OfF"));
+  assert_false(cfg.jitter);
+
+  cfg.jitter = true;
+  assert_false(cfg_set_jitter(&cfg, &log, "invalid"));
+  assert_true(cfg.jitter);
+  cfg.jitter = true;
+  assert_false(cfg_set_jitter(&cfg, &log, ""));
+  assert_true(cfg.jitter);
+}
+
+static void test_cfg_set_profile(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg;
+  tsig_log_t log;
+
+  cfg.profile = false;
+  assert_true(cfg_set_profile(&cfg, &log, NULL));
+  assert_true(cfg.profile);
+  cfg.profile = false;
+  assert_true(cfg_set_profile(&cfg, &log, "on"));
+  assert_true(cfg.profile);
+  cfg.profile = true;
+  assert_true(cfg_set_profile(&cfg, &log, "OfF"));
+  assert_false(cfg.profile);
+
+  cfg.profile = true;
+  assert_false(cfg_set_profile(&cfg, &log, "invalid"));
+  assert_true(cfg.profile);
+  cfg.profile = true;
+  assert_false(cfg_set_profile(&cfg, &log, ""));
+  assert_true(cfg.profile);
+}
+
 static void test_cfg_process_file_line(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -776,19 +940,25 @@ int main(void) {
       cmocka_unit_test(test_cfg_set_base),
       cmocka_unit_test(test_cfg_set_offset),
       cmocka_unit_test(test_cfg_set_dut1),
+      cmocka_unit_test(test_cfg_set_coherent),
       cmocka_unit_test(test_cfg_set_timeout),
       cmocka_unit_test(test_cfg_set_backend),
       cmocka_unit_test(test_cfg_set_device),
+      cmocka_unit_test(test_cfg_set_tsched),
+      cmocka_unit_test(test_cfg_set_direct),
       cmocka_unit_test(test_cfg_set_format),
       cmocka_unit_test(test_cfg_set_rate),
       cmocka_unit_test(test_cfg_set_channels),
       cmocka_unit_test(test_cfg_set_smooth),
       cmocka_unit_test(test_cfg_set_ultrasound),
       cmocka_unit_test(test_cfg_set_audible),
+      cmocka_unit_test(test_cfg_set_governor),
       cmocka_unit_test(test_cfg_set_log_file),
       cmocka_unit_test(test_cfg_set_syslog),
       cmocka_unit_test(test_cfg_set_verbose),
       cmocka_unit_test(test_cfg_set_quiet),
+      cmocka_unit_test(test_cfg_set_jitter),
+      cmocka_unit_test(test_cfg_set_profile),
       cmocka_unit_test(test_cfg_process_file_line),
   };
 
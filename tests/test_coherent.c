@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_coherent.c: Test phase-coherent timing facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "coherent.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <cmocka.h>
+
+/** Allowed scheduling delay in ns while a test runs. */
+static const int64_t test_coherent_slack = 100000000;
+
+static int64_t test_coherent_now(clockid_t clock) {
+  struct timespec ts;
+
+  assert_int_equal(clock_gettime(clock, &ts), 0);
+
+  return coherent_nsecs(&ts);
+}
+
+static void test_tsig_coherent_next(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_coherent_t coherent;
+  int64_t realtime;
+  int64_t next;
+
+  tsig_coherent_init(&coherent, 48000, NULL);
+  assert_false(coherent.has_anchor);
+
+  /* Without an anchor, the next frame plays now. */
+  realtime = test_coherent_now(CLOCK_REALTIME);
+  tsig_coherent_advance(&coherent, 4800);
+  next = tsig_coherent_next(&coherent);
+  assert_true(realtime <= next && next < realtime + test_coherent_slack);
+  assert_int_equal(coherent.frames, 4800);
+}
+
+static void test_tsig_coherent_anchor(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_coherent_t coherent;
+  int64_t realtime;
+  int64_t next;
+
+  tsig_coherent_init(&coherent, 48000, NULL);
+  tsig_coherent_advance(&coherent, 4800);
+
+  /* The frame playing now was generated 1 second before the next one. */
+  realtime = test_coherent_now(CLOCK_REALTIME);
+  tsig_coherent_anchor(&coherent, test_coherent_now(CLOCK_MONOTONIC), 48000);
+  assert_true(coherent.has_anchor);
+  assert_int_equal(coherent.anchor_frame, 4800);
+
+  next = tsig_coherent_next(&coherent);
+  realtime += coherent_nsecs_sec;
+  assert_true(realtime <= next && next < realtime + test_coherent_slack);
+
+  /* Generated frames are projected from the anchor at the sample rate. */
+  tsig_coherent_advance(&coherent, 24000);
+  assert_int_equal(tsig_coherent_next(&coherent),
+                   next + coherent_nsecs_sec / 2);
+
+  /* An underrun makes for a negative delay. */
+  realtime = test_coherent_now(CLOCK_REALTIME);
+  tsig_coherent_anchor(&coherent, test_coherent_now(CLOCK_MONOTONIC), -480);
+  assert_int_equal(coherent.anchor_frame, 28800);
+
+  next = tsig_coherent_next(&coherent);
+  realtime -= coherent_nsecs_sec / 100;
+  assert_true(realtime <= next && next < realtime + test_coherent_slack);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_tsig_coherent_next),
+      cmocka_unit_test(test_tsig_coherent_anchor),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
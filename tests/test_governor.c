@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_governor.c: Test adaptive output quality facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "governor.c"
+
+#include "mock_log.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+/** Levels that make a difference with gain smoothing on. */
+static const uint32_t test_governor_levels =
+    1 << TSIG_GOVERNOR_NO_SMOOTH | 1 << TSIG_GOVERNOR_CACHED;
+
+static void test_tsig_governor_end(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_governor_t governor;
+  tsig_log_t log;
+
+  tsig_governor_init(&governor, 48000, &log);
+
+  /* Unstarted callbacks aren't measured. */
+  tsig_governor_end(&governor, 480);
+  assert_int_equal(governor.load, 0);
+
+  /* 5 ms for 10 ms of audio. */
+  governor.started = governor_now() - 5000000;
+  tsig_governor_end(&governor, 480);
+  assert_true(governor.load >= 500 && governor.load < 600);
+  assert_int_equal(governor.started, 0);
+
+  /* The worst load in a minute is kept. */
+  governor.started = governor_now();
+  tsig_governor_end(&governor, 480);
+  assert_true(governor.load >= 500 && governor.load < 600);
+}
+
+static void test_tsig_governor_update(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_governor_t governor;
+  tsig_log_t log;
+
+  tsig_governor_init(&governor, 48000, &log);
+
+  /* Quality stays put with headroom. */
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_FULL);
+
+  /* Too little margin or any xrun steps quality down. */
+  governor.load = 600;
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_NO_SMOOTH);
+  assert_int_equal(governor.load, 0);
+
+  tsig_governor_xrun(&governor);
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_CACHED);
+  assert_int_equal(governor.xruns, 0);
+
+  tsig_governor_xrun(&governor);
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_SQUARE);
+
+  tsig_governor_xrun(&governor);
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_SQUARE);
+
+  /* Quality steps up after enough minutes with headroom. */
+  for (uint32_t i = 1; i < governor_calm_mins; i++) {
+    governor.load = 100;
+    assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                     TSIG_GOVERNOR_SQUARE);
+  }
+
+  assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                   TSIG_GOVERNOR_CACHED);
+
+  /* Moderate load is neither starvation nor headroom. */
+  for (uint32_t i = 0; i < 2 * governor_calm_mins; i++) {
+    governor.load = 300;
+    assert_int_equal(tsig_governor_update(&governor, test_governor_levels),
+                     TSIG_GOVERNOR_CACHED);
+  }
+
+  /* Levels that make no difference are skipped. */
+  for (uint32_t i = 0; i < governor_calm_mins; i++)
+    tsig_governor_update(&governor, 1 << TSIG_GOVERNOR_CACHED);
+
+  assert_int_equal(governor.level, TSIG_GOVERNOR_FULL);
+
+  governor.load = 600;
+  assert_int_equal(tsig_governor_update(&governor, 0), TSIG_GOVERNOR_SQUARE);
+
+  /* Levels that stop making a difference are left. */
+  governor.level = TSIG_GOVERNOR_CACHED;
+  assert_int_equal(tsig_governor_update(&governor, 0), TSIG_GOVERNOR_SQUARE);
+
+  assert_int_equal(governor.xruns_total, 3);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_tsig_governor_end),
+      cmocka_unit_test(test_tsig_governor_update),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
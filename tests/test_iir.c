@@ -147,6 +147,93 @@ static void test_tsig_iir_next(void **state) {
   assert_double_equal(tsig_iir_next(&iir), tmp, epsilon);
 }
 
+static void test_tsig_iir_next_q15(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  /* Frequencies that a station may use, including subharmonics. */
+  uint32_t freqs[] = {1000,  13333, 13700, 15500, 20000, 22833,
+                      25833, 40000, 60000, 68500, 77500};
+  uint32_t rates[] = {44100,  48000,  88200,  96000,
+                      176400, 192000, 352800, 384000};
+  tsig_iir_t iir;
+  tsig_iir_t iir_q;
+
+  /*
+   * The fixed-point generator should track the double-precision generator
+   * to within 1 LSB at common sample rates, and to within 8 LSB at others,
+   * where periods are long enough for rounding errors to accumulate.
+   */
+  for (size_t i = 0; i < sizeof(freqs) / sizeof(*freqs); i++) {
+    for (size_t j = 0; j < sizeof(rates) / sizeof(*rates); j++) {
+      double bound = rates[j] <= 48000 ? 1.0 : 8.0;
+
+      if (freqs[i] > rates[j] / 2)
+        continue;
+
+      tsig_iir_init(&iir, freqs[i], rates[j], -634222343);
+      iir_q = iir;
+
+      for (uint32_t k = 0; k < iir.period + 3; k++)
+        assert_double_equal(tsig_iir_next(&iir) * 32768,
+                            tsig_iir_next_q15(&iir_q), bound);
+    }
+  }
+
+  /* Both generators should reset at the same point in the period. */
+  tsig_iir_init(&iir, 20000, 48000, 0);
+  assert_int_equal(tsig_iir_next_q15(&iir), 0);
+  assert_int_equal(tsig_iir_next_q15(&iir), 16384);
+  for (uint32_t k = 0; k < iir.period - 2; k++)
+    tsig_iir_next_q15(&iir);
+  assert_int_equal(tsig_iir_next_q15(&iir), 0);
+  assert_int_equal(tsig_iir_next_q15(&iir), 16384);
+}
+
+static void test_tsig_iir_seek(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_iir_t iir;
+  tsig_iir_t iir_s;
+  tsig_iir_t tmp;
+  double y;
+
+  /* Seeking, then generating, matches generating from the start. */
+  tsig_iir_init(&iir, 13333, 48000, -634222343);
+  iir_s = iir;
+
+  for (uint32_t k = 0; k < iir.period + 3; k++) {
+    y = tsig_iir_next(&iir);
+    if (k % 997)
+      continue;
+
+    tmp = iir;
+    tsig_iir_seek(&iir_s, k);
+    assert_double_equal(tsig_iir_next(&iir_s), y, epsilon);
+    assert_double_equal(tsig_iir_next(&iir_s), tsig_iir_next(&tmp), epsilon);
+  }
+
+  /* Square waves follow the sign of the sine wave. */
+  tsig_iir_init(&iir, 20000, 48000, 0);
+  tsig_iir_seek(&iir, 0);
+  iir_s = iir;
+
+  for (uint32_t k = 0; k < 2 * iir.period; k++) {
+    y = tsig_iir_next(&iir_s);
+    if (y > epsilon || y < -epsilon)
+      assert_int_equal(tsig_iir_next_square(&iir), y > 0 ? 1 : -1);
+    else
+      tsig_iir_next_square(&iir);
+
+    assert_int_equal(iir.sample, iir_s.sample);
+  }
+
+  /* Indexes wrap with the period. */
+  tsig_iir_seek(&iir, iir.period - 1);
+  assert_int_equal(tsig_iir_next_index(&iir), iir.period - 1);
+  assert_int_equal(tsig_iir_next_index(&iir), 0);
+  assert_int_equal(tsig_iir_next_index(&iir), 1);
+}
+
 int main(void) {
   const struct CMUnitTest tests[] = {
       cmocka_unit_test(test_iir_sin),
@@ -154,6 +241,8 @@ int main(void) {
       cmocka_unit_test(test_iir_gcd),
       cmocka_unit_test(test_tsig_iir_init),
       cmocka_unit_test(test_tsig_iir_next),
+      cmocka_unit_test(test_tsig_iir_next_q15),
+      cmocka_unit_test(test_tsig_iir_seek),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
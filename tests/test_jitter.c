@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_jitter.c: Test edge timing measurement facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "jitter.c"
+
+#include "mock_log.c"
+
+#include "archive.c"
+#include "coherent.c"
+#include "datetime.c"
+#include "governor.c"
+#include "iir.c"
+#include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
+#include "station.c"
+#include "util.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+static void test_jitter_isqrt(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  assert_int_equal(jitter_isqrt(0), 0);
+  assert_int_equal(jitter_isqrt(1), 1);
+  assert_int_equal(jitter_isqrt(3), 1);
+  assert_int_equal(jitter_isqrt(4), 2);
+  assert_int_equal(jitter_isqrt(99), 9);
+  assert_int_equal(jitter_isqrt(1000000000000), 1000000);
+}
+
+static void test_jitter_record(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static tsig_jitter_t jitter;
+  tsig_log_t log;
+
+  tsig_jitter_init(&jitter, 48000, &log);
+  assert_int_equal(tsig_jitter_percentile(&jitter, 500), 0);
+
+  /* 98 errors around 180 ms and one outlier on either side. */
+  for (int64_t i = 0; i < 98; i++)
+    jitter_record(&jitter, 180000 + (i % 2 ? 100 : -100));
+  jitter_record(&jitter, -300000);
+  jitter_record(&jitter, 2000000);
+
+  assert_int_equal(jitter.count, 100);
+  assert_int_equal(jitter.min, -300000);
+  assert_int_equal(jitter.max, 2000000);
+  assert_int_equal(jitter.below, 1);
+  assert_int_equal(jitter.above, 1);
+  assert_int_equal(jitter.bins[jitter_bin(179900)], 49);
+  assert_int_equal(jitter.bins[jitter_bin(180100)], 49);
+  assert_true(jitter.mean > 193399 && jitter.mean < 193401);
+
+  assert_int_equal(tsig_jitter_percentile(&jitter, 0), -300000);
+  assert_int_equal(tsig_jitter_percentile(&jitter, 10), -300000);
+  assert_int_equal(tsig_jitter_percentile(&jitter, 20),
+                   jitter_bin_usecs(jitter_bin(179900)));
+  assert_int_equal(tsig_jitter_percentile(&jitter, 500),
+                   jitter_bin_usecs(jitter_bin(179900)));
+  assert_int_equal(tsig_jitter_percentile(&jitter, 990),
+                   jitter_bin_usecs(jitter_bin(180100)));
+  assert_int_equal(tsig_jitter_percentile(&jitter, 1000), 2000000);
+}
+
+static void test_jitter_resolve(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static tsig_jitter_t jitter;
+  tsig_log_t log;
+
+  tsig_jitter_init(&jitter, 48000, &log);
+
+  /* Edges at 1.000 s and 1.100 s in the second of two 4800-frame buffers. */
+  tsig_jitter_advance(&jitter, 4800);
+  tsig_jitter_edge(&jitter, 0, 1000);
+  tsig_jitter_edge(&jitter, 4800, 1100);
+  tsig_jitter_advance(&jitter, 9600);
+  assert_int_equal(jitter.edge_count, 2);
+
+  /* At 1.050 s, frame 3600 was playing, so frame 4800 plays at 1.075 s. */
+  jitter_resolve(&jitter, 1050000000, 14400 - 3600);
+  assert_int_equal(jitter.edge_count, 0);
+  assert_int_equal(jitter.count, 2);
+  assert_int_equal(jitter.min, 75000);
+  assert_int_equal(jitter.max, 75000);
+
+  /* Edges are dropped rather than overflowing the pending edge array. */
+  for (uint32_t i = 0; i <= TSIG_JITTER_EDGES_MAX; i++)
+    tsig_jitter_edge(&jitter, i, 2000);
+  assert_int_equal(jitter.edge_count, TSIG_JITTER_EDGES_MAX);
+  assert_int_equal(jitter.dropped, 1);
+}
+
+static void test_jitter_station(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static tsig_jitter_t jitter;
+  static tsig_audio_sample_t cb_buf[48000];
+  tsig_station_t station;
+  tsig_log_t log = {0};
+  tsig_cfg_t cfg = {
+      .station = TSIG_STATION_ID_DCF77,
+      .base = 4102444800000, /* 2100-01-01 00:00:00 UTC */
+      .rate = 48000,
+  };
+
+  tsig_station_init(&station, &cfg, &log);
+  tsig_jitter_init(&jitter, cfg.rate, &log);
+  station.jitter = &jitter;
+
+  /* DCF77 lowers its carrier at the start of most seconds. */
+  tsig_station_cb(&station, cb_buf, 48000);
+  tsig_station_cb(&station, cb_buf, 48000);
+  assert_int_equal(jitter.frames, 96000);
+  assert_true(jitter.edge_count >= 2);
+
+  for (uint32_t i = 0; i < jitter.edge_count; i++) {
+    int64_t intended = jitter.edges[i].intended / 1000000;
+    assert_int_equal((intended + station.base_offset) % 50, 0);
+    assert_true(jitter.edges[i].frame < 96000);
+  }
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_jitter_isqrt),
+      cmocka_unit_test(test_jitter_record),
+      cmocka_unit_test(test_jitter_resolve),
+      cmocka_unit_test(test_jitter_station),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
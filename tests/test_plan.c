@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_plan.c: Test startup kernel planning facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "plan.c"
+
+#include "mock_log.c"
+
+#include "audio.c"
+#include "mapping.c"
+#include "util.c"
+
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+static const char *test_plan_path = "test_plan.txt";
+
+/** Count the lines in a wisdom file. */
+static int test_plan_lines(void) {
+  char line[TSIG_PLAN_LINE_SIZE];
+  int count = 0;
+  FILE *file;
+
+  file = fopen(test_plan_path, "r");
+  if (!file)
+    return 0;
+
+  while (fgets(line, sizeof(line), file))
+    count++;
+
+  fclose(file);
+
+  return count;
+}
+
+static void test_plan_machine(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  char machine[TSIG_PLAN_MACHINE_SIZE] = {0};
+
+  plan_machine(machine);
+  assert_true(machine[0]);
+  assert_null(strpbrk(machine, " \t\n"));
+}
+
+static void test_plan_wisdom(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_log_t log;
+
+  unlink(test_plan_path);
+  assert_int_equal(plan_wisdom_find(test_plan_path, "key", &log),
+                   TSIG_AUDIO_KERNEL_UNKNOWN);
+
+  plan_wisdom_add(test_plan_path, "key a", TSIG_AUDIO_KERNEL_SPECIALIZED,
+                  &log);
+  plan_wisdom_add(test_plan_path, "key", TSIG_AUDIO_KERNEL_GENERIC, &log);
+  assert_int_equal(plan_wisdom_find(test_plan_path, "key", &log),
+                   TSIG_AUDIO_KERNEL_GENERIC);
+  assert_int_equal(plan_wisdom_find(test_plan_path, "key a", &log),
+                   TSIG_AUDIO_KERNEL_SPECIALIZED);
+  assert_int_equal(plan_wisdom_find(test_plan_path, "ke", &log),
+                   TSIG_AUDIO_KERNEL_UNKNOWN);
+
+  /* Later lines win. */
+  plan_wisdom_add(test_plan_path, "key", TSIG_AUDIO_KERNEL_SPECIALIZED, &log);
+  assert_int_equal(plan_wisdom_find(test_plan_path, "key", &log),
+                   TSIG_AUDIO_KERNEL_SPECIALIZED);
+
+  unlink(test_plan_path);
+}
+
+static void test_plan_time(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_audio_sample_t cb_buf[TSIG_PLAN_FRAMES];
+  uint8_t buf[TSIG_PLAN_FRAMES * 2 * sizeof(int16_t)];
+  int64_t start;
+  int64_t time;
+
+  /* Each run lasts long enough to rise above timer noise. */
+  plan_sweep(cb_buf, TSIG_PLAN_FRAMES);
+  start = plan_now();
+  time = plan_time(TSIG_AUDIO_KERNEL_GENERIC, TSIG_AUDIO_FORMAT_S16_LE, 2, buf,
+                   cb_buf);
+  assert_true(time > 0);
+  assert_true(plan_now() - start >= TSIG_PLAN_RUNS * TSIG_PLAN_RUN_NSECS);
+
+  /* Only a clear win displaces the generic kernel. */
+  assert_false(plan_is_faster(100, 100));
+  assert_false(plan_is_faster(100 - TSIG_PLAN_MARGIN, 100));
+  assert_true(plan_is_faster(100 - TSIG_PLAN_MARGIN - 1, 100));
+}
+
+static void test_tsig_plan(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  char machine[TSIG_PLAN_MACHINE_SIZE] = {0};
+  char key[TSIG_PLAN_LINE_SIZE];
+  tsig_audio_kernel_t kernel;
+  tsig_log_t log;
+
+  unlink(test_plan_path);
+
+  kernel = tsig_plan(TSIG_AUDIO_FORMAT_S16_LE, 2, "", &log);
+  assert_int_not_equal(kernel, TSIG_AUDIO_KERNEL_UNKNOWN);
+  assert_int_equal(test_plan_lines(), 0);
+
+  /* A measured choice is remembered. */
+  kernel = tsig_plan(TSIG_AUDIO_FORMAT_S16_LE, 2, test_plan_path, &log);
+  assert_int_not_equal(kernel, TSIG_AUDIO_KERNEL_UNKNOWN);
+  assert_int_equal(test_plan_lines(), 1);
+
+  /* A remembered choice is used without measuring. */
+  plan_machine(machine);
+  snprintf(key, sizeof(key), "%s %s S16_LE 2", machine, plan_sample_type);
+  plan_wisdom_add(test_plan_path, key, TSIG_AUDIO_KERNEL_GENERIC, &log);
+
+  kernel = tsig_plan(TSIG_AUDIO_FORMAT_S16_LE, 2, test_plan_path, &log);
+  assert_int_equal(kernel, TSIG_AUDIO_KERNEL_GENERIC);
+  assert_int_equal(test_plan_lines(), 2);
+
+  /* Other streams are measured separately. */
+  tsig_plan(TSIG_AUDIO_FORMAT_S16_LE, 1, test_plan_path, &log);
+  assert_int_equal(test_plan_lines(), 3);
+
+  unlink(test_plan_path);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_plan_machine),
+      cmocka_unit_test(test_plan_wisdom),
+      cmocka_unit_test(test_plan_time),
+      cmocka_unit_test(test_tsig_plan),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
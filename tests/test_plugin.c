@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_plugin.c: Test output sink plugin facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "plugin.c"
+
+#include "mock_log.c"
+
+#include "audio.c"
+#include "coherent.c"
+#include "jitter.c"
+#include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
+#include "util.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+/** Test sink state. */
+static uint8_t test_sink_buf[4096];
+static uint32_t test_sink_blocks;
+static uint32_t test_sink_closed;
+static uint32_t test_sink_period_size;
+static int test_sink_get_err;
+static uint32_t test_sink_get_eintr;
+static int test_sink_put_err;
+
+/** Test station, of which only the timing is used. */
+static tsig_station_t test_station = {
+    .rate = 48000,
+    .timestamp = 1748779200000, /* 2025-06-01 12:00:00 UTC */
+};
+
+static int test_sink_open(void **out_sink_data, tsig_sink_params_t *params) {
+  *out_sink_data = test_sink_buf;
+  params->period_size = test_sink_period_size;
+  return 0;
+}
+
+static int test_sink_get_block(void *sink_data, tsig_sink_block_t *block) {
+  block->buf = sink_data;
+
+  /* A signal not stopping the loop, e.g. SIGUSR2, interrupts the sink. */
+  if (test_sink_get_eintr) {
+    test_sink_get_eintr--;
+    return -EINTR;
+  }
+
+  return test_sink_get_err;
+}
+
+static int test_sink_put_block(void *sink_data, const tsig_sink_block_t *block,
+                               tsig_sink_anchor_t *out_anchor) {
+  assert_int_equal(out_anchor->timestamp, 0);
+  assert_int_equal(block->frame, test_sink_blocks * block->size);
+  assert_true(block->timestamp > 0);
+  assert_int_equal(block->station_time,
+                   test_station.timestamp * 1000000 +
+                       block->frame * 1000000000 / test_station.rate);
+
+  /* Frames are converted straight into memory the sink lent. */
+  if (sink_data)
+    assert_true(block->buf == sink_data);
+
+  if (test_sink_put_err)
+    return test_sink_put_err;
+
+  /* The whole block is still queued when put_block() returns. */
+  *out_anchor = (tsig_sink_anchor_t){
+      .timestamp = block->timestamp,
+      .delay = block->size,
+  };
+
+  if (++test_sink_blocks == 3)
+    raise(SIGALRM);
+
+  return 0;
+}
+
+static void test_sink_close(void *sink_data) {
+  (void)sink_data; /* Suppress unused parameter warning. */
+
+  test_sink_closed++;
+}
+
+static const tsig_sink_t test_sink = {
+    .abi_version = TSIG_SINK_ABI_VERSION,
+    .size = sizeof(tsig_sink_t),
+    .name = "test",
+    .open = test_sink_open,
+    .get_block = test_sink_get_block,
+    .put_block = test_sink_put_block,
+    .close = test_sink_close,
+};
+
+/** Generate full-scale samples. */
+static void test_plugin_cb(void *cb_data, tsig_audio_sample_t out_cb_buf[],
+                           uint32_t size) {
+  tsig_jitter_t *jitter = cb_data;
+
+  for (uint32_t i = 0; i < size; i++)
+    out_cb_buf[i] = 1.0;
+
+  test_station.samples += size;
+
+  if (jitter)
+    tsig_jitter_advance(jitter, size);
+}
+
+static void test_plugin_check_sink(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_plugin_t plugin = {.path = "test.so"};
+  tsig_sink_t sink = test_sink;
+  tsig_log_t log;
+
+  plugin.log = &log;
+
+  assert_int_equal(plugin_check_sink(&plugin, &sink), 0);
+  assert_int_equal(plugin_check_sink(&plugin, NULL), -EINVAL);
+
+  sink.abi_version = TSIG_SINK_ABI_VERSION + 1;
+  assert_int_equal(plugin_check_sink(&plugin, &sink), -EINVAL);
+
+  sink = test_sink;
+  sink.size = offsetof(tsig_sink_t, close);
+  assert_int_equal(plugin_check_sink(&plugin, &sink), -EINVAL);
+
+  /* Only get_block() is optional. */
+  sink = test_sink;
+  sink.get_block = NULL;
+  assert_int_equal(plugin_check_sink(&plugin, &sink), 0);
+  sink.put_block = NULL;
+  assert_int_equal(plugin_check_sink(&plugin, &sink), -EINVAL);
+}
+
+static void test_plugin_open(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_plugin_t plugin = {.path = "test.so"};
+  tsig_cfg_t cfg = {
+      .format = TSIG_AUDIO_FORMAT_S24_3LE,
+      .rate = 48000,
+      .channels = 2,
+  };
+  tsig_log_t log;
+
+  plugin.log = &log;
+
+  test_sink_closed = 0;
+  test_sink_period_size = 480;
+  assert_int_equal(plugin_open(&plugin, &test_sink, &cfg), 0);
+  assert_true(plugin.sink == &test_sink);
+  assert_true(plugin.sink_data == test_sink_buf);
+  assert_int_equal(plugin.params.abi_version, TSIG_SINK_ABI_VERSION);
+  assert_string_equal(plugin.params.format, "S24_3LE");
+  assert_int_equal(plugin.params.phys_width, 3);
+  assert_int_equal(plugin.params.rate, 48000);
+  assert_int_equal(plugin.params.channels, 2);
+  assert_int_equal(plugin.params.period_size, 480);
+  assert_int_equal(plugin.stride, 6);
+
+  /* A sink asking for a nonsensical period is closed again. */
+  test_sink_period_size = 0;
+  assert_int_equal(plugin_open(&plugin, &test_sink, &cfg), -EINVAL);
+  assert_int_equal(test_sink_closed, 1);
+}
+
+static void test_tsig_plugin_loop(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static tsig_jitter_t jitter;
+  tsig_plugin_t plugin = {.path = "test.so"};
+  tsig_cfg_t cfg = {
+      .format = TSIG_AUDIO_FORMAT_S16_LE,
+      .rate = 48000,
+      .channels = 1,
+  };
+  tsig_log_t log = {0};
+
+  plugin.log = &log;
+  test_sink_period_size = 480;
+  assert_int_equal(plugin_open(&plugin, &test_sink, &cfg), 0);
+
+  tsig_jitter_init(&jitter, cfg.rate, &log);
+  tsig_jitter_edge(&jitter, 0, 1000);
+  plugin.jitter = &jitter;
+  plugin.station = &test_station;
+
+  /* Blocks are lent by the sink until a signal stops the loop. */
+  test_station.samples = 0;
+  test_sink_blocks = 0;
+  test_sink_get_err = 0;
+  test_sink_get_eintr = 2;
+  test_sink_put_err = 0;
+  memset(test_sink_buf, 0, sizeof(test_sink_buf));
+
+  assert_int_equal(tsig_plugin_loop(&plugin, test_plugin_cb, &jitter),
+                   SIGALRM);
+  assert_int_equal(test_sink_blocks, 3);
+  assert_int_equal(test_sink_get_eintr, 0);
+  assert_int_equal(test_sink_buf[0], 0xff);
+  assert_int_equal(test_sink_buf[1], 0x7f);
+  assert_int_equal(test_sink_buf[959], 0x7f);
+  assert_int_equal(jitter.frames, 1440);
+
+  /* Anchors resolve pending edges. */
+  assert_int_equal(jitter.edge_count, 0);
+  assert_int_equal(jitter.count, 1);
+
+  /* Sinks that lend nothing are handed a buffer, and errors end the loop. */
+  plugin.sink_data = NULL;
+  plugin.sink = &(tsig_sink_t){
+      .put_block = test_sink_put_block,
+  };
+  plugin.jitter = NULL;
+  test_station.samples = 0;
+  test_sink_blocks = 0;
+  test_sink_put_err = -EIO;
+
+  assert_int_equal(tsig_plugin_loop(&plugin, test_plugin_cb, NULL), -EIO);
+  assert_int_equal(test_sink_blocks, 0);
+
+  /* So do errors lending a block. */
+  plugin.sink = &test_sink;
+  test_sink_get_err = -EIO;
+
+  assert_int_equal(tsig_plugin_loop(&plugin, test_plugin_cb, NULL), -EIO);
+  assert_int_equal(test_sink_blocks, 0);
+  test_sink_get_err = 0;
+}
+
+static void test_tsig_plugin_init(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_cfg_t cfg = {.plugin = "./nonexistent_sink.so"};
+  tsig_plugin_t plugin;
+  tsig_log_t log;
+
+  assert_int_equal(tsig_plugin_lib_init(&log), 0);
+  assert_int_equal(tsig_plugin_init(&plugin, &cfg, &log), -EINVAL);
+  assert_null(plugin.lib);
+  assert_int_equal(tsig_plugin_lib_deinit(&log), 0);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_plugin_check_sink),
+      cmocka_unit_test(test_plugin_open),
+      cmocka_unit_test(test_tsig_plugin_loop),
+      cmocka_unit_test(test_tsig_plugin_init),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_profile.c: Test pipeline stage profiling facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "profile.c"
+
+#include "mock_log.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+/** Burn some CPU time. */
+static void test_profile_work(void) {
+  volatile uint64_t x = 0;
+
+  for (uint32_t i = 0; i < 1000000; i++)
+    x += i;
+}
+
+static void test_tsig_profile_end(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_profile_stat_t *stat;
+  tsig_profile_t profile;
+  tsig_log_t log;
+
+  tsig_profile_init(&profile, &log);
+  stat = &profile.stats[TSIG_PROFILE_SAMPLES];
+
+  /* Whatever counters are available are opened upon first use. */
+  for (int i = 0; i < 2; i++) {
+    tsig_profile_begin(&profile, TSIG_PROFILE_SAMPLES);
+    test_profile_work();
+    tsig_profile_end(&profile, TSIG_PROFILE_SAMPLES, 480);
+  }
+
+  assert_int_not_equal(profile.mode, TSIG_PROFILE_MODE_NONE);
+  assert_true(profile.counters >= 1);
+  assert_int_equal(stat->calls, 2);
+  assert_int_equal(stat->frames, 960);
+  assert_true(stat->counts[TSIG_PROFILE_TASK_CLOCK] > 0);
+
+  if (profile.mode == TSIG_PROFILE_MODE_HARDWARE)
+    assert_true(stat->counts[TSIG_PROFILE_INSTRUCTIONS] > 1000000);
+
+  /* Stages that process no frames are still counted. */
+  tsig_profile_begin(&profile, TSIG_PROFILE_UPDATE);
+  tsig_profile_end(&profile, TSIG_PROFILE_UPDATE, 0);
+  assert_int_equal(profile.stats[TSIG_PROFILE_UPDATE].calls, 1);
+  assert_int_equal(profile.stats[TSIG_PROFILE_UPDATE].frames, 0);
+
+  /* Unmatched ends are ignored. */
+  tsig_profile_end(&profile, TSIG_PROFILE_SAMPLES, 480);
+  assert_int_equal(stat->calls, 2);
+  tsig_profile_end(&profile, TSIG_PROFILE_WRITE, 480);
+  assert_int_equal(profile.stats[TSIG_PROFILE_WRITE].calls, 0);
+
+  tsig_profile_print(&profile);
+  tsig_profile_deinit(&profile);
+  assert_int_equal(profile.mode, TSIG_PROFILE_MODE_NONE);
+  assert_int_equal(profile.counters, 0);
+}
+
+static void test_tsig_profile_end_cputime(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_profile_stat_t *stat;
+  tsig_profile_t profile;
+  tsig_log_t log;
+
+  /* Pretend perf_event_open() isn't allowed. */
+  tsig_profile_init(&profile, &log);
+  profile.mode = TSIG_PROFILE_MODE_CPUTIME;
+  profile.counters = 1;
+  stat = &profile.stats[TSIG_PROFILE_FILL];
+
+  tsig_profile_begin(&profile, TSIG_PROFILE_FILL);
+  test_profile_work();
+  tsig_profile_end(&profile, TSIG_PROFILE_FILL, 480);
+
+  assert_int_equal(stat->calls, 1);
+  assert_int_equal(stat->frames, 480);
+  assert_true(stat->counts[TSIG_PROFILE_TASK_CLOCK] > 0);
+  assert_int_equal(stat->counts[TSIG_PROFILE_CYCLES], 0);
+
+  tsig_profile_print(&profile);
+  tsig_profile_deinit(&profile);
+  assert_int_equal(profile.counters, 0);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_tsig_profile_end),
+      cmocka_unit_test(test_tsig_profile_end_cputime),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_recorder.c: Test flight recorder facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "recorder.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cmocka.h>
+
+static const char *test_recorder_path = "test_recorder.txt";
+
+/** Read a dump file into a buffer. */
+static void test_recorder_read(char buf[], size_t size) {
+  FILE *file;
+  size_t len;
+
+  file = fopen(test_recorder_path, "r");
+  assert_non_null(file);
+  len = fread(buf, 1, size - 1, file);
+  buf[len] = '\0';
+  fclose(file);
+}
+
+/** Reset the flight recorder. */
+static void test_recorder_reset(void) {
+  memset(recorder_events, 0, sizeof(recorder_events));
+  atomic_store(&recorder_head, 0);
+  recorder_dumps = 0;
+  unlink(test_recorder_path);
+}
+
+static void test_recorder_put_time(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  char buf[TSIG_RECORDER_LINE_SIZE];
+  size_t len;
+
+  len = recorder_put_time(buf, 1234000000056);
+  assert_int_equal(len, 14);
+  assert_memory_equal(buf, "1234.000000056", len);
+
+  len = recorder_put_int(buf, INT64_MIN, 0);
+  assert_int_equal(len, 20);
+  assert_memory_equal(buf, "-9223372036854775808", len);
+
+  len = recorder_put_event(buf, &(recorder_event_t){
+                                    .time = 3000000000,
+                                    .a = 480,
+                                    .b = 2000000000,
+                                    .type = TSIG_RECORDER_CB,
+                                });
+  assert_memory_equal(buf, "3.000000000 cb     480 1000000000\n", len);
+}
+
+static void test_tsig_recorder_dump(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  char buf[4096];
+  int64_t start;
+
+  test_recorder_reset();
+
+  /* Without a dump file, events are recorded but never dumped. */
+  tsig_recorder_init("");
+  tsig_recorder_event(TSIG_RECORDER_XRUN, -EPIPE, 0);
+  tsig_recorder_dump("xrun");
+  assert_int_equal(access(test_recorder_path, F_OK), -1);
+  assert_int_equal(recorder_dumps, 0);
+
+  tsig_recorder_init(test_recorder_path);
+
+  /* Events too old to matter are left out. */
+  recorder_events[0].time -= (recorder_dump_secs + 1) * recorder_nsecs_sec;
+
+  start = tsig_recorder_event(TSIG_RECORDER_CLOCK, 1000, -3);
+  tsig_recorder_event(TSIG_RECORDER_CB, 480, start);
+  tsig_recorder_dump("test");
+
+  test_recorder_read(buf, sizeof(buf));
+  assert_true(!strncmp(buf, "# Flight recorder dump (test) at ", 33));
+  assert_null(strstr(buf, "xrun"));
+  assert_non_null(strstr(buf, " clock  1000 -3\n"));
+  assert_non_null(strstr(buf, " cb     480 "));
+  assert_true(strstr(buf, " clock ") < strstr(buf, " cb "));
+
+  /* SIGUSR2 dumps, and dumps append. */
+  raise(SIGUSR2);
+  test_recorder_read(buf, sizeof(buf));
+  assert_non_null(strstr(buf, "# Flight recorder dump (SIGUSR2) at "));
+  assert_non_null(strstr(buf, " signal 12 0\n"));
+  assert_int_equal(recorder_dumps, 2);
+
+  /* Dumps are limited per run. */
+  recorder_dumps = TSIG_RECORDER_DUMPS_MAX;
+  unlink(test_recorder_path);
+  tsig_recorder_dump("test");
+  assert_int_equal(access(test_recorder_path, F_OK), -1);
+
+  tsig_recorder_deinit();
+}
+
+static void test_tsig_recorder_event_wrap(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  static char buf[TSIG_RECORDER_EVENTS * 48];
+  const char *p;
+  int64_t a = 0;
+  int count = 0;
+
+  test_recorder_reset();
+  tsig_recorder_init(test_recorder_path);
+
+  for (int i = 0; i < 3 * TSIG_RECORDER_EVENTS / 2; i++)
+    tsig_recorder_event(TSIG_RECORDER_WRITE, i, 0);
+
+  tsig_recorder_dump("test");
+  tsig_recorder_deinit();
+
+  /* Only the newest events are kept, oldest first. */
+  test_recorder_read(buf, sizeof(buf));
+  for (p = strstr(buf, " write  "); p; p = strstr(p, " write  ")) {
+    p += 8;
+    if (!count)
+      a = strtoll(p, NULL, 10);
+    assert_int_equal(strtoll(p, NULL, 10), a + count);
+    count++;
+  }
+
+  assert_int_equal(count, TSIG_RECORDER_EVENTS);
+  assert_int_equal(a, TSIG_RECORDER_EVENTS / 2);
+
+  unlink(test_recorder_path);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_recorder_put_time),
+      cmocka_unit_test(test_tsig_recorder_dump),
+      cmocka_unit_test(test_tsig_recorder_event_wrap),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
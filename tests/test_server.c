@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_server.c: Test minute-frame server facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "server.c"
+
+#include "mock_log.c"
+
+#include "archive.c"
+#include "coherent.c"
+#include "datetime.c"
+#include "governor.c"
+#include "iir.c"
+#include "jitter.c"
+#include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
+#include "station.c"
+#include "util.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmocka.h>
+
+static void test_tsig_server_pack(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  uint8_t record[TSIG_SERVER_RECORD_SIZE];
+  tsig_station_frame_t frame = {
+      .station = TSIG_STATION_ID_MSF,
+      .flags = TSIG_STATION_FLAG_DST,
+      .dut1 = -300,
+      .freq = 60000,
+      .xmit_low = 0,
+      .utc_timestamp = 0x0102030405060708,
+      .timestamp = 0x1112131415161718,
+      .xmit_level = {[0] = 0xaa, [149] = 0x55},
+  };
+  const uint8_t header[32] = {
+      /* clang-format off */
+      'T', 'S', 'F', 'R', 0x01, 0x04, 0x01, 0x00,
+      0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,
+      0x18, 0x17, 0x16, 0x15, 0x14, 0x13, 0x12, 0x11,
+      0x60, 0xea, 0x00, 0x00, 0xd4, 0xfe, 0x00, 0x00,
+      /* clang-format on */
+  };
+  uint16_t crc;
+
+  tsig_server_pack(record, &frame);
+  assert_memory_equal(record, header, sizeof(header));
+  assert_memory_equal(&record[32], frame.xmit_level, sizeof(frame.xmit_level));
+
+  crc = tsig_util_crc16(record, 182);
+  assert_int_equal(record[182], crc & 0xff);
+  assert_int_equal(record[183], crc >> 8);
+}
+
+static void test_tsig_server_init(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_server_t server;
+  tsig_cfg_t cfg = {.serve = {"test_server.sock"}};
+  tsig_log_t log;
+  struct stat st;
+
+  assert_int_equal(tsig_server_init(&server, &cfg, &log), 0);
+  assert_true(server.listen_fd >= 0);
+  assert_int_equal(server.pty_fd, -1);
+  assert_string_equal(server.path, "test_server.sock");
+  assert_int_equal(lstat("test_server.sock", &st), 0);
+  assert_true(S_ISSOCK(st.st_mode));
+
+  tsig_server_deinit(&server);
+  assert_int_equal(server.listen_fd, -1);
+  assert_int_not_equal(lstat("test_server.sock", &st), 0);
+
+  cfg = (tsig_cfg_t){.serve = {TSIG_SERVER_PTY}};
+  assert_int_equal(tsig_server_init(&server, &cfg, &log), 0);
+  assert_int_equal(server.listen_fd, -1);
+  assert_true(server.pty_fd >= 0);
+  assert_memory_equal(server.path, "/dev/pts/", 9);
+
+  tsig_server_deinit(&server);
+  assert_int_equal(server.pty_fd, -1);
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_tsig_server_pack),
+      cmocka_unit_test(test_tsig_server_init),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -11,26 +11,62 @@
 
 #include "mock_log.c"
 
+#include "archive.c"
+#include "coherent.c"
 #include "datetime.c"
+#include "governor.c"
 #include "iir.c"
+#include "jitter.c"
 #include "mapping.c"
+#include "profile.c"
+#include "recorder.c"
 #include "util.c"
 
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include <cmocka.h>
 
+/** Allowed difference between generated samples that should be equal. */
+#ifdef TSIG_USE_FIXED_POINT
+static const tsig_audio_sample_t test_station_epsilon = 1;
+#else
+static const tsig_audio_sample_t test_station_epsilon = 0.000001;
+#endif /* TSIG_USE_FIXED_POINT */
+
+/** Check generated samples against double-precision reference values. */
+static void test_station_check_samples(const tsig_audio_sample_t *buf,
+                                       const double *ref, size_t len) {
+#ifdef TSIG_USE_FIXED_POINT
+  /* Q15 generation stays within 1 LSB of the double-precision path. */
+  for (size_t i = 0; i < len; i++) {
+    double diff = buf[i] - ref[i] * station_gain_one;
+    assert_true(-1.0 <= diff && diff <= 1.0);
+  }
+#else
+  assert_memory_equal(buf, ref, sizeof(*buf) * len);
+#endif /* TSIG_USE_FIXED_POINT */
+}
+
 static void test_station_lerp(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
+#ifdef TSIG_USE_FIXED_POINT
+  assert_int_equal(station_lerp(32768, 0), 492);
+  assert_int_equal(station_lerp(32768, 32637), 32768);
+  assert_int_equal(station_lerp(32768, 32768), 32768);
+  assert_int_equal(station_lerp(0, 32768), 32768 - 492);
+#else
   double epsilon = 0.000001;
 
   assert_double_equal(station_lerp(1.0, 0.0), 0.015, epsilon);
   assert_double_equal(station_lerp(1.0, 0.996), 1.0, epsilon);
   assert_double_equal(station_lerp(1.0, 1.0), 1.0, epsilon);
+#endif /* TSIG_USE_FIXED_POINT */
 }
 
 static void test_station_even_parity(void **state) {
@@ -43,6 +79,7 @@ static void test_station_even_parity(void **state) {
   assert_int_equal(station_even_parity(data, 2, 3), 0);
 }
 
+#ifdef TSIG_HAVE_MSF
 static void test_station_odd_parity(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -52,7 +89,9 @@ static void test_station_odd_parity(void **state) {
   assert_int_equal(station_odd_parity(data, 1, 3), 1);
   assert_int_equal(station_odd_parity(data, 2, 3), 1);
 }
+#endif /* TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_BPC
 static void test_station_update_bpc(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -85,7 +124,9 @@ static void test_station_update_bpc(void **state) {
   assert_string_equal(bpc.xmit, xmit);
   assert_string_equal(bpc.meaning, meaning);
 }
+#endif /* TSIG_HAVE_BPC */
 
+#ifdef TSIG_HAVE_DCF77
 static void test_station_update_dcf77(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -120,6 +161,7 @@ static void test_station_update_dcf77(void **state) {
   assert_string_equal(dcf77.xmit, xmit);
   assert_string_equal(dcf77.meaning, meaning);
 }
+#endif /* TSIG_HAVE_DCF77 */
 
 static void test_station_update_jjy(void **state) {
   (void)state; /* Suppress unused parameter warning. */
@@ -187,6 +229,7 @@ static void test_station_update_jjy(void **state) {
   assert_string_equal(jjy.meaning, meaning_morse);
 }
 
+#ifdef TSIG_HAVE_MSF
 static void test_station_update_msf(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -221,7 +264,9 @@ static void test_station_update_msf(void **state) {
   assert_string_equal(msf.xmit, xmit);
   assert_string_equal(msf.meaning, meaning);
 }
+#endif /* TSIG_HAVE_MSF */
 
+#ifdef TSIG_HAVE_WWVB
 static void test_station_update_wwvb(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -256,6 +301,7 @@ static void test_station_update_wwvb(void **state) {
   assert_string_equal(wwvb.xmit, xmit);
   assert_string_equal(wwvb.meaning, meaning);
 }
+#endif /* TSIG_HAVE_WWVB */
 
 static void test_station_status_write_xmit_readout(void **state) {
   (void)state; /* Suppress unused parameter warning. */
@@ -287,13 +333,236 @@ static void test_tsig_station_cb(void **state) {
       -8.66025403784438374544e-01,
       9.99999999999999777955e-01,
   };
-  double cb_buf[8] = {0.0};
+  tsig_audio_sample_t cb_buf[8] = {0};
+
+  tsig_station_init(&station, &cfg, &log);
+  tsig_station_cb((void *)&station, cb_buf, 4);
+  test_station_check_samples(cb_buf, ref, 8);
+}
+
+static void test_tsig_station_cb_governor(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_station_t station;
+  tsig_station_t ref_station;
+  tsig_governor_t governor;
+  tsig_cfg_t cfg = {
+      .station = TSIG_STATION_ID_JJY60,
+      .base = 0,
+      .rate = TSIG_AUDIO_RATE_48000,
+  };
+  tsig_log_t log;
+  tsig_audio_sample_t square[4] = {
+      station_gain_one,
+      -station_gain_one,
+      station_gain_one,
+      -station_gain_one,
+  };
+  tsig_audio_sample_t ref[12] = {0};
+  tsig_audio_sample_t cb_buf[4] = {0};
+
+  tsig_station_init(&ref_station, &cfg, &log);
+  tsig_station_cb((void *)&ref_station, ref, 12);
 
   tsig_station_init(&station, &cfg, &log);
+  tsig_governor_init(&governor, station.rate, &log);
+  station.governor = &governor;
+
   tsig_station_cb((void *)&station, cb_buf, 4);
+  assert_int_equal(station.level, TSIG_GOVERNOR_FULL);
   assert_memory_equal(cb_buf, ref, sizeof(cb_buf));
+
+  /* Smoothing is off, so an xrun goes straight to the cached sine wave. */
+  tsig_governor_xrun(&governor);
+  station_govern(&station);
+  assert_int_equal(station.level, TSIG_GOVERNOR_CACHED);
+
+  tsig_station_cb((void *)&station, cb_buf, 4);
+  assert_memory_equal(cb_buf, &ref[4], sizeof(cb_buf));
+
+  tsig_governor_xrun(&governor);
+  station_govern(&station);
+  assert_int_equal(station.level, TSIG_GOVERNOR_SQUARE);
+
+  tsig_station_cb((void *)&station, cb_buf, 4);
+  assert_memory_equal(cb_buf, square, sizeof(cb_buf));
 }
 
+static void test_tsig_station_cb_freerun(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_station_t station;
+  tsig_cfg_t cfg = {
+      .station = TSIG_STATION_ID_JJY60,
+      .base = 0,
+      .rate = TSIG_AUDIO_RATE_48000,
+  };
+  tsig_log_t log;
+  tsig_audio_sample_t *cb_buf;
+  uint64_t timestamp;
+
+  cb_buf = malloc(sizeof(*cb_buf) * cfg.rate);
+  assert_non_null(cb_buf);
+
+  /* Generating faster than real time resyncs to the system clock... */
+  tsig_station_init(&station, &cfg, &log);
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  timestamp = station.timestamp;
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  assert_true(station.next_timestamp < timestamp + 3000);
+
+  /* ...unless the station keeps time by samples alone. */
+  tsig_station_init(&station, &cfg, &log);
+  station.is_freerun = true;
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  timestamp = station.timestamp;
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  tsig_station_cb((void *)&station, cb_buf, cfg.rate);
+  assert_int_equal(station.timestamp, timestamp);
+  assert_int_equal(station.next_timestamp, timestamp + 3000);
+
+  free(cb_buf);
+}
+
+static void test_tsig_station_cb_coherent(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  const int64_t base = 1748779200000; /* 2025-06-01 12:00:00 UTC */
+  const int64_t later = 1123;         /* Not on the 44.1 kHz sample grid. */
+  const uint32_t size = TSIG_AUDIO_RATE_44100 * 3;
+  tsig_station_t stations[2];
+  tsig_coherent_t coherents[2];
+  tsig_cfg_t cfg = {
+      .station = TSIG_STATION_ID_JJY60,
+      .rate = TSIG_AUDIO_RATE_44100,
+  };
+  tsig_log_t log;
+  tsig_audio_sample_t *bufs[2];
+  uint64_t lag;
+  uint64_t best = 0;
+  double best_ncc = 0.0;
+
+  /* Render two instances starting at different times. */
+  for (int i = 0; i < 2; i++) {
+    cfg.base = base + i * later;
+    tsig_station_init(&stations[i], &cfg, &log);
+    tsig_coherent_init(&coherents[i], cfg.rate, &log);
+    stations[i].coherent = &coherents[i];
+    stations[i].is_freerun = true;
+
+    bufs[i] = malloc(sizeof(*bufs[i]) * size);
+    assert_non_null(bufs[i]);
+
+    for (uint32_t j = 0; j < size; j += cfg.rate / 10)
+      tsig_station_cb((void *)&stations[i], &bufs[i][j], cfg.rate / 10);
+  }
+
+  /* Each sample is a function of its index since epoch. */
+  lag = (base + later) * cfg.rate / 1000 - base * cfg.rate / 1000;
+
+  for (uint64_t j = 0; j < size - lag; j++) {
+    assert_true(bufs[0][j + lag] - bufs[1][j] <= test_station_epsilon);
+    assert_true(bufs[1][j] - bufs[0][j + lag] <= test_station_epsilon);
+  }
+
+  /*
+   * Cross-correlating the outputs also recovers the difference. The energy
+   * of the second output is the same at each lag, so leave it out and
+   * compare squared correlations normalized by the energy of the first.
+   */
+  for (uint64_t k = lag - cfg.rate / 100; k <= lag + cfg.rate / 100; k++) {
+    double xy = 0.0;
+    double xx = 0.0;
+
+    for (uint64_t j = 0; j < size - lag - cfg.rate / 100; j++) {
+      xy += (double)bufs[0][j + k] * bufs[1][j];
+      xx += (double)bufs[0][j + k] * bufs[0][j + k];
+    }
+
+    if (xy > 0.0 && xy * xy / xx > best_ncc) {
+      best_ncc = xy * xy / xx;
+      best = k;
+    }
+  }
+
+  assert_int_equal(best, lag);
+
+  free(bufs[1]);
+  free(bufs[0]);
+}
+
+static void test_tsig_station_cb_coherent_slip(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  const uint32_t size = TSIG_AUDIO_RATE_48000 / 10;
+  const int64_t step = 5; /* Frames of latency added each callback. */
+  tsig_station_t station;
+  tsig_coherent_t coherent;
+  tsig_governor_t governor;
+  tsig_cfg_t cfg = {
+      .station = TSIG_STATION_ID_JJY60,
+      .base = 1748779200000, /* 2025-06-01 12:00:00 UTC */
+      .rate = TSIG_AUDIO_RATE_48000,
+  };
+  tsig_log_t log;
+  tsig_audio_sample_t *cb_buf;
+  struct timespec ts;
+  int64_t started;
+  uint64_t sample;
+  uint32_t calm;
+  int64_t slip;
+  int slips = 0;
+
+  cb_buf = malloc(sizeof(*cb_buf) * size);
+  assert_non_null(cb_buf);
+
+  tsig_station_init(&station, &cfg, &log);
+  tsig_coherent_init(&coherent, cfg.rate, &log);
+  tsig_governor_init(&governor, cfg.rate, &log);
+  station.coherent = &coherent;
+  station.governor = &governor;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  started = ts.tv_sec * station_nsecs_sec + ts.tv_nsec;
+
+  /* The first callback syncs to the sample grid. */
+  tsig_coherent_anchor(&coherent, started, 0);
+  tsig_station_cb((void *)&station, cb_buf, size);
+  tsig_coherent_advance(&coherent, size);
+  calm = governor.calm;
+
+  /* Output latency then grows, so the predicted sample runs ahead. */
+  for (int64_t i = 1; i <= 9; i++) {
+    tsig_coherent_anchor(&coherent,
+                         started + i * size * station_nsecs_sec / cfg.rate,
+                         i * step);
+    sample = station_coherent_sample(&station, station_coherent_time(&station));
+    slip = station_coherent_slip(&station, sample);
+
+    tsig_station_cb((void *)&station, cb_buf, size);
+    tsig_coherent_advance(&coherent, size);
+
+    /* A slip realigns to the predicted sample; otherwise nothing moves. */
+    if (slip * 1000000 > 250 * (int64_t)cfg.rate) {
+      assert_int_equal(station.timestamp * cfg.rate / 1000 + station.samples,
+                       sample + size);
+      slips++;
+    } else {
+      assert_int_equal(station_coherent_slip(&station, sample + size), slip);
+    }
+  }
+
+  /* 5, 10, then 15 frames ahead exceeds 250 us, i.e. 12 frames at 48 kHz. */
+  assert_int_equal(slips, 3);
+
+  /* Slips within a minute leave the minute and the governor alone. */
+  assert_int_equal(governor.calm, calm);
+
+  free(cb_buf);
+}
+
+#ifdef TSIG_HAVE_WWVB
 static void test_tsig_station_init(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
@@ -340,6 +609,40 @@ static void test_tsig_station_init(void **state) {
   assert_int_equal(station.freq, 20000);
   assert_false(station.verbose);
 }
+#endif /* TSIG_HAVE_WWVB */
+
+#ifdef TSIG_HAVE_DCF77
+static void test_tsig_station_encode(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_station_t dcf77 = {.station = TSIG_STATION_ID_DCF77, .dut1 = -100};
+  tsig_station_t ref = {.station = TSIG_STATION_ID_DCF77};
+  int64_t utc_timestamp = 4078429140000; /* 2099-03-29 01:59:00 CET */
+  uint8_t zeros[sizeof(dcf77.xmit_level)] = {0};
+  tsig_station_frame_t frame;
+  unsigned head = atomic_load(&recorder_head);
+
+  station_update_dcf77(&ref, utc_timestamp);
+
+  dcf77.base_offset = 1000;
+  tsig_station_encode(&dcf77, utc_timestamp + 12345, &frame);
+  assert_int_equal(frame.station, TSIG_STATION_ID_DCF77);
+  assert_int_equal(frame.flags,
+                   TSIG_STATION_FLAG_DST | TSIG_STATION_FLAG_DST_CHANGE);
+  assert_int_equal(frame.dut1, -100);
+  assert_int_equal(frame.freq, 77500);
+  assert_int_equal(frame.xmit_low, 4903);
+  assert_int_equal(frame.timestamp, utc_timestamp);
+  assert_int_equal(frame.utc_timestamp, utc_timestamp - 1000);
+  assert_memory_equal(frame.xmit_level, ref.xmit_level,
+                      sizeof(frame.xmit_level));
+
+  /* The context itself is left alone, and no minute update is recorded. */
+  assert_memory_equal(dcf77.xmit_level, zeros, sizeof(dcf77.xmit_level));
+  assert_int_equal(dcf77.flags, 0);
+  assert_int_equal(atomic_load(&recorder_head), head);
+}
+#endif /* TSIG_HAVE_DCF77 */
 
 static void test_tsig_station_set_rate(void **state) {
   (void)state; /* Suppress unused parameter warning. */
@@ -356,20 +659,45 @@ static void test_tsig_station_set_rate(void **state) {
 static void test_tsig_station_id(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
+  /* Stations left out of a single-station build are unknown. */
+#ifdef TSIG_HAVE_BPC
   assert_int_equal(tsig_station_id("BPC"), TSIG_STATION_ID_BPC);
   assert_int_equal(tsig_station_id("BpC"), TSIG_STATION_ID_BPC);
+#else
+  assert_int_equal(tsig_station_id("BPC"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_BPC */
+#ifdef TSIG_HAVE_DCF77
   assert_int_equal(tsig_station_id("DCF77"), TSIG_STATION_ID_DCF77);
   assert_int_equal(tsig_station_id("DcF77"), TSIG_STATION_ID_DCF77);
+#else
+  assert_int_equal(tsig_station_id("DCF77"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_DCF77 */
+#ifdef TSIG_HAVE_JJY
   assert_int_equal(tsig_station_id("JJY"), TSIG_STATION_ID_JJY);
   assert_int_equal(tsig_station_id("JjY"), TSIG_STATION_ID_JJY);
   assert_int_equal(tsig_station_id("JJY40"), TSIG_STATION_ID_JJY);
   assert_int_equal(tsig_station_id("JjY40"), TSIG_STATION_ID_JJY);
+#else
+  assert_int_equal(tsig_station_id("JJY"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_JJY */
+#ifdef TSIG_HAVE_JJY60
   assert_int_equal(tsig_station_id("JJY60"), TSIG_STATION_ID_JJY60);
   assert_int_equal(tsig_station_id("JjY60"), TSIG_STATION_ID_JJY60);
+#else
+  assert_int_equal(tsig_station_id("JJY60"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_JJY60 */
+#ifdef TSIG_HAVE_MSF
   assert_int_equal(tsig_station_id("MSF"), TSIG_STATION_ID_MSF);
   assert_int_equal(tsig_station_id("MsF"), TSIG_STATION_ID_MSF);
+#else
+  assert_int_equal(tsig_station_id("MSF"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_WWVB
   assert_int_equal(tsig_station_id("WwVb"), TSIG_STATION_ID_WWVB);
   assert_int_equal(tsig_station_id("WwVb"), TSIG_STATION_ID_WWVB);
+#else
+  assert_int_equal(tsig_station_id("WWVB"), TSIG_STATION_ID_UNKNOWN);
+#endif /* TSIG_HAVE_WWVB */
   assert_int_equal(tsig_station_id("invalid"), TSIG_STATION_ID_UNKNOWN);
   assert_int_equal(tsig_station_id(""), TSIG_STATION_ID_UNKNOWN);
 }
@@ -377,27 +705,58 @@ static void test_tsig_station_id(void **state) {
 static void test_tsig_station_name(void **state) {
   (void)state; /* Suppress unused parameter warning. */
 
+#ifdef TSIG_HAVE_BPC
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_BPC), "BPC");
+#endif /* TSIG_HAVE_BPC */
+#ifdef TSIG_HAVE_DCF77
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_DCF77), "DCF77");
+#endif /* TSIG_HAVE_DCF77 */
+#ifdef TSIG_HAVE_JJY
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_JJY), "JJY");
+#endif /* TSIG_HAVE_JJY */
+#ifdef TSIG_HAVE_JJY60
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_JJY60), "JJY60");
+#endif /* TSIG_HAVE_JJY60 */
+#ifdef TSIG_HAVE_MSF
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_MSF), "MSF");
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_WWVB
   assert_string_equal(tsig_station_name(TSIG_STATION_ID_WWVB), "WWVB");
+#endif /* TSIG_HAVE_WWVB */
 }
 
 int main(void) {
   const struct CMUnitTest tests[] = {
       cmocka_unit_test(test_station_lerp),
       cmocka_unit_test(test_station_even_parity),
+#ifdef TSIG_HAVE_MSF
       cmocka_unit_test(test_station_odd_parity),
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_BPC
       cmocka_unit_test(test_station_update_bpc),
+#endif /* TSIG_HAVE_BPC */
+#ifdef TSIG_HAVE_DCF77
       cmocka_unit_test(test_station_update_dcf77),
+#endif /* TSIG_HAVE_DCF77 */
       cmocka_unit_test(test_station_update_jjy),
+#ifdef TSIG_HAVE_MSF
       cmocka_unit_test(test_station_update_msf),
+#endif /* TSIG_HAVE_MSF */
+#ifdef TSIG_HAVE_WWVB
       cmocka_unit_test(test_station_update_wwvb),
+#endif /* TSIG_HAVE_WWVB */
       cmocka_unit_test(test_station_status_write_xmit_readout),
       cmocka_unit_test(test_tsig_station_cb),
+      cmocka_unit_test(test_tsig_station_cb_governor),
+      cmocka_unit_test(test_tsig_station_cb_freerun),
+      cmocka_unit_test(test_tsig_station_cb_coherent),
+      cmocka_unit_test(test_tsig_station_cb_coherent_slip),
+#ifdef TSIG_HAVE_WWVB
       cmocka_unit_test(test_tsig_station_init),
+#endif /* TSIG_HAVE_WWVB */
+#ifdef TSIG_HAVE_DCF77
+      cmocka_unit_test(test_tsig_station_encode),
+#endif /* TSIG_HAVE_DCF77 */
       cmocka_unit_test(test_tsig_station_set_rate),
       cmocka_unit_test(test_tsig_station_id),
       cmocka_unit_test(test_tsig_station_name),
@@ -49,10 +49,22 @@ static void test_tsig_util_strcasecmp(void **state) {
   assert_int_equal(rv, -1);
 }
 
+static void test_tsig_util_crc16(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  const uint8_t check[] = "123456789";
+
+  assert_int_equal(tsig_util_crc16(check, sizeof(check) - 1), 0x29b1);
+  assert_int_equal(tsig_util_crc16(check, 0), 0xffff);
+  assert_int_equal(
+      tsig_util_crc16_update(tsig_util_crc16(check, 4), &check[4], 5), 0x29b1);
+}
+
 int main(void) {
   const struct CMUnitTest tests[] = {
       cmocka_unit_test(test_tsig_util_getprogname),
       cmocka_unit_test(test_tsig_util_strcasecmp),
+      cmocka_unit_test(test_tsig_util_crc16),
   };
 
   return cmocka_run_group_tests(tests, NULL, NULL);
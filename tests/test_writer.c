@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/**
+ * test_writer.c: Test asynchronous file writing facilities.
+ *
+ * This file is part of timesignal.
+ *
+ * Copyright © 2025 James Seo <james@equiv.tech>
+ */
+
+#include "writer.c"
+
+#include "mock_log.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <cmocka.h>
+
+static const char *test_writer_path = "test_writer.bin";
+
+/** Size of test data, several buffers and an unaligned tail. */
+static const size_t test_writer_size = 3 * TSIG_WRITER_BUF_SIZE + 12345;
+
+/** Size of each write, not dividing a buffer evenly. */
+static const size_t test_writer_chunk = 4800 * 3;
+
+/** Byte of test data at an offset. */
+static uint8_t test_writer_byte(size_t offset) {
+  return (offset * 7 + offset / 251) & 0xff;
+}
+
+/** Write test data in chunks. */
+static void test_writer_write(tsig_writer_t *writer) {
+  uint8_t chunk[test_writer_chunk];
+  size_t offset = 0;
+  size_t len;
+
+  while (offset < test_writer_size) {
+    len = test_writer_size - offset;
+    if (len > sizeof(chunk))
+      len = sizeof(chunk);
+
+    for (size_t i = 0; i < len; i++)
+      chunk[i] = test_writer_byte(offset + i);
+
+    assert_int_equal(tsig_writer_write(writer, chunk, len), 0);
+    offset += len;
+  }
+}
+
+/** Check that the test file holds the test data. */
+static void test_writer_check(void) {
+  size_t offset = 0;
+  FILE *file;
+  int c;
+
+  file = fopen(test_writer_path, "rb");
+  assert_non_null(file);
+
+  while ((c = fgetc(file)) != EOF) {
+    assert_int_equal(c, test_writer_byte(offset));
+    offset++;
+  }
+
+  fclose(file);
+  unlink(test_writer_path);
+
+  assert_int_equal(offset, test_writer_size);
+}
+
+/** Generate test data directly into lent memory, in chunks. */
+static void test_writer_put(tsig_writer_t *writer) {
+  size_t offset = 0;
+  uint8_t *out;
+  size_t len;
+
+  while (offset < test_writer_size) {
+    out = tsig_writer_get_buf(writer, &len);
+    assert_true(len > 0);
+    assert_true(len <= TSIG_WRITER_BUF_SIZE);
+
+    if (len > test_writer_chunk)
+      len = test_writer_chunk;
+    if (len > test_writer_size - offset)
+      len = test_writer_size - offset;
+
+    for (size_t i = 0; i < len; i++)
+      out[i] = test_writer_byte(offset + i);
+
+    assert_int_equal(tsig_writer_put_buf(writer, len), 0);
+    offset += len;
+  }
+}
+
+static void test_tsig_writer_write(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_writer_t writer;
+  tsig_log_t log;
+
+  /* Either io_uring or a writer thread, depending on the system. */
+  assert_int_equal(tsig_writer_init(&writer, test_writer_path, false, &log), 0);
+  test_writer_write(&writer);
+  assert_int_equal(tsig_writer_deinit(&writer), 0);
+  test_writer_check();
+}
+
+static void test_tsig_writer_write_thread(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_writer_t writer;
+  tsig_log_t log;
+
+  assert_int_equal(tsig_writer_init(&writer, test_writer_path, false, &log), 0);
+
+  /* Fall back as though io_uring were unavailable. */
+  if (writer.mode == TSIG_WRITER_MODE_URING) {
+    writer_uring_deinit(&writer);
+    assert_int_equal(writer_thread_init(&writer), 0);
+    writer.mode = TSIG_WRITER_MODE_THREAD;
+  }
+
+  test_writer_write(&writer);
+  assert_int_equal(tsig_writer_deinit(&writer), 0);
+  test_writer_check();
+}
+
+static void test_tsig_writer_write_direct(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_writer_t writer;
+  tsig_log_t log;
+
+  /* The unaligned tail is written even if O_DIRECT is in effect. */
+  assert_int_equal(tsig_writer_init(&writer, test_writer_path, true, &log), 0);
+  test_writer_write(&writer);
+  assert_int_equal(tsig_writer_deinit(&writer), 0);
+  test_writer_check();
+}
+
+static void test_tsig_writer_put_buf(void **state) {
+  (void)state; /* Suppress unused parameter warning. */
+
+  tsig_writer_t writer;
+  tsig_log_t log;
+
+  /* Lent memory ends at a buffer boundary, so chunks are cut short there. */
+  assert_int_equal(tsig_writer_init(&writer, test_writer_path, false, &log), 0);
+  test_writer_put(&writer);
+  assert_int_equal(tsig_writer_deinit(&writer), 0);
+  test_writer_check();
+}
+
+int main(void) {
+  const struct CMUnitTest tests[] = {
+      cmocka_unit_test(test_tsig_writer_write),
+      cmocka_unit_test(test_tsig_writer_write_thread),
+      cmocka_unit_test(test_tsig_writer_write_direct),
+      cmocka_unit_test(test_tsig_writer_put_buf),
+  };
+
+  return cmocka_run_group_tests(tests, NULL, NULL);
+}